@@ -0,0 +1,180 @@
+#include "checkpoint.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "CycleTimer.h"
+
+// FNV-1a sobre os CSRs de saída: muda com qualquer aresta ou renumeração
+static uint64_t hash_graph(Graph G)
+{
+  uint64_t h = 1469598103934665603ull;
+  auto mix = [&h](const int* data, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+      h ^= (uint32_t) data[i];
+      h *= 1099511628211ull;
+    }
+  };
+  mix(G->outgoing_starts, G->num_nodes);
+  mix(G->outgoing_edges, G->num_edges);
+  if (G->outgoing_multiplicity) mix(G->outgoing_multiplicity, G->num_edges);
+  return h;
+}
+
+static std::string count_to_text(cycle_count_t c)
+{
+  if (cycle_count_overflowed(c)) return "overflow";
+  return cycle_count_str(c);
+}
+
+static bool text_to_count(const char* text, cycle_count_t& c)
+{
+  if (strcmp(text, "overflow") == 0) {
+    c = CYCLE_COUNT_MAX;
+    return true;
+  }
+  c = 0;
+  if (!*text) return false;
+  for (const char* p = text; *p; p++) {
+    if (*p < '0' || *p > '9') return false;
+    c = cycle_count_add(cycle_count_mul(c, 10), (cycle_count_t) (*p - '0'));
+  }
+  return true;
+}
+
+Checkpoint::Checkpoint(const std::string& path, Graph G, double interval)
+    : path(path), interval(interval), last_save(CycleTimer::currentSeconds()),
+      num_nodes(G->num_nodes), num_edges(G->num_edges), graph_hash(hash_graph(G)),
+      done_flags(G->num_nodes, 0)
+{
+}
+
+bool Checkpoint::resume(std::string& error)
+{
+  FILE* f = fopen(path.c_str(), "r");
+  if (!f) {
+    error = "cannot open " + path;
+    return false;
+  }
+
+  int version = 0, nodes = 0, edges = 0;
+  unsigned long long hash = 0, sink_value = 0;
+  long long ranges = 0;
+  char cycles_text[64] = {0};
+  bool ok = fscanf(f, "johnson-checkpoint %d\n", &version) == 1 && version == 1 &&
+            fscanf(f, "graph %d %d %llu\n", &nodes, &edges, &hash) == 3 &&
+            fscanf(f, "cycles %63s\n", cycles_text) == 1 &&
+            fscanf(f, "sink %llu\n", &sink_value) == 1 &&
+            fscanf(f, "ranges %lld\n", &ranges) == 1;
+  if (!ok) {
+    fclose(f);
+    error = path + " is not a checkpoint file";
+    return false;
+  }
+  if (nodes != num_nodes || edges != num_edges || hash != graph_hash) {
+    fclose(f);
+    error = path + " was written for a different graph";
+    return false;
+  }
+
+  std::vector<uint8_t> flags(num_nodes, 0);
+  int count = 0;
+  for (long long r = 0; r < ranges && ok; r++) {
+    int first, last;
+    ok = fscanf(f, "%d %d\n", &first, &last) == 2 && 0 <= first && first < last && last <= num_nodes;
+    for (int s = first; ok && s < last; s++) {
+      count += !flags[s];
+      flags[s] = 1;
+    }
+  }
+  cycle_count_t cycles;
+  ok = ok && text_to_count(cycles_text, cycles);
+  fclose(f);
+  if (!ok) {
+    error = path + " is truncated or corrupted";
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  done_flags.swap(flags);
+  completed_count = count;
+  total = loaded_cycles = cycles;
+  sink = loaded_sink = sink_value;
+  return true;
+}
+
+void Checkpoint::complete(int s, cycle_count_t cycles, uint64_t sink_cycles)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!done_flags[s]) completed_count++;
+  done_flags[s] = 1;
+  total = cycle_count_add(total, cycles);
+  sink += sink_cycles;
+  maybe_save_locked();
+}
+
+void Checkpoint::complete_all(const std::vector<int>& vertices, cycle_count_t cycles)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  for (int v : vertices) {
+    if (!done_flags[v]) completed_count++;
+    done_flags[v] = 1;
+  }
+  total = cycle_count_add(total, cycles);
+  maybe_save_locked();
+}
+
+cycle_count_t Checkpoint::cycles() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return total;
+}
+
+uint64_t Checkpoint::sink_cycles() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return sink;
+}
+
+int Checkpoint::completed() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return completed_count;
+}
+
+bool Checkpoint::save()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return save_locked();
+}
+
+void Checkpoint::maybe_save_locked()
+{
+  if (CycleTimer::currentSeconds() - last_save >= interval) save_locked();
+}
+
+bool Checkpoint::save_locked()
+{
+  last_save = CycleTimer::currentSeconds();
+
+  // intervalos [início, fim) de s concluídos
+  std::vector<std::pair<int, int>> ranges;
+  for (int s = 0; s < num_nodes; s++) {
+    if (!done_flags[s]) continue;
+    if (!ranges.empty() && ranges.back().second == s) ranges.back().second = s + 1;
+    else ranges.push_back({s, s + 1});
+  }
+
+  const std::string tmp = path + ".tmp";
+  FILE* f = fopen(tmp.c_str(), "w");
+  if (!f) return false;
+  fprintf(f, "johnson-checkpoint 1\n");
+  fprintf(f, "graph %d %d %llu\n", num_nodes, num_edges, (unsigned long long) graph_hash);
+  fprintf(f, "cycles %s\n", count_to_text(total).c_str());
+  fprintf(f, "sink %llu\n", (unsigned long long) sink);
+  fprintf(f, "ranges %zu\n", ranges.size());
+  for (const std::pair<int, int>& r : ranges) fprintf(f, "%d %d\n", r.first, r.second);
+  bool ok = fflush(f) == 0 && fsync(fileno(f)) == 0;
+  ok = fclose(f) == 0 && ok;
+  return ok && rename(tmp.c_str(), path.c_str()) == 0;
+}
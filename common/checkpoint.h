@@ -0,0 +1,79 @@
+#ifndef __CHECKPOINT_H__
+#define __CHECKPOINT_H__
+
+#include <stdint.h>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "graph.h"
+#include "cycle_count.h"
+
+// Checkpoint de uma contagem longa: quais vértices iniciais s já terminaram,
+// quantos ciclos eles somaram e quantos ciclos já foram entregues ao sink
+// (o offset até onde a saída de quem lista ciclos é válida). As versões
+// paralelas terminam os s fora de ordem, então o que se guarda é o conjunto
+// de s concluídos, não uma marca d'água.
+//
+// complete() é chamado ao fim de cada s (de qualquer thread) e grava o
+// arquivo se passaram interval segundos desde a última gravação. A gravação
+// vai para PATH.tmp e depois rename(), então o arquivo nunca fica pela metade.
+// Numa retomada, a versão pula os s concluídos e soma resumed_cycles(); um s
+// interrompido é refeito inteiro (quem lista ciclos corta a saída em
+// sink_cycles() antes de continuar). "s concluído" quer dizer que todos os
+// ciclos cujo menor vértice é s foram contados, então o arquivo de uma versão
+// serve para retomar com a outra (sequencial ou v5).
+//
+// Formato (texto, alguns bytes por intervalo de s concluídos):
+//   johnson-checkpoint 1
+//   graph <nós> <arestas> <hash das listas>
+//   cycles <total dos s concluídos>
+//   sink <ciclos entregues ao sink>
+//   ranges <k>
+//   <início> <fim>        (k linhas, fim exclusivo)
+#define CHECKPOINT_INTERVAL_SECONDS 60.0
+
+class Checkpoint {
+public:
+  Checkpoint(const std::string& path, Graph G, double interval = CHECKPOINT_INTERVAL_SECONDS);
+
+  // Carrega o arquivo; false (com o motivo em error) se não existe, está
+  // corrompido ou é de outro grafo
+  bool resume(std::string& error);
+
+  // Sem lock: cada s é escrito por uma tarefa só
+  bool done(int s) const { return done_flags[s] != 0; }
+
+  void complete(int s, cycle_count_t cycles, uint64_t sink_cycles = 0);
+  // SCC contada inteira de uma vez (caminho rápido): todos os vértices saem
+  void complete_all(const std::vector<int>& vertices, cycle_count_t cycles);
+
+  cycle_count_t resumed_cycles() const { return loaded_cycles; }
+  uint64_t resumed_sink_cycles() const { return loaded_sink; }
+  cycle_count_t cycles() const;
+  uint64_t sink_cycles() const;
+  int completed() const;
+
+  bool save();
+  const std::string& file() const { return path; }
+
+private:
+  void maybe_save_locked();
+  bool save_locked();
+
+  std::string path;
+  double interval;
+  double last_save;
+  int num_nodes;
+  int num_edges;
+  uint64_t graph_hash;
+
+  std::vector<uint8_t> done_flags;
+  mutable std::mutex mutex;
+  cycle_count_t total = 0;
+  uint64_t sink = 0;
+  int completed_count = 0;
+  cycle_count_t loaded_cycles = 0;
+  uint64_t loaded_sink = 0;
+};
+
+#endif // __CHECKPOINT_H__
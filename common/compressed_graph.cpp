@@ -0,0 +1,109 @@
+#include "compressed_graph.h"
+#include <algorithm>
+
+static void encode_varint(std::vector<uint8_t>& out, uint32_t value)
+{
+  while (value >= 0x80) {
+    out.push_back((uint8_t) (value | 0x80));
+    value >>= 7;
+  }
+  out.push_back((uint8_t) value);
+}
+
+// Grava values em grupos de 4 (tag + 1 a 4 bytes por valor)
+static void encode_group_varint(std::vector<uint8_t>& out, const std::vector<uint32_t>& values)
+{
+  for (size_t i = 0; i < values.size(); i += 4) {
+    const size_t tag_at = out.size();
+    out.push_back(0);
+    uint8_t tag = 0;
+    for (size_t j = 0; j < 4 && i + j < values.size(); j++) {
+      uint32_t value = values[i + j];
+      int len = value < (1u << 8) ? 1 : value < (1u << 16) ? 2 : value < (1u << 24) ? 3 : 4;
+      tag |= (uint8_t) ((len - 1) << (2 * j));
+      for (int b = 0; b < len; b++) out.push_back((uint8_t) (value >> (8 * b)));
+    }
+    out[tag_at] = tag;
+  }
+}
+
+// Uma direção do CSR: list(v, out) preenche os pares (vizinho, multiplicidade) de v
+template <typename List>
+static void compress_direction(int n, List list, bool with_mult, CompressedAdjacency& adjacency)
+{
+  std::vector<uint8_t>& bytes = adjacency.bytes;
+  adjacency.offsets.resize(n);
+  adjacency.blocks.clear();
+  std::vector<std::pair<int, int>> neighbors; // (vizinho, multiplicidade)
+  std::vector<uint32_t> values;
+  for (int v = 0; v < n; v++) {
+    if ((v & ((1 << COMPRESSED_BLOCK_SHIFT) - 1)) == 0) adjacency.blocks.push_back(bytes.size());
+    adjacency.offsets[v] = (uint32_t) (bytes.size() - adjacency.blocks.back());
+    neighbors.clear();
+    list(v, neighbors);
+    std::sort(neighbors.begin(), neighbors.end());
+
+    encode_varint(bytes, (uint32_t) neighbors.size());
+    values.clear();
+    int prev = v;
+    for (size_t i = 0; i < neighbors.size(); i++) {
+      const int w = neighbors[i].first;
+      if (i == 0) {
+        const int64_t d = (int64_t) w - v;
+        values.push_back((uint32_t) ((d << 1) ^ (d >> 63)));
+      } else {
+        values.push_back((uint32_t) (w - prev));
+      }
+      if (with_mult) values.push_back((uint32_t) (neighbors[i].second - 1));
+      prev = w;
+    }
+    encode_group_varint(bytes, values);
+  }
+  bytes.insert(bytes.end(), 3, 0); // folga para as leituras de 4 bytes
+  bytes.shrink_to_fit();
+}
+
+CompressedGraph compress_graph(const Graph G)
+{
+  CompressedGraph c;
+  c.num_nodes = G->num_nodes;
+  c.num_edges = G->num_edges;
+  c.has_multiplicity = G->outgoing_multiplicity != NULL;
+  if (G->self_loops) c.self_loops.assign(G->self_loops, G->self_loops + G->num_nodes);
+
+  compress_direction(G->num_nodes, [&](int v, std::vector<std::pair<int, int>>& out) {
+    for (const Vertex* w = outgoing_begin(G, v); w != outgoing_end(G, v); ++w)
+      out.push_back({*w, edge_multiplicity(G, w)});
+  }, c.has_multiplicity, c.outgoing);
+
+  compress_direction(G->num_nodes, [&](int v, std::vector<std::pair<int, int>>& out) {
+    for (const Vertex* u = incoming_begin(G, v); u != incoming_end(G, v); ++u)
+      out.push_back({*u, 1});
+  }, false, c.incoming);
+
+  return c;
+}
+
+size_t CompressedGraph::memory_bytes() const
+{
+  size_t bytes = self_loops.size() * sizeof(int);
+  for (const CompressedAdjacency* a : {&outgoing, &incoming}) {
+    bytes += a->blocks.size() * sizeof(uint64_t) + a->offsets.size() * sizeof(uint32_t) + a->bytes.size();
+  }
+  return bytes;
+}
+
+uint64_t separate_self_loops(const CompressedGraph* g)
+{
+  uint64_t loops = 0;
+  for (int count : g->self_loops) loops += count;
+  return loops;
+}
+
+size_t plain_graph_bytes(const Graph G)
+{
+  size_t bytes = 2 * (size_t) G->num_nodes * sizeof(int) + 2 * (size_t) G->num_edges * sizeof(Vertex);
+  if (G->outgoing_multiplicity) bytes += (size_t) G->num_edges * sizeof(int);
+  if (G->self_loops) bytes += (size_t) G->num_nodes * sizeof(int);
+  return bytes;
+}
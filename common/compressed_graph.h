@@ -0,0 +1,227 @@
+#ifndef __COMPRESSED_GRAPH_H__
+#define __COMPRESSED_GRAPH_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+#include "graph.h"
+
+// Vizinhanças como intervalos iteráveis, para que BFS e circuit possam ser
+// templates sobre o tipo do grafo: Graph (CSR de int) ou CompressedGraph
+// (CSR com deltas em varint). Os iteradores devolvem o vizinho em operator*
+// e a multiplicidade da aresta (grafo normalizado) em multiplicity().
+
+
+// ----------------------------------------------------------
+// CSR comum
+// ----------------------------------------------------------
+
+class PlainNeighborIterator {
+public:
+  PlainNeighborIterator(const Vertex* p, const int* mult) : p(p), mult(mult) {}
+
+  inline Vertex operator*() const { return *p; }
+  inline int multiplicity() const { return mult ? *mult : 1; }
+  inline PlainNeighborIterator& operator++()
+  {
+    ++p;
+    if (mult) ++mult;
+    return *this;
+  }
+  inline bool operator!=(const PlainNeighborIterator& other) const { return p != other.p; }
+
+private:
+  const Vertex* p;
+  const int* mult;
+};
+
+struct PlainNeighbors {
+  const Vertex* first;
+  const Vertex* last;
+  const int* mult;
+
+  PlainNeighborIterator begin() const { return PlainNeighborIterator(first, mult); }
+  PlainNeighborIterator end() const { return PlainNeighborIterator(last, nullptr); }
+};
+
+static inline PlainNeighbors outgoing(const Graph g, Vertex v)
+{
+  const Vertex* first = outgoing_begin(g, v);
+  const int* mult = g->outgoing_multiplicity ? g->outgoing_multiplicity + (first - g->outgoing_edges) : nullptr;
+  return {first, outgoing_end(g, v), mult};
+}
+
+// Arestas de entrada não guardam multiplicidade (só a BFS as percorre)
+static inline PlainNeighbors incoming(const Graph g, Vertex v)
+{
+  return {incoming_begin(g, v), incoming_end(g, v), nullptr};
+}
+
+
+// ----------------------------------------------------------
+// CSR comprimido
+// ----------------------------------------------------------
+
+// Cada lista é ordenada e gravada como o grau (varint de 7 bits por byte)
+// seguido dos valores: primeiro vizinho como diferença zigzag para v, os
+// demais como diferença para o anterior e, se o grafo tem multiplicidades,
+// cada vizinho de saída seguido da multiplicidade - 1. Os valores vão em
+// group varint: um byte de tag com o tamanho (1 a 4 bytes) de cada um dos
+// próximos 4 valores, que a decodificação lê sem desvios por valor. bytes
+// tem 3 bytes de folga no fim para as leituras de 4 bytes.
+// A posição da lista de v é blocks[v / 1024] + offsets[v]: 4 bytes por
+// vértice em vez de 8, com listas de mais de 4 GB por direção.
+#define COMPRESSED_BLOCK_SHIFT 10
+
+struct CompressedAdjacency {
+  std::vector<uint64_t> blocks;
+  std::vector<uint32_t> offsets;
+  std::vector<uint8_t> bytes;
+
+  inline const uint8_t* list(Vertex v) const
+  {
+    return bytes.data() + blocks[v >> COMPRESSED_BLOCK_SHIFT] + offsets[v];
+  }
+};
+
+struct CompressedGraph {
+  int num_nodes = 0;
+  int64_t num_edges = 0;
+
+  CompressedAdjacency outgoing;
+  CompressedAdjacency incoming;
+
+  bool has_multiplicity = false;
+  std::vector<int> self_loops;    // vazio se não há laços separados
+
+  size_t memory_bytes() const;
+};
+
+static inline uint32_t decode_varint(const uint8_t*& p)
+{
+  uint32_t value = *p++;
+  if (value < 0x80) return value; // caminho comum: diferença < 128
+  value &= 0x7f;
+  int shift = 7;
+  uint32_t byte;
+  do {
+    byte = *p++;
+    value |= (byte & 0x7f) << shift;
+    shift += 7;
+  } while (byte & 0x80);
+  return value;
+}
+
+// Decodifica um grupo de até 4 valores (count) a partir do byte de tag em p
+static inline const uint8_t* decode_group_varint(const uint8_t* p, int count, uint32_t* out)
+{
+  static const uint32_t mask[4] = {0xff, 0xffff, 0xffffff, 0xffffffff};
+  const uint32_t tag = *p++;
+  for (int i = 0; i < count; i++) {
+    const uint32_t len = (tag >> (2 * i)) & 3;
+    uint32_t word;
+    memcpy(&word, p, sizeof(word));
+    out[i] = word & mask[len];
+    p += len + 1;
+  }
+  return p;
+}
+
+class CompressedNeighborIterator {
+public:
+  struct End {};
+
+  CompressedNeighborIterator(const uint8_t* p, Vertex v, bool with_mult) : p(p), with_mult(with_mult)
+  {
+    remaining = (int) decode_varint(this->p);
+    values_left = with_mult ? 2 * remaining : remaining;
+    if (remaining > 0) {
+      uint32_t zigzag = next_value();
+      value = v + (int) ((zigzag >> 1) ^ (0u - (zigzag & 1)));
+      read_multiplicity();
+    }
+  }
+
+  inline Vertex operator*() const { return value; }
+  inline int multiplicity() const { return mult; }
+  inline CompressedNeighborIterator& operator++()
+  {
+    if (--remaining > 0) {
+      value += (int) next_value();
+      read_multiplicity();
+    }
+    return *this;
+  }
+  inline bool operator!=(End) const { return remaining > 0; }
+
+private:
+  inline uint32_t next_value()
+  {
+    if (buffered == used) {
+      buffered = values_left < 4 ? values_left : 4;
+      values_left -= buffered;
+      used = 0;
+      p = decode_group_varint(p, buffered, buffer);
+    }
+    return buffer[used++];
+  }
+
+  inline void read_multiplicity() { mult = with_mult ? (int) next_value() + 1 : 1; }
+
+  const uint8_t* p;
+  int remaining = 0;   // vizinhos ainda não visitados, o atual inclusive
+  int values_left = 0; // valores ainda não decodificados
+  int buffered = 0;
+  int used = 0;
+  uint32_t buffer[4];
+  Vertex value = 0;
+  int mult = 1;
+  bool with_mult;
+};
+
+struct CompressedNeighbors {
+  const uint8_t* first;
+  Vertex v;
+  bool with_mult;
+
+  CompressedNeighborIterator begin() const { return CompressedNeighborIterator(first, v, with_mult); }
+  CompressedNeighborIterator::End end() const { return {}; }
+};
+
+static inline CompressedNeighbors outgoing(const CompressedGraph* g, Vertex v)
+{
+  return {g->outgoing.list(v), v, g->has_multiplicity};
+}
+
+static inline CompressedNeighbors incoming(const CompressedGraph* g, Vertex v)
+{
+  return {g->incoming.list(v), v, false};
+}
+
+static inline bool has_edge_multiplicity(const CompressedGraph* g)
+{
+  return g->has_multiplicity;
+}
+
+static inline int outgoing_size(const CompressedGraph* g, Vertex v)
+{
+  const uint8_t* p = g->outgoing.list(v);
+  return (int) decode_varint(p);
+}
+
+static inline int incoming_size(const CompressedGraph* g, Vertex v)
+{
+  const uint8_t* p = g->incoming.list(v);
+  return (int) decode_varint(p);
+}
+
+// Comprime os dois CSRs de G (multiplicidades e laços separados inclusive)
+CompressedGraph compress_graph(const Graph G);
+
+uint64_t separate_self_loops(const CompressedGraph* g);
+
+// Memória dos CSRs de G (arrays de int, multiplicidades inclusive)
+size_t plain_graph_bytes(const Graph G);
+
+#endif // __COMPRESSED_GRAPH_H__
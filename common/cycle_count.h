@@ -0,0 +1,125 @@
+#ifndef __CYCLE_COUNT_H__
+#define __CYCLE_COUNT_H__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <omp.h>
+
+// Tipo do total de ciclos devolvido pelas versões. Por padrão 64 bits;
+// compile com -DCYCLE_COUNT_128 para acumular os totais em 128 bits.
+// Os contadores do caminho quente (dentro de circuit*) são sempre uint64_t
+// locais à thread/task e só são somados ao total uma vez no final
+// (local_count_add/local_count_mul, com saturação).
+#ifdef CYCLE_COUNT_128
+__extension__ typedef unsigned __int128 cycle_count_t;
+#else
+typedef uint64_t cycle_count_t;
+#endif
+
+// Valor saturado: indica que houve overflow em algum ponto da soma
+#define CYCLE_COUNT_MAX ((cycle_count_t) ~(cycle_count_t) 0)
+
+static inline bool cycle_count_overflowed(cycle_count_t c)
+{
+  return c == CYCLE_COUNT_MAX;
+}
+
+// Soma e produto com saturação em CYCLE_COUNT_MAX (overflow é "grudento")
+static inline cycle_count_t cycle_count_add(cycle_count_t a, cycle_count_t b)
+{
+  cycle_count_t r;
+  if (__builtin_add_overflow(a, b, &r)) return CYCLE_COUNT_MAX;
+  return r;
+}
+
+static inline cycle_count_t cycle_count_mul(cycle_count_t a, cycle_count_t b)
+{
+  cycle_count_t r;
+  if (__builtin_mul_overflow(a, b, &r)) return CYCLE_COUNT_MAX;
+  return r;
+}
+
+// Os mesmos para os contadores uint64_t do caminho quente (produto das
+// multiplicidades ao longo do caminho e contagem local): saturam em
+// UINT64_MAX, que local_count_total() leva a CYCLE_COUNT_MAX ao entrar
+// num total (com CYCLE_COUNT_128 o overflow do contador local continua
+// visível no total de 128 bits)
+static inline uint64_t local_count_add(uint64_t a, uint64_t b)
+{
+  uint64_t r;
+  if (__builtin_add_overflow(a, b, &r)) return UINT64_MAX;
+  return r;
+}
+
+static inline uint64_t local_count_mul(uint64_t a, uint64_t b)
+{
+  uint64_t r;
+  if (__builtin_mul_overflow(a, b, &r)) return UINT64_MAX;
+  return r;
+}
+
+// Peso do caminho s..v estendido por uma aresta de multiplicidade m. Os
+// circuit* recebem WEIGHTED como parâmetro de template e só instanciam a
+// versão com pesos para grafos com multiplicidades: sem elas o peso passa
+// adiante sem mudar (1, ou o da aresta inicial em cycles_through_edge) e o
+// laço não lê nem multiplica nada.
+template <bool WEIGHTED>
+static inline uint64_t extend_path_weight(uint64_t path_weight, int multiplicity)
+{
+  return WEIGHTED ? local_count_mul(path_weight, (uint64_t) multiplicity) : path_weight;
+}
+
+static inline cycle_count_t local_count_total(uint64_t c)
+{
+  return c == UINT64_MAX ? CYCLE_COUNT_MAX : (cycle_count_t) c;
+}
+
+// Total como contador local (satura em UINT64_MAX)
+static inline uint64_t local_count_from(cycle_count_t c)
+{
+#ifdef CYCLE_COUNT_128
+  return c > (cycle_count_t) UINT64_MAX ? UINT64_MAX : (uint64_t) c;
+#else
+  return c;
+#endif
+}
+
+// printf não tem formato para 128 bits; converte para decimal na mão
+static inline std::string cycle_count_str(cycle_count_t c)
+{
+  bool overflow = cycle_count_overflowed(c);
+  std::string digits;
+  do {
+    digits.insert(digits.begin(), (char)('0' + (int)(c % 10)));
+    c /= 10;
+  } while (c > 0);
+  return overflow ? ">= " + digits + " (overflow)" : digits;
+}
+
+// Contadores por thread, cada um em sua própria linha de cache. Cada
+// thread/task soma o seu contador local uma única vez com add(); total()
+// reduz tudo no final, fora do caminho quente.
+class PerThreadCounts {
+public:
+  PerThreadCounts() : slots(omp_get_max_threads()) {}
+
+  void add(cycle_count_t local)
+  {
+    Slot& slot = slots[omp_get_thread_num()];
+    slot.value = cycle_count_add(slot.value, local);
+  }
+
+  cycle_count_t total() const
+  {
+    cycle_count_t sum = 0;
+    for (const Slot& slot : slots) sum = cycle_count_add(sum, slot.value);
+    return sum;
+  }
+
+private:
+  struct alignas(64) Slot { cycle_count_t value = 0; };
+  std::vector<Slot> slots;
+};
+
+#endif // __CYCLE_COUNT_H__
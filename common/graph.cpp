@@ -9,17 +9,22 @@
 
 #include "graph.h"
 #include "graph_internal.h"
+#include "huge_pages.h"
 
 #define GRAPH_HEADER_TOKEN ((int) 0xDEADBEEF)
 
 
+// Os arrays podem ter sido movidos para páginas grandes (huge_pages_graph)
 void free_graph(Graph graph)
 {
-  free(graph->outgoing_starts);
-  free(graph->outgoing_edges);
+  huge_free(graph->outgoing_starts);
+  huge_free(graph->outgoing_edges);
 
-  free(graph->incoming_starts);
-  free(graph->incoming_edges);
+  huge_free(graph->incoming_starts);
+  huge_free(graph->incoming_edges);
+
+  huge_free(graph->outgoing_multiplicity);
+  huge_free(graph->self_loops);
   free(graph);
 }
 
@@ -247,7 +252,7 @@ void print_graph(const graph* graph)
 
 Graph load_graph(const char* filename)
 {
-  graph* graph = (struct graph*)(malloc(sizeof(struct graph)));
+  graph* graph = (struct graph*)(calloc(1, sizeof(struct graph)));
 
   // open the file
   std::ifstream graph_file;
@@ -270,7 +275,7 @@ Graph load_graph(const char* filename)
 
 Graph load_graph_binary(const char* filename)
 {
-    graph* graph = (struct graph*)(malloc(sizeof(struct graph)));
+    graph* graph = (struct graph*)(calloc(1, sizeof(struct graph)));
 
     FILE* input = fopen(filename, "rb");
 
@@ -345,3 +350,126 @@ void store_graph_binary(const char* filename, Graph graph) {
 
     fclose(output);
 }
+
+Graph build_graph(int num_nodes, int num_edges, const Vertex* sources, const Vertex* targets)
+{
+    graph* graph = (struct graph*)(calloc(1, sizeof(struct graph)));
+    graph->num_nodes = num_nodes;
+    graph->num_edges = num_edges;
+
+    std::vector<int> out_degree(num_nodes, 0);
+    for (int i = 0; i < num_edges; i++)
+        out_degree[sources[i]]++;
+
+    graph->outgoing_starts = (int*)malloc(sizeof(int) * num_nodes);
+    graph->outgoing_edges = (int*)malloc(sizeof(int) * num_edges);
+
+    int offset = 0;
+    for (int i = 0; i < num_nodes; i++) {
+        graph->outgoing_starts[i] = offset;
+        offset += out_degree[i];
+    }
+
+    // Preserva a ordem das arestas de cada vértice (como read_graph_file)
+    std::vector<int> fill(num_nodes, 0);
+    for (int i = 0; i < num_edges; i++) {
+        int u = sources[i];
+        graph->outgoing_edges[graph->outgoing_starts[u] + fill[u]++] = targets[i];
+    }
+
+    build_incoming_edges(graph);
+    return graph;
+}
+
+Graph normalize_graph(Graph G)
+{
+    const int n = G->num_nodes;
+    graph* graph = (struct graph*)(calloc(1, sizeof(struct graph)));
+    graph->num_nodes = n;
+    graph->outgoing_starts = (int*)malloc(sizeof(int) * n);
+    graph->outgoing_edges = (int*)malloc(sizeof(int) * G->num_edges);
+    graph->outgoing_multiplicity = (int*)malloc(sizeof(int) * G->num_edges);
+    graph->self_loops = (int*)calloc(n, sizeof(int));
+
+    // Cada lista ordenada; repetições viram uma aresta com multiplicidade
+    // e laços próprios só são contados
+    bool has_parallel = false, has_loops = false;
+    std::vector<int> sorted;
+    int m = 0;
+    for (int v = 0; v < n; v++) {
+        graph->outgoing_starts[v] = m;
+        sorted.assign(outgoing_begin(G, v), outgoing_end(G, v));
+        std::sort(sorted.begin(), sorted.end());
+        for (size_t i = 0; i < sorted.size(); i++) {
+            if (sorted[i] == v) {
+                graph->self_loops[v]++;
+                has_loops = true;
+            } else if (i > 0 && sorted[i] == sorted[i - 1]) {
+                graph->outgoing_multiplicity[m - 1]++;
+                has_parallel = true;
+            } else {
+                graph->outgoing_edges[m] = sorted[i];
+                graph->outgoing_multiplicity[m] = 1;
+                m++;
+            }
+        }
+    }
+    graph->num_edges = m;
+
+    if (!has_parallel) {
+        free(graph->outgoing_multiplicity);
+        graph->outgoing_multiplicity = NULL;
+    }
+    if (!has_loops) {
+        free(graph->self_loops);
+        graph->self_loops = NULL;
+    }
+
+    build_incoming_edges(graph);
+    return graph;
+}
+
+uint64_t separate_self_loops(const Graph graph)
+{
+    uint64_t loops = 0;
+    if (graph->self_loops) {
+        for (int v = 0; v < graph->num_nodes; v++) loops += graph->self_loops[v];
+    }
+    return loops;
+}
+
+Graph induced_subgraph(const Graph G, const Vertex* vertices, int count)
+{
+    std::vector<int> local(G->num_nodes, -1);
+    for (int i = 0; i < count; i++) local[vertices[i]] = i;
+
+    graph* graph = (struct graph*)(calloc(1, sizeof(struct graph)));
+    graph->num_nodes = count;
+    int m = 0;
+    for (int i = 0; i < count; i++) {
+        for (const Vertex* w = outgoing_begin(G, vertices[i]); w != outgoing_end(G, vertices[i]); ++w)
+            m += local[*w] >= 0;
+    }
+    graph->num_edges = m;
+    graph->outgoing_starts = (int*)malloc(sizeof(int) * std::max(count, 1));
+    graph->outgoing_edges = (int*)malloc(sizeof(int) * std::max(m, 1));
+    if (G->outgoing_multiplicity) graph->outgoing_multiplicity = (int*)malloc(sizeof(int) * std::max(m, 1));
+    if (G->self_loops) graph->self_loops = (int*)calloc(std::max(count, 1), sizeof(int));
+
+    // Vértices em ordem crescente => as listas continuam ordenadas
+    m = 0;
+    for (int i = 0; i < count; i++) {
+        const int v = vertices[i];
+        graph->outgoing_starts[i] = m;
+        for (const Vertex* w = outgoing_begin(G, v); w != outgoing_end(G, v); ++w) {
+            if (local[*w] < 0) continue;
+            if (graph->outgoing_multiplicity) graph->outgoing_multiplicity[m] = edge_multiplicity(G, w);
+            graph->outgoing_edges[m++] = local[*w];
+        }
+        if (graph->self_loops) graph->self_loops[i] = G->self_loops[v];
+    }
+
+    if (count > 0) build_incoming_edges(graph);
+    else graph->incoming_starts = graph->incoming_edges = NULL;
+    return graph;
+}
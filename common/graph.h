@@ -1,6 +1,8 @@
 #ifndef __GRAPH_H__
 #define __GRAPH_H__
 
+#include <stdint.h>
+
 using Vertex = int;
 
 struct graph
@@ -18,6 +20,13 @@ struct graph
 
     int* incoming_starts;
     Vertex* incoming_edges;
+
+    // Only set by normalize_graph (NULL otherwise). outgoing_multiplicity[i]
+    // is the number of parallel edges collapsed into outgoing_edges[i] (NULL
+    // if there were none); self_loops[v] is the number of self-loops of v,
+    // which are kept out of the adjacency lists (NULL if there were none).
+    int* outgoing_multiplicity;
+    int* self_loops;
 };
 
 using Graph = graph*;
@@ -34,6 +43,32 @@ static inline const Vertex* incoming_begin(const Graph, Vertex);
 static inline const Vertex* incoming_end(const Graph, Vertex);
 static inline int incoming_size(const Graph, Vertex);
 
+// Multiplicity of the outgoing edge pointed to by edge (1 unless normalized)
+static inline int edge_multiplicity(const Graph, const Vertex* edge);
+// True if some edge may have multiplicity > 1 (normalized graph)
+static inline bool has_edge_multiplicity(const Graph);
+
+
+/* Construction */
+// Builds a graph (outgoing and incoming CSR) from an edge list given as
+// two parallel arrays: edge i goes from sources[i] to targets[i].
+Graph build_graph(int num_nodes, int num_edges, const Vertex* sources, const Vertex* targets);
+
+// Load-time normalization: returns a new graph whose adjacency lists are
+// sorted and duplicate-free, with parallel edges collapsed into
+// outgoing_multiplicity and self-loops moved to self_loops. The number of
+// cycles of the multigraph is recovered by multiplying the multiplicities
+// along each simple cycle and adding the self-loops. The caller frees G.
+Graph normalize_graph(Graph G);
+
+// Number of 1-cycles kept out of the adjacency lists (sum of self_loops)
+uint64_t separate_self_loops(const Graph);
+
+// Subgraph induced by vertices[0..count) (distinct, in increasing order):
+// vertex i of the result is vertices[i]. Multiplicities and self-loops of
+// a normalized G are kept. The caller frees the result.
+Graph induced_subgraph(const Graph G, const Vertex* vertices, int count);
+
 
 /* IO */
 Graph load_graph(const char* filename);
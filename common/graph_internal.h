@@ -68,4 +68,14 @@ static inline int incoming_size(const Graph g, Vertex v)
   }
 }
 
+static inline int edge_multiplicity(const Graph g, const Vertex* edge)
+{
+  return g->outgoing_multiplicity ? g->outgoing_multiplicity[edge - g->outgoing_edges] : 1;
+}
+
+static inline bool has_edge_multiplicity(const Graph g)
+{
+  return g->outgoing_multiplicity != NULL;
+}
+
 #endif // __GRAPH_INTERNAL_H__
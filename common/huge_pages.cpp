@@ -0,0 +1,155 @@
+#include "huge_pages.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+static std::atomic<int> current_mode(HUGE_PAGES_OFF);
+static std::atomic<uint64_t> thp_bytes(0), hugetlb_bytes(0), fallbacks(0);
+
+// Blocos de mmap(MAP_HUGETLB) e seus tamanhos, para huge_free saber que é
+// munmap e não free. O mapa só é consultado se algum bloco existir.
+static std::mutex mapped_mutex;
+static std::unordered_map<void*, size_t> mapped_blocks;
+static std::atomic<size_t> mapped_count(0);
+
+bool parse_huge_page_mode(const char* name, HugePageMode& mode)
+{
+  for (HugePageMode m : {HUGE_PAGES_OFF, HUGE_PAGES_THP, HUGE_PAGES_HUGETLB}) {
+    if (strcmp(name, huge_page_mode_name(m)) == 0) {
+      mode = m;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char* huge_page_mode_name(HugePageMode mode)
+{
+  switch (mode) {
+    case HUGE_PAGES_OFF: return "off";
+    case HUGE_PAGES_THP: return "thp";
+    case HUGE_PAGES_HUGETLB: return "hugetlb";
+  }
+  return "?";
+}
+
+void set_huge_page_mode(HugePageMode mode)
+{
+  current_mode.store(mode);
+}
+
+HugePageMode huge_page_mode()
+{
+  return (HugePageMode) current_mode.load(std::memory_order_relaxed);
+}
+
+static size_t round_to_huge(size_t bytes)
+{
+  return (bytes + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+}
+
+static void* thp_alloc(size_t bytes)
+{
+  void* p = nullptr;
+  const size_t rounded = round_to_huge(bytes);
+  if (posix_memalign(&p, HUGE_PAGE_BYTES, rounded) != 0) return nullptr;
+#ifdef MADV_HUGEPAGE
+  if (madvise(p, rounded, MADV_HUGEPAGE) == 0) {
+    thp_bytes += rounded;
+    return p;
+  }
+#endif
+  fallbacks++;   // THP desligado ou kernel sem suporte: páginas de 4 KB
+  return p;
+}
+
+void* huge_alloc(size_t bytes)
+{
+  const HugePageMode mode = huge_page_mode();
+  if (mode == HUGE_PAGES_OFF || bytes < HUGE_PAGE_MIN_BYTES) return malloc(bytes ? bytes : 1);
+
+#ifdef MAP_HUGETLB
+  if (mode == HUGE_PAGES_HUGETLB) {
+    const size_t rounded = round_to_huge(bytes);
+    void* p = mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+      std::lock_guard<std::mutex> lock(mapped_mutex);
+      mapped_blocks[p] = rounded;
+      mapped_count++;
+      hugetlb_bytes += rounded;
+      return p;
+    }
+    fallbacks++;   // pool de páginas grandes vazio ou sem permissão
+  }
+#endif
+  return thp_alloc(bytes);
+}
+
+void huge_free(void* p)
+{
+  if (!p) return;
+  if (mapped_count.load(std::memory_order_relaxed) > 0) {
+    std::lock_guard<std::mutex> lock(mapped_mutex);
+    auto it = mapped_blocks.find(p);
+    if (it != mapped_blocks.end()) {
+      munmap(p, it->second);
+      mapped_blocks.erase(it);
+      mapped_count--;
+      return;
+    }
+  }
+  free(p);
+}
+
+HugePageStats huge_page_stats()
+{
+  HugePageStats stats;
+  stats.thp_bytes = thp_bytes.load();
+  stats.hugetlb_bytes = hugetlb_bytes.load();
+  stats.fallbacks = fallbacks.load();
+  return stats;
+}
+
+int64_t huge_pages_resident_bytes()
+{
+  FILE* f = fopen("/proc/self/smaps_rollup", "r");
+  if (!f) return -1;
+  char line[256];
+  int64_t kb = -1;
+  while (fgets(line, sizeof(line), f)) {
+    long long value;
+    if (sscanf(line, "AnonHugePages: %lld kB", &value) == 1) {
+      kb = value;
+      break;
+    }
+  }
+  fclose(f);
+  return kb < 0 ? -1 : kb * 1024;
+}
+
+static int* huge_copy(int* src, size_t count)
+{
+  if (!src) return nullptr;
+  int* dst = static_cast<int*>(huge_alloc(count * sizeof(int)));
+  if (!dst) return src; // sem memória para a cópia: fica o array original
+  memcpy(dst, src, count * sizeof(int));
+  huge_free(src);
+  return dst;
+}
+
+void huge_pages_graph(Graph G)
+{
+  if (huge_page_mode() == HUGE_PAGES_OFF) return;
+  const size_t n = G->num_nodes, m = G->num_edges;
+  G->outgoing_starts = huge_copy(G->outgoing_starts, n);
+  G->outgoing_edges = huge_copy(G->outgoing_edges, m);
+  G->incoming_starts = huge_copy(G->incoming_starts, n);
+  G->incoming_edges = huge_copy(G->incoming_edges, m);
+  G->outgoing_multiplicity = huge_copy(G->outgoing_multiplicity, m);
+  G->self_loops = huge_copy(G->self_loops, n);
+}
@@ -0,0 +1,84 @@
+#ifndef __HUGE_PAGES_H__
+#define __HUGE_PAGES_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+#include <vector>
+#include "graph.h"
+
+// Arrays grandes em páginas de 2 MB. circuit e as BFS acessam
+// outgoing_edges e os arrays de tamanho n (blocked, cabeças de B, carimbos
+// de época) em ordem aleatória; com páginas de 4 KB quase todo acesso a um
+// grafo grande é uma falta na dTLB.
+//
+// Modos (um por processo, set_huge_page_mode):
+//   HUGE_PAGES_OFF      malloc comum
+//   HUGE_PAGES_THP      alinhado a 2 MB + madvise(MADV_HUGEPAGE); o kernel
+//                       monta as páginas grandes se puder
+//   HUGE_PAGES_HUGETLB  mmap(MAP_HUGETLB) do pool reservado em
+//                       /proc/sys/vm/nr_hugepages; se o pool não tiver
+//                       páginas, cai para THP (e conta em fallbacks)
+// Só blocos de pelo menos HUGE_PAGE_MIN_BYTES vão para páginas grandes.
+#define HUGE_PAGE_BYTES (2u << 20)
+#define HUGE_PAGE_MIN_BYTES (1u << 20)
+
+enum HugePageMode {
+  HUGE_PAGES_OFF,
+  HUGE_PAGES_THP,
+  HUGE_PAGES_HUGETLB,
+};
+
+bool parse_huge_page_mode(const char* name, HugePageMode& mode);
+const char* huge_page_mode_name(HugePageMode mode);
+
+void set_huge_page_mode(HugePageMode mode);
+HugePageMode huge_page_mode();
+
+// Memória para bytes bytes no modo atual. Sempre liberada com huge_free
+// (que também aceita ponteiros de malloc/posix_memalign)
+void* huge_alloc(size_t bytes);
+void huge_free(void* p);
+
+struct HugePageStats {
+  uint64_t thp_bytes = 0;       // pedidos com madvise(MADV_HUGEPAGE)
+  uint64_t hugetlb_bytes = 0;   // vindos do pool de MAP_HUGETLB
+  uint64_t fallbacks = 0;       // MAP_HUGETLB ou madvise recusados
+};
+HugePageStats huge_page_stats();
+
+// AnonHugePages de /proc/self/smaps_rollup: quanto o kernel de fato montou
+// em páginas grandes (-1 se não der para ler)
+int64_t huge_pages_resident_bytes();
+
+// Move os arrays de G para memória de huge_alloc (free_graph continua valendo)
+void huge_pages_graph(Graph G);
+
+
+// Alocador para std::vector de arrays de rascunho de tamanho n
+template <typename T>
+struct HugePageAllocator {
+  using value_type = T;
+
+  HugePageAllocator() = default;
+  template <typename U>
+  HugePageAllocator(const HugePageAllocator<U>&) {}
+
+  T* allocate(size_t n)
+  {
+    void* p = huge_alloc(n * sizeof(T));
+    if (!p) throw std::bad_alloc();
+    return static_cast<T*>(p);
+  }
+  void deallocate(T* p, size_t) { huge_free(p); }
+
+  template <typename U>
+  bool operator==(const HugePageAllocator<U>&) const { return true; }
+  template <typename U>
+  bool operator!=(const HugePageAllocator<U>&) const { return false; }
+};
+
+template <typename T>
+using huge_vector = std::vector<T, HugePageAllocator<T>>;
+
+#endif // __HUGE_PAGES_H__
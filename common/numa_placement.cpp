@@ -0,0 +1,337 @@
+#include "numa_placement.h"
+#include "huge_pages.h"
+
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <omp.h>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+// Constantes de <numaif.h>, para não exigir o header nem a libnuma
+#define NUMA_MPOL_BIND 2
+#define NUMA_MPOL_INTERLEAVE 3
+#define NUMA_MAX_NODES 64
+#define NUMA_PAGE_BYTES 4096
+
+
+// ----------------------------------------------------------
+// Topologia
+// ----------------------------------------------------------
+
+static std::vector<int> parse_cpulist(const char* text)
+{
+  std::vector<int> cpus;
+  const char* p = text;
+  while (*p) {
+    char* end;
+    long first = strtol(p, &end, 10);
+    if (end == p) break;
+    long last = first;
+    p = end;
+    if (*p == '-') {
+      last = strtol(p + 1, &end, 10);
+      p = end;
+    }
+    for (long c = first; c <= last; c++) cpus.push_back((int) c);
+    if (*p == ',') p++;
+    else break;
+  }
+  return cpus;
+}
+
+static std::vector<int> allowed_cpus()
+{
+  std::vector<int> cpus;
+  cpu_set_t set;
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int c = 0; c < CPU_SETSIZE; c++) {
+      if (CPU_ISSET(c, &set)) cpus.push_back(c);
+    }
+  }
+  if (cpus.empty()) cpus.push_back(0);
+  return cpus;
+}
+
+static NumaTopology read_topology()
+{
+  NumaTopology topology;
+  topology.node_cpus.clear();
+  for (int node = 0; node < NUMA_MAX_NODES; node++) {
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    FILE* f = fopen(path, "r");
+    if (!f) continue;
+    char line[4096] = {0};
+    if (fgets(line, sizeof(line), f)) {
+      std::vector<int> cpus = parse_cpulist(line);
+      if (!cpus.empty()) topology.node_cpus.push_back(cpus);   // nós só de memória não contam
+    }
+    fclose(f);
+  }
+  if (topology.node_cpus.empty()) topology.node_cpus.push_back(allowed_cpus());
+  topology.nodes = (int) topology.node_cpus.size();
+  return topology;
+}
+
+static NumaTopology simulated_topology(int nodes)
+{
+  NumaTopology topology;
+  topology.nodes = nodes;
+  topology.simulated = true;
+  topology.node_cpus.assign(nodes, std::vector<int>());
+  std::vector<int> cpus = allowed_cpus();
+  for (size_t i = 0; i < cpus.size(); i++) topology.node_cpus[i % nodes].push_back(cpus[i]);
+  for (std::vector<int>& node : topology.node_cpus) {
+    if (node.empty()) node = cpus;   // menos CPUs que nós: os nós dividem as CPUs
+  }
+  return topology;
+}
+
+static NumaTopology& topology_storage()
+{
+  static NumaTopology topology = [] {
+    const char* env = getenv("NUMA_SIMULATE_NODES");
+    int simulated = env ? atoi(env) : 0;
+    return simulated > 1 ? simulated_topology(simulated) : read_topology();
+  }();
+  return topology;
+}
+
+const NumaTopology& numa_topology()
+{
+  return topology_storage();
+}
+
+void numa_simulate(int nodes)
+{
+  topology_storage() = nodes > 1 ? simulated_topology(nodes) : read_topology();
+}
+
+
+// ----------------------------------------------------------
+// Afinidade
+// ----------------------------------------------------------
+
+static bool pinning_enabled = false;
+static thread_local int pinned_node = -1;
+
+void numa_set_pinning(bool enabled)
+{
+  pinning_enabled = enabled;
+}
+
+bool numa_pinning()
+{
+  return pinning_enabled;
+}
+
+bool numa_pin_thread(int thread)
+{
+  if (!pinning_enabled) return false;
+  const NumaTopology& topology = numa_topology();
+  const int node = numa_thread_node(thread, topology);
+  const std::vector<int>& cpus = topology.node_cpus[node];
+
+  // dentro do nó, as threads se espalham pelas CPUs dele
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpus[(thread / topology.nodes) % cpus.size()], &set);
+  pinned_node = node;
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+void numa_pin_omp_threads()
+{
+  if (!pinning_enabled) return;
+  #pragma omp parallel
+  numa_pin_thread(omp_get_thread_num());
+}
+
+int numa_current_node()
+{
+  if (pinned_node >= 0) return pinned_node;
+  const NumaTopology& topology = numa_topology();
+  if (topology.nodes == 1) return 0;
+  const int cpu = sched_getcpu();
+  for (int node = 0; node < topology.nodes; node++) {
+    const std::vector<int>& cpus = topology.node_cpus[node];
+    if (std::find(cpus.begin(), cpus.end(), cpu) != cpus.end()) return node;
+  }
+  return 0;
+}
+
+
+// ----------------------------------------------------------
+// Colocação do grafo
+// ----------------------------------------------------------
+
+bool parse_numa_placement(const char* name, NumaPlacement& placement)
+{
+  for (NumaPlacement p : {NUMA_PLACEMENT_NONE, NUMA_PLACEMENT_INTERLEAVE, NUMA_PLACEMENT_REPLICATE}) {
+    if (strcmp(name, numa_placement_name(p)) == 0) {
+      placement = p;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char* numa_placement_name(NumaPlacement placement)
+{
+  switch (placement) {
+    case NUMA_PLACEMENT_NONE: return "none";
+    case NUMA_PLACEMENT_INTERLEAVE: return "interleave";
+    case NUMA_PLACEMENT_REPLICATE: return "replicate";
+  }
+  return "?";
+}
+
+// Política de memória para páginas ainda não tocadas; falha (sem NUMA no
+// kernel, um nó só, topologia simulada) deixa o first-touch decidir
+static void bind_pages(void* p, size_t bytes, int mode, const std::vector<int>& nodes)
+{
+  if (numa_topology().simulated || numa_topology().nodes == 1) return;
+  unsigned long mask[NUMA_MAX_NODES / (8 * sizeof(unsigned long))] = {0};
+  for (int node : nodes) mask[node / (8 * sizeof(unsigned long))] |= 1ul << (node % (8 * sizeof(unsigned long)));
+  syscall(SYS_mbind, p, bytes, mode, mask, (unsigned long) NUMA_MAX_NODES, 0u);
+}
+
+// Com páginas grandes ligadas (-H) a memória vem de huge_alloc e a unidade
+// de colocação passa a ser a página de 2 MB
+static size_t placement_page_bytes()
+{
+  return huge_page_mode() == HUGE_PAGES_OFF ? NUMA_PAGE_BYTES : HUGE_PAGE_BYTES;
+}
+
+static int* allocate_pages(size_t count)
+{
+  void* p = nullptr;
+  const size_t bytes = std::max<size_t>(count, 1) * sizeof(int);
+  if (huge_page_mode() != HUGE_PAGES_OFF) {
+    p = huge_alloc(bytes);
+  } else if (posix_memalign(&p, NUMA_PAGE_BYTES, bytes) != 0) {
+    p = nullptr;
+  }
+  if (!p) {
+    fprintf(stderr, "numa: out of memory\n");
+    exit(1);
+  }
+  return static_cast<int*>(p);
+}
+
+// Uma thread por nó, fixada numa CPU do nó, roda fn(node). As threads são
+// criadas aqui (e não as do OpenMP) para não mexer na afinidade delas.
+template <typename F>
+static void on_each_node(F fn)
+{
+  const NumaTopology& topology = numa_topology();
+  std::vector<std::thread> threads;
+  for (int node = 0; node < topology.nodes; node++) {
+    threads.emplace_back([&, node] {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      for (int cpu : topology.node_cpus[node]) CPU_SET(cpu, &set);
+      sched_setaffinity(0, sizeof(set), &set);
+      fn(node);
+    });
+  }
+  for (std::thread& t : threads) t.join();
+}
+
+// Cópia de src com a página p tocada primeiro pelo nó p % nós
+static int* interleaved_copy(const int* src, size_t count)
+{
+  if (!src) return nullptr;
+  int* dst = allocate_pages(count);
+  const int nodes = numa_topology().nodes;
+  std::vector<int> all(nodes);
+  for (int i = 0; i < nodes; i++) all[i] = i;
+  bind_pages(dst, count * sizeof(int), NUMA_MPOL_INTERLEAVE, all);
+
+  const size_t per_page = placement_page_bytes() / sizeof(int);
+  on_each_node([&](int node) {
+    for (size_t first = node * per_page; first < count; first += nodes * per_page) {
+      memcpy(dst + first, src + first, std::min(per_page, count - first) * sizeof(int));
+    }
+  });
+  return dst;
+}
+
+void numa_interleave_graph(Graph G)
+{
+  const size_t n = G->num_nodes, m = G->num_edges;
+  int** arrays[] = {&G->outgoing_starts, &G->outgoing_edges, &G->incoming_starts,
+                    &G->incoming_edges, &G->outgoing_multiplicity, &G->self_loops};
+  const size_t counts[] = {n, m, n, m, m, n};
+  for (int i = 0; i < 6; i++) {
+    int* moved = interleaved_copy(*arrays[i], counts[i]);
+    huge_free(*arrays[i]);
+    *arrays[i] = moved;
+  }
+}
+
+static int* node_copy(const int* src, size_t count, int node)
+{
+  if (!src) return nullptr;
+  int* dst = allocate_pages(count);
+  bind_pages(dst, count * sizeof(int), NUMA_MPOL_BIND, std::vector<int>(1, node));
+  memcpy(dst, src, count * sizeof(int));
+  return dst;
+}
+
+static std::mutex replicas_mutex;
+static Graph replicated_graph = nullptr;
+static std::vector<Graph> replicas;
+
+void numa_replicate_graph(Graph G)
+{
+  numa_free_replicas();
+  const size_t n = G->num_nodes, m = G->num_edges;
+  std::vector<Graph> copies(numa_topology().nodes);
+  on_each_node([&](int node) {
+    graph* copy = (struct graph*) calloc(1, sizeof(struct graph));
+    copy->num_nodes = G->num_nodes;
+    copy->num_edges = G->num_edges;
+    copy->outgoing_starts = node_copy(G->outgoing_starts, n, node);
+    copy->outgoing_edges = node_copy(G->outgoing_edges, m, node);
+    copy->incoming_starts = node_copy(G->incoming_starts, n, node);
+    copy->incoming_edges = node_copy(G->incoming_edges, m, node);
+    copy->outgoing_multiplicity = node_copy(G->outgoing_multiplicity, m, node);
+    copy->self_loops = node_copy(G->self_loops, n, node);
+    copies[node] = copy;
+  });
+
+  std::lock_guard<std::mutex> lock(replicas_mutex);
+  replicas.swap(copies);
+  replicated_graph = G;
+}
+
+void numa_free_replicas()
+{
+  std::lock_guard<std::mutex> lock(replicas_mutex);
+  for (Graph copy : replicas) free_graph(copy);
+  replicas.clear();
+  replicated_graph = nullptr;
+}
+
+// Sem lock: as réplicas são montadas antes e liberadas depois das contagens
+Graph numa_local_graph(Graph G)
+{
+  if (G != replicated_graph || replicas.empty()) return G;
+  return replicas[numa_current_node() % replicas.size()];
+}
+
+std::string numa_describe(NumaPlacement placement)
+{
+  const NumaTopology& topology = numa_topology();
+  std::string text = std::to_string(topology.nodes) + (topology.nodes == 1 ? " node" : " nodes");
+  if (topology.simulated) text += " (simulated)";
+  text += std::string(", placement ") + numa_placement_name(placement);
+  text += pinning_enabled ? ", threads pinned" : ", threads not pinned";
+  return text;
+}
@@ -0,0 +1,76 @@
+#ifndef __NUMA_PLACEMENT_H__
+#define __NUMA_PLACEMENT_H__
+
+#include <string>
+#include <vector>
+#include "graph.h"
+
+// Localidade NUMA sem depender da libnuma: topologia lida de
+// /sys/devices/system/node, afinidade com sched_setaffinity e política de
+// memória com a syscall mbind (se falhar, vale o first-touch de uma thread
+// fixada no nó).
+//
+// Threads são distribuídas entre os nós como OMP_PROC_BIND=spread com
+// OMP_PLACES=sockets: a thread t fica no nó t % nós, o que vale igual para
+// as threads do OpenMP, do WorkerPool e do WorkStealingPool.
+//
+// NUMA_SIMULATE_NODES=K (ou numa_simulate(K)) finge K nós repartindo as CPUs
+// da máquina entre eles, para testar tudo numa máquina de um nó só. Nesse
+// modo a memória não muda de lugar, só quem toca cada página primeiro.
+
+struct NumaTopology {
+  int nodes = 1;
+  bool simulated = false;
+  std::vector<std::vector<int>> node_cpus;   // CPUs de cada nó
+};
+
+const NumaTopology& numa_topology();
+
+// Troca a topologia por K nós simulados (antes de fixar threads ou colocar
+// o grafo); K <= 1 volta à topologia real
+void numa_simulate(int nodes);
+
+inline int numa_thread_node(int thread, const NumaTopology& topology = numa_topology())
+{
+  return thread % topology.nodes;
+}
+
+// Fixa a thread que chama numa CPU do nó de thread (pinning ligado por
+// numa_set_pinning) e lembra o nó para numa_current_node()
+void numa_set_pinning(bool enabled);
+bool numa_pinning();
+bool numa_pin_thread(int thread);
+
+// Fixa cada thread do OpenMP (omp_get_max_threads()); a libgomp reaproveita
+// as mesmas threads nas regiões seguintes do mesmo tamanho
+void numa_pin_omp_threads();
+
+// Nó da thread que chama: o da última fixação ou, sem fixação, o da CPU
+// onde ela está agora
+int numa_current_node();
+
+
+// Colocação dos arrays do grafo (os dois CSRs e as multiplicidades)
+enum NumaPlacement {
+  NUMA_PLACEMENT_NONE,        // onde load_graph_binary deixou (nó da thread principal)
+  NUMA_PLACEMENT_INTERLEAVE,  // páginas alternadas entre os nós
+  NUMA_PLACEMENT_REPLICATE,   // uma cópia inteira por nó
+};
+
+bool parse_numa_placement(const char* name, NumaPlacement& placement);
+const char* numa_placement_name(NumaPlacement placement);
+
+// Realoca os arrays de G intercalados entre os nós (G continua sendo liberado
+// por free_graph)
+void numa_interleave_graph(Graph G);
+
+// Uma cópia de G em cada nó, feita por uma thread fixada no nó. Enquanto as
+// réplicas existirem, numa_local_graph(G) devolve a do nó de quem chama.
+void numa_replicate_graph(Graph G);
+void numa_free_replicas();
+Graph numa_local_graph(Graph G);
+
+// "2 nodes (simulated), replicate, pinned": linha para a saída do benchmark
+std::string numa_describe(NumaPlacement placement);
+
+#endif // __NUMA_PLACEMENT_H__
@@ -0,0 +1,74 @@
+#include "perf_counters.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <omp.h>
+#include <mutex>
+
+static int open_dtlb_counter()
+{
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HW_CACHE;
+  attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+DtlbMissCounter::~DtlbMissCounter()
+{
+  close_all();
+}
+
+void DtlbMissCounter::close_all()
+{
+  for (int fd : fds) close(fd);
+  fds.clear();
+}
+
+bool DtlbMissCounter::start()
+{
+  close_all();
+  total = 0;
+  message.clear();
+
+  std::mutex mutex;
+  int first_errno = 0;
+  #pragma omp parallel
+  {
+    int fd = open_dtlb_counter();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fd >= 0) fds.push_back(fd);
+    else if (!first_errno) first_errno = errno;
+  }
+  if (first_errno) {
+    message = std::string("perf_event_open: ") + strerror(first_errno);
+    close_all();
+    return false;
+  }
+  for (int fd : fds) {
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+  return true;
+}
+
+bool DtlbMissCounter::stop()
+{
+  if (fds.empty()) return false;
+  for (int fd : fds) {
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    uint64_t value = 0;
+    if (read(fd, &value, sizeof(value)) == (ssize_t) sizeof(value)) total += value;
+  }
+  close_all();
+  return true;
+}
@@ -0,0 +1,42 @@
+#ifndef __PERF_COUNTERS_H__
+#define __PERF_COUNTERS_H__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Gancho de instrumentação: faltas na dTLB (leituras) contadas pelo
+// perf_event_open, só em modo usuário, somando as threads do OpenMP (cada
+// uma abre o próprio contador em start()). Os workers dos pools da v7 não
+// são threads do OpenMP e ficam de fora; o que a thread que chama executa
+// entra.
+//
+//     DtlbMissCounter tlb;
+//     tlb.start();
+//     ... contagem ...
+//     if (tlb.stop()) printf("%llu\n", (unsigned long long) tlb.misses());
+//
+// Sem permissão (perf_event_paranoid > 2, contêiner sem a syscall, VM sem
+// PMU) start() devolve false e error() diz por quê; a contagem roda igual.
+class DtlbMissCounter {
+public:
+  DtlbMissCounter() = default;
+  ~DtlbMissCounter();
+  DtlbMissCounter(const DtlbMissCounter&) = delete;
+  DtlbMissCounter& operator=(const DtlbMissCounter&) = delete;
+
+  bool start();
+  bool stop();
+
+  uint64_t misses() const { return total; }
+  const std::string& error() const { return message; }
+
+private:
+  void close_all();
+
+  std::vector<int> fds;
+  uint64_t total = 0;
+  std::string message;
+};
+
+#endif // __PERF_COUNTERS_H__
@@ -0,0 +1,109 @@
+#include "progress.h"
+#include "CycleTimer.h"
+
+#include <algorithm>
+#include <chrono>
+
+ProgressReporter::ProgressReporter(QueryGuard& query, Graph G, double interval, FILE* out,
+                                   const std::string& status_file)
+    : query(query), num_nodes(G->num_nodes), interval(interval), out(out), status_file(status_file),
+      cost(G->num_nodes, 0), cost_before(G->num_nodes + 1, 0)
+{
+  // custo(s) = arestas com min(u, v) >= s: conta cada aresta no menor
+  // extremo e acumula do fim para o começo
+  std::vector<uint64_t> by_min(num_nodes, 0);
+  for (int u = 0; u < num_nodes; u++) {
+    for (const Vertex* w = outgoing_begin(G, u); w != outgoing_end(G, u); ++w) {
+      if (*w != u) by_min[std::min(u, (int) *w)]++;
+    }
+  }
+  uint64_t edges_above = 0;
+  for (int s = num_nodes - 1; s >= 0; s--) {
+    edges_above += by_min[s];
+    cost[s] = edges_above;
+  }
+  for (int s = 0; s < num_nodes; s++) cost_before[s + 1] = cost_before[s] + cost[s];
+  query.set_cost_model(&cost);
+
+  start_time = last_time = CycleTimer::currentSeconds();
+  thread = std::thread([this] { loop(); });
+}
+
+ProgressReporter::~ProgressReporter()
+{
+  stop();
+}
+
+void ProgressReporter::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (finished) return;
+    finished = true;
+  }
+  wake.notify_all();
+  thread.join();
+  query.set_cost_model(nullptr);
+  if (!status_file.empty()) report(true);
+}
+
+double ProgressReporter::fraction_done(const QueryProgress& p) const
+{
+  const double total = (double) cost_before[num_nodes];
+  if (total <= 0.0) return 0.0;
+  if (p.unordered) return std::min(1.0, p.finished_cost / total);
+  if (p.current_s < 0) return 0.0;
+  return cost_before[std::min(p.current_s, num_nodes)] / total;
+}
+
+void ProgressReporter::loop()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  while (!finished) {
+    wake.wait_for(lock, std::chrono::duration<double>(interval), [this] { return finished; });
+    if (finished) break;
+    lock.unlock();
+    report(false);
+    lock.lock();
+  }
+}
+
+void ProgressReporter::report(bool final)
+{
+  const QueryProgress p = query.progress();
+  const double now = CycleTimer::currentSeconds();
+  const double elapsed = now - start_time;
+  const double rate = now > last_time ? (p.search_nodes - last_nodes) / (now - last_time) : 0.0;
+  last_time = now;
+  last_nodes = p.search_nodes;
+
+  const double done = final && query.exact() ? 1.0 : fraction_done(p);
+  const double eta = done > 0.0 ? elapsed * (1.0 - done) / done : -1.0;
+  char eta_text[32];
+  if (eta >= 0.0) snprintf(eta_text, sizeof(eta_text), "%.1f s", eta);
+  else snprintf(eta_text, sizeof(eta_text), "?");
+
+  if (out && !final) {
+    fprintf(out, "progress: s %d/%d (%llu reached), %llu cycles, %.3g nodes/s, %.1f%% of cost, %.1f s elapsed, ETA %s\n",
+            p.current_s, num_nodes, (unsigned long long) p.starts, (unsigned long long) p.cycles, rate,
+            100.0 * done, elapsed, eta_text);
+    fflush(out);
+  }
+  if (status_file.empty()) return;
+
+  const std::string tmp = status_file + ".tmp";
+  FILE* f = fopen(tmp.c_str(), "w");
+  if (!f) return;
+  fprintf(f, "state %s\n", final ? (query.exact() ? "done" : query_stop_name(query.reason())) : "running");
+  fprintf(f, "current_s %d\n", p.current_s);
+  fprintf(f, "num_nodes %d\n", num_nodes);
+  fprintf(f, "starts_reached %llu\n", (unsigned long long) p.starts);
+  fprintf(f, "cycles %llu\n", (unsigned long long) p.cycles);
+  fprintf(f, "search_nodes %llu\n", (unsigned long long) p.search_nodes);
+  fprintf(f, "nodes_per_second %.0f\n", rate);
+  fprintf(f, "fraction_done %.4f\n", done);
+  fprintf(f, "elapsed_seconds %.3f\n", elapsed);
+  fprintf(f, "eta_seconds %.3f\n", eta);
+  fclose(f);
+  rename(tmp.c_str(), status_file.c_str());
+}
@@ -0,0 +1,63 @@
+#ifndef __PROGRESS_H__
+#define __PROGRESS_H__
+
+#include <stdio.h>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "graph.h"
+#include "query_limits.h"
+
+// Andamento de uma contagem longa. Uma thread de fundo amostra a cada
+// interval segundos os contadores por thread do QueryGuard (um slot por
+// linha de cache, escritos só pela dona a cada QUERY_CHECK_INTERVAL passos)
+// e escreve uma linha em out e/ou um arquivo de status (PATH.tmp + rename).
+// Nada é somado no caminho quente; quem paga a soma é o reporter.
+//
+// ETA pelo modelo de custo por s: a busca a partir de s anda no subgrafo dos
+// vértices >= s, então custo(s) ~ arestas com as duas pontas >= s. A fração
+// feita é a soma do custo dos s terminados sobre a soma total: nas versões
+// com laço externo em ordem, os t < s atual; nas que terminam os s fora de
+// ordem (v0, v5, v6), os que chamaram query_finished(). Como o custo cai com
+// s, a fração cresce mais rápido no começo que a contagem de s.
+#define PROGRESS_INTERVAL_SECONDS 1.0
+
+class ProgressReporter {
+public:
+  ProgressReporter(QueryGuard& query, Graph G, double interval = PROGRESS_INTERVAL_SECONDS,
+                   FILE* out = stderr, const std::string& status_file = std::string());
+  ~ProgressReporter();
+  ProgressReporter(const ProgressReporter&) = delete;
+  ProgressReporter& operator=(const ProgressReporter&) = delete;
+
+  // Para a thread (idempotente); com status_file grava a última amostra
+  void stop();
+
+  // Fração do custo total feita, pela amostra p
+  double fraction_done(const QueryProgress& p) const;
+
+private:
+  void loop();
+  void report(bool final);
+
+  QueryGuard& query;
+  const int num_nodes;
+  const double interval;
+  FILE* out;
+  const std::string status_file;
+  std::vector<uint64_t> cost;          // custo(s), lido também pelo QueryGuard
+  std::vector<uint64_t> cost_before;   // cost_before[s] = soma de custo(t), t < s
+
+  double start_time;
+  double last_time;
+  uint64_t last_nodes = 0;
+
+  std::mutex mutex;
+  std::condition_variable wake;
+  bool finished = false;
+  std::thread thread;
+};
+
+#endif // __PROGRESS_H__
@@ -0,0 +1,141 @@
+#include "query_limits.h"
+#include "CycleTimer.h"
+#include <algorithm>
+
+QueryGuard* query_active = nullptr;
+static thread_local QueryTicks query_ticks;
+
+static std::atomic<uint64_t> next_generation{1};
+static std::atomic<int> next_thread_slot{0};
+static std::atomic<int> used_thread_slots{0};
+
+// Slot fixo de cada thread, para a vida da thread
+static int thread_slot()
+{
+  static thread_local int slot = -1;
+  if (slot < 0) {
+    slot = next_thread_slot.fetch_add(1, std::memory_order_relaxed) % QUERY_MAX_THREADS;
+    int used = used_thread_slots.load(std::memory_order_relaxed);
+    while (used < slot + 1 && !used_thread_slots.compare_exchange_weak(used, slot + 1, std::memory_order_relaxed)) {
+    }
+  }
+  return slot;
+}
+
+const char* query_stop_name(QueryStop reason)
+{
+  switch (reason) {
+    case QUERY_STOP_NONE: return "none";
+    case QUERY_STOP_MAX_CYCLES: return "max cycles";
+    case QUERY_STOP_DEADLINE: return "deadline";
+    case QUERY_STOP_SEARCH_NODES: return "max search nodes";
+    case QUERY_STOP_CANCELLED: return "cancelled";
+  }
+  return "?";
+}
+
+QueryGuard::QueryGuard(const QueryLimits& limits)
+    : generation(next_generation.fetch_add(1, std::memory_order_relaxed)), limits(limits),
+      deadline(limits.max_seconds > 0.0 ? CycleTimer::currentSeconds() + limits.max_seconds : 0.0),
+      slots(new QuerySlot[QUERY_MAX_THREADS])
+{
+  query_active = this;
+}
+
+QueryGuard::~QueryGuard()
+{
+  if (query_active == this) query_active = nullptr;
+}
+
+void QueryGuard::request_stop(QueryStop reason)
+{
+  int none = QUERY_STOP_NONE;
+  stop.compare_exchange_strong(none, reason, std::memory_order_relaxed);
+}
+
+QueryProgress QueryGuard::progress() const
+{
+  QueryProgress p;
+  p.unordered = unordered.load(std::memory_order_relaxed);
+  const int used = used_thread_slots.load(std::memory_order_relaxed);
+  for (int i = 0; i < used; i++) {
+    const QuerySlot& slot = slots[i];
+    p.search_nodes += slot.nodes.load(std::memory_order_relaxed);
+    p.cycles += slot.cycles.load(std::memory_order_relaxed);
+    p.starts += slot.starts.load(std::memory_order_relaxed);
+    p.current_s = std::max(p.current_s, slot.current_s.load(std::memory_order_relaxed));
+    p.finished += slot.finished.load(std::memory_order_relaxed);
+    p.finished_cost += slot.finished_cost.load(std::memory_order_relaxed);
+  }
+  return p;
+}
+
+void QueryGuard::start(int s)
+{
+  QuerySlot& slot = slots[thread_slot()];
+  slot.starts.fetch_add(1, std::memory_order_relaxed);
+  slot.current_s.store(s, std::memory_order_relaxed);
+}
+
+void QueryGuard::finish(int s)
+{
+  QuerySlot& slot = slots[thread_slot()];
+  slot.finished.fetch_add(1, std::memory_order_relaxed);
+  if (cost_model) slot.finished_cost.fetch_add((*cost_model)[s], std::memory_order_relaxed);
+}
+
+bool QueryGuard::check(QueryTicks& ticks)
+{
+  // Só o slot desta thread é escrito; somar os outros só quando há limite
+  // de ciclos ou de nós
+  QuerySlot& slot = slots[thread_slot()];
+  slot.nodes.fetch_add(ticks.steps, std::memory_order_relaxed);
+  slot.cycles.fetch_add(ticks.cycles, std::memory_order_relaxed);
+  ticks.steps = 0;
+  ticks.cycles = 0;
+
+  if (limits.cancel && limits.cancel->cancelled()) {
+    request_stop(QUERY_STOP_CANCELLED);
+  } else if (limits.max_cycles || limits.max_search_nodes) {
+    const QueryProgress p = progress();
+    if (limits.max_cycles && p.cycles >= limits.max_cycles) request_stop(QUERY_STOP_MAX_CYCLES);
+    else if (limits.max_search_nodes && p.search_nodes >= limits.max_search_nodes) request_stop(QUERY_STOP_SEARCH_NODES);
+  }
+  if (deadline > 0.0 && !stopped() && CycleTimer::currentSeconds() >= deadline) request_stop(QUERY_STOP_DEADLINE);
+  return stopped();
+}
+
+static QueryTicks& ticks_for(QueryGuard* guard)
+{
+  QueryTicks& ticks = query_ticks;
+  if (ticks.generation != guard->generation) ticks = QueryTicks{guard->generation, 0, 0};
+  return ticks;
+}
+
+bool query_step_active(QueryGuard* guard)
+{
+  if (guard->stopped()) return true;
+  QueryTicks& ticks = ticks_for(guard);
+  if (++ticks.steps < QUERY_CHECK_INTERVAL) return false;
+  return guard->check(ticks);
+}
+
+void query_cycles_active(QueryGuard* guard, uint64_t count)
+{
+  QueryTicks& ticks = ticks_for(guard);
+  ticks.cycles = local_count_add(ticks.cycles, count);
+}
+
+bool query_poll_active(QueryGuard* guard, int s)
+{
+  if (guard->stopped()) return true;
+  if (s >= 0) guard->start(s);
+  return guard->check(ticks_for(guard));
+}
+
+void query_finished_active(QueryGuard* guard, int s)
+{
+  // publica já: a task que terminou o s pode não chamar mais nada
+  guard->finish(s);
+  guard->check(ticks_for(guard));
+}
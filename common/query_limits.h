@@ -0,0 +1,195 @@
+#ifndef __QUERY_LIMITS_H__
+#define __QUERY_LIMITS_H__
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "cycle_count.h"
+
+// Limites de uma consulta (ciclos, tempo de parede, nós de busca) e
+// cancelamento cooperativo por fora. Os kernels chamam query_step() a cada
+// chamada de circuit* (inclusive dentro das tasks) e query_cycles() a cada
+// ciclo (os caminhos rápidos de dense_scc.hpp, pela contagem de cada s ou
+// da SCC); o custo sem consulta ativa é um load e um desvio. Com consulta
+// ativa, cada thread acumula passos e ciclos num contador próprio e só a
+// cada QUERY_CHECK_INTERVAL passos publica o acumulado e confere relógio,
+// token e limites (o relógio não é lido por passo). Parada vista por
+// qualquer thread vira uma flag que todas leem na entrada de circuit*.
+//
+// Os limites são aproximados: uma thread passa de max_cycles/max_search_nodes
+// por no máximo o trabalho de QUERY_CHECK_INTERVAL passos (para max_cycles
+// exato há JohnsonRun::max_cycles, ciclo a ciclo, só na sequencial). A
+// contagem de uma consulta parada é parcial (exact() = false); a de uma que
+// termina antes de bater um limite é exata.
+//
+//     CancellationToken cancel;               // cancel.cancel() de outra thread
+//     QueryLimits limits;
+//     limits.max_seconds = 0.5;
+//     limits.cancel = &cancel;
+//     QueryGuard query(limits);
+//     cycle_count_t c = johnson_cycles_parallel_v5(G);
+//     if (!query.exact()) ... c é parcial, query.reason() diz por quê
+//
+// Uma consulta por vez no processo (o guarda ativo é global, como o backend
+// de SCC); o QueryGuard vale do construtor ao destrutor.
+#define QUERY_CHECK_INTERVAL 1024
+
+class CancellationToken {
+public:
+  void cancel() { requested.store(true, std::memory_order_relaxed); }
+  void reset() { requested.store(false, std::memory_order_relaxed); }
+  bool cancelled() const { return requested.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<bool> requested{false};
+};
+
+struct QueryLimits {
+  uint64_t max_cycles = 0;        // 0 => sem limite
+  double max_seconds = 0.0;       // tempo de parede desde o QueryGuard; 0 => sem limite
+  uint64_t max_search_nodes = 0;  // chamadas de circuit*; 0 => sem limite
+  const CancellationToken* cancel = nullptr;
+
+  bool any() const { return max_cycles || max_seconds > 0.0 || max_search_nodes || cancel; }
+};
+
+enum QueryStop {
+  QUERY_STOP_NONE,
+  QUERY_STOP_MAX_CYCLES,
+  QUERY_STOP_DEADLINE,
+  QUERY_STOP_SEARCH_NODES,
+  QUERY_STOP_CANCELLED,
+};
+
+const char* query_stop_name(QueryStop reason);
+
+// Acumulado de uma thread ainda não publicado (generation separa consultas)
+struct QueryTicks {
+  uint64_t generation = 0;
+  uint32_t steps = 0;
+  uint64_t cycles = 0;
+};
+
+// Contadores publicados por uma thread, cada uma na sua linha de cache (a
+// thread só escreve no seu slot; quem lê soma os slots). Threads além de
+// QUERY_MAX_THREADS dividem slots, com fetch_add.
+#define QUERY_MAX_THREADS 256
+
+struct alignas(64) QuerySlot {
+  std::atomic<uint64_t> nodes{0};
+  std::atomic<uint64_t> cycles{0};
+  std::atomic<uint64_t> starts{0};    // s alcançados pelo laço externo (inclusive os pulados)
+  std::atomic<int> current_s{-1};
+  // Versões que terminam os s fora de ordem (v0, v5, v6) contam cada s
+  // terminado; nas outras o laço externo em s quer dizer que os t < s acabaram
+  std::atomic<uint64_t> finished{0};
+  std::atomic<uint64_t> finished_cost{0};
+};
+
+// Amostra do andamento (soma dos slots)
+struct QueryProgress {
+  uint64_t search_nodes = 0;
+  uint64_t cycles = 0;
+  uint64_t starts = 0;
+  int current_s = -1;   // maior s alcançado
+  uint64_t finished = 0;
+  uint64_t finished_cost = 0;   // soma do modelo de custo dos s terminados
+  bool unordered = false;       // o kernel chamou query_unordered()
+};
+
+class QueryGuard {
+public:
+  explicit QueryGuard(const QueryLimits& limits);
+  ~QueryGuard();
+  QueryGuard(const QueryGuard&) = delete;
+  QueryGuard& operator=(const QueryGuard&) = delete;
+
+  bool stopped() const { return stop.load(std::memory_order_relaxed) != QUERY_STOP_NONE; }
+  bool exact() const { return !stopped(); }
+  QueryStop reason() const { return (QueryStop) stop.load(std::memory_order_relaxed); }
+
+  // Publicados até agora (faltam os < QUERY_CHECK_INTERVAL passos de cada
+  // thread); pode ser lido de outra thread durante a consulta
+  QueryProgress progress() const;
+  uint64_t search_nodes() const { return progress().search_nodes; }
+  uint64_t cycles_seen() const { return progress().cycles; }
+
+  // Caminho lento de query_step: publica o acumulado e confere os limites
+  bool check(QueryTicks& ticks);
+  void start(int s);
+  void finish(int s);
+  void mark_unordered() { unordered.store(true, std::memory_order_relaxed); }
+
+  // Custo estimado de cada s (ver ProgressReporter), somado por finish();
+  // tem que viver mais que a consulta
+  void set_cost_model(const std::vector<uint64_t>* cost) { cost_model = cost; }
+  void request_stop(QueryStop reason);
+
+  const uint64_t generation;
+
+private:
+  QueryLimits limits;
+  double deadline;
+  std::atomic<int> stop{QUERY_STOP_NONE};
+  std::atomic<bool> unordered{false};
+  std::unique_ptr<QuerySlot[]> slots;
+  const std::vector<uint64_t>* cost_model = nullptr;
+};
+
+extern QueryGuard* query_active;
+
+// Fora de linha: no kernel fica só o load do guarda e um desvio (o código
+// de TLS e do relógio inline em circuit* pesa mais que a própria checagem)
+bool query_step_active(QueryGuard* guard);
+void query_cycles_active(QueryGuard* guard, uint64_t count);
+bool query_poll_active(QueryGuard* guard, int s);
+void query_finished_active(QueryGuard* guard, int s);
+
+// true => a consulta parou e o kernel deve voltar (sem mexer em mais nada)
+static inline bool query_step()
+{
+  QueryGuard* guard = query_active;
+  return __builtin_expect(guard != nullptr, 0) && query_step_active(guard);
+}
+
+static inline void query_cycles(uint64_t count)
+{
+  QueryGuard* guard = query_active;
+  if (__builtin_expect(guard != nullptr, 0)) query_cycles_active(guard, count);
+}
+
+// Só lê a flag (laços que criam tarefas)
+static inline bool query_stopped()
+{
+  QueryGuard* guard = query_active;
+  return guard && guard->stopped();
+}
+
+// Laços externos, uma vez por s: registra o s (progresso), publica e
+// confere já, para que relógio e token sejam vistos mesmo quando nenhum s
+// chama circuit* (caminhos rápidos). s = -1 => só confere.
+static inline bool query_poll(int s = -1)
+{
+  QueryGuard* guard = query_active;
+  return guard && query_poll_active(guard, s);
+}
+
+// Versões que terminam os s fora de ordem avisam no começo; o progresso
+// passa a contar só os s de query_finished() (o s alcançado pelo laço
+// externo não diz nada: o produtor da v5 chega ao fim antes das tasks)
+static inline void query_unordered()
+{
+  QueryGuard* guard = query_active;
+  if (guard) guard->mark_unordered();
+}
+
+// s terminado, nas versões que terminam os s fora de ordem; publica o
+// acumulado da thread (a soma dos slots fica exata quando todos terminam)
+static inline void query_finished(int s)
+{
+  QueryGuard* guard = query_active;
+  if (guard) query_finished_active(guard, s);
+}
+
+#endif // __QUERY_LIMITS_H__
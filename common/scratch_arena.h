@@ -0,0 +1,287 @@
+#ifndef __SCRATCH_ARENA_H__
+#define __SCRATCH_ARENA_H__
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include "numa_placement.h"
+#include "huge_pages.h"
+
+// Estado de rascunho reutilizável entre iterações de s. Em vez de alocar e
+// zerar vetores de tamanho n a cada s/pivô, os arrays são alocados uma vez e
+// "limpos" em O(1) trocando de época; o resto é resetado em O(tocados).
+
+
+// Conjunto de vértices com carimbo de época: v está marcado se
+// stamp[v] == epoch. clear() só incrementa a época.
+class EpochMarks {
+public:
+  void resize(int n)
+  {
+    if ((int) stamp.size() != n) {
+      stamp.assign(n, 0);
+      epoch = 1;
+    }
+  }
+
+  void clear()
+  {
+    if (++epoch == 0) { // deu a volta: zera de verdade uma vez a cada 2^32
+      memset(stamp.data(), 0, stamp.size() * sizeof(uint32_t));
+      epoch = 1;
+    }
+  }
+
+  inline bool marked(int v) const { return stamp[v] == epoch; }
+  inline void mark(int v) { stamp[v] = epoch; }
+  inline void unmark(int v) { stamp[v] = 0; }
+
+  // Versões para várias threads marcando o mesmo conjunto ao mesmo tempo:
+  // try_mark devolve true só para quem marcou v primeiro
+  inline bool marked_atomic(int v) const
+  {
+    return __atomic_load_n(&stamp[v], __ATOMIC_RELAXED) == epoch;
+  }
+
+  inline bool try_mark(int v)
+  {
+    uint32_t old = __atomic_load_n(&stamp[v], __ATOMIC_RELAXED);
+    if (old == epoch) return false;
+    return __atomic_compare_exchange_n(&stamp[v], &old, epoch, false,
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+  }
+
+  int size() const { return (int) stamp.size(); }
+
+private:
+  huge_vector<uint32_t> stamp;   // tamanho n, acesso aleatório: páginas grandes com -H
+  uint32_t epoch = 1;
+};
+
+
+// Dois buffers de fronteira de BFS que mantêm a capacidade entre usos
+struct FrontierBuffers {
+  std::vector<int> current;
+  std::vector<int> next;
+
+  void start(int v)
+  {
+    current.clear();
+    next.clear();
+    current.push_back(v);
+  }
+
+  void advance()
+  {
+    current.swap(next);
+    next.clear();
+  }
+};
+
+
+// Estado de uma BFS nível a nível paralela: cada thread junta a sua parte da
+// próxima fronteira em local_next[tid], que é concatenado no fim do nível
+struct ParallelFrontier {
+  EpochMarks visited;
+  EpochMarks in_frontier;       // fronteira atual, para o passo bottom-up
+  std::vector<int> reached;     // tudo que foi visitado, em ordem de nível
+  FrontierBuffers frontier;
+  std::vector<std::vector<int>> local_next;
+
+  void resize(int n, int threads)
+  {
+    visited.resize(n);
+    in_frontier.resize(n);
+    if ((int) local_next.size() < threads) local_next.resize(threads);
+  }
+};
+
+
+// Rascunho da decomposição em SCCs por BFS forward/backward
+struct SCCScratch {
+  EpochMarks assigned;      // já colocado em alguma SCC nesta chamada
+  EpochMarks visited_fwd;
+  EpochMarks visited_bwd;
+  std::vector<int> reached_fwd; // vértices marcados em visited_fwd, em ordem
+  FrontierBuffers frontier;
+
+  // Trim (trim.hpp): graus no subgrafo ativo, válidos só para os candidatos
+  // da chamada atual, e as fronteiras locais de cada thread
+  std::vector<int> in_degree;
+  std::vector<int> out_degree;
+  std::vector<std::vector<int>> local_next;
+
+  // Coloração do backend Multistep (scc_multistep.hpp)
+  std::vector<int> color;
+
+  void resize(int n)
+  {
+    assigned.resize(n);
+    visited_fwd.resize(n);
+    visited_bwd.resize(n);
+    if ((int) in_degree.size() != n) {
+      in_degree.resize(n);
+      out_degree.resize(n);
+      color.resize(n);
+    }
+  }
+};
+
+
+// Listas B do Johnson (B[w] = vértices a desbloquear junto com w) como
+// listas encadeadas num vetor de nós: cabeças com carimbo de época e os nós
+// de uma lista limpa por clear() numa lista livre que add() usa primeiro.
+// Como B[w] só guarda vizinhos de entrada de w, sem repetição, o vetor fica
+// em O(m) dentro de um s; reset() é O(1) e a memória vale para o próximo s.
+class BLists {
+public:
+  void resize(int n)
+  {
+    if ((int) head.size() != n) {
+      head.assign(n, -1);
+      valid.resize(n);
+    }
+  }
+
+  void reset()
+  {
+    valid.clear();
+    nodes.clear();
+    free_head = -1;
+  }
+
+  // Insere v em B[w] se ainda não estiver lá
+  void add(int w, int v)
+  {
+    int h = first(w);
+    for (int i = h; i >= 0; i = nodes[i].next)
+      if (nodes[i].v == v) return;
+    int i = free_head;
+    if (i >= 0) {
+      free_head = nodes[i].next;
+      nodes[i] = {v, h};
+    } else {
+      i = (int) nodes.size();
+      nodes.push_back({v, h});
+    }
+    head[w] = i;
+    valid.mark(w);
+  }
+
+  inline int first(int w) const { return valid.marked(w) ? head[w] : -1; }
+  inline int next(int i) const { return nodes[i].next; }
+  inline int value(int i) const { return nodes[i].v; }
+
+  // Esvazia B[w] devolvendo os nós à lista livre (O(|B[w]|), o mesmo que o
+  // unblock já gastou percorrendo a lista)
+  void clear(int w)
+  {
+    int i = first(w);
+    if (i < 0) return;
+    while (nodes[i].next >= 0) i = nodes[i].next;
+    nodes[i].next = free_head;
+    free_head = head[w];
+    valid.unmark(w);
+  }
+
+private:
+  struct Node { int v; int next; };
+  huge_vector<int> head;
+  EpochMarks valid;
+  std::vector<Node> nodes;
+  int free_head = -1;
+};
+
+
+// Estado do circuit de um s: blocked + B, mais a lista de vértices tocados
+// nesta época para que uma cópia (spawn de task) custe O(tocados) e não O(n).
+struct CircuitScratch {
+  EpochMarks blocked;
+  BLists B;
+  EpochMarks seen;          // já está em touched
+  std::vector<int> touched;
+
+  void reset(int n)
+  {
+    blocked.resize(n);
+    B.resize(n);
+    seen.resize(n);
+    blocked.clear();
+    B.reset();
+    seen.clear();
+    touched.clear();
+  }
+
+  inline void touch(int v)
+  {
+    if (!seen.marked(v)) {
+      seen.mark(v);
+      touched.push_back(v);
+    }
+  }
+
+  inline void block(int v) { blocked.mark(v); touch(v); }
+  inline void add_dependency(int w, int v) { B.add(w, v); touch(w); }
+
+  // Copia o estado de other (mesmo n) em O(vértices tocados em other)
+  void copy_from(const CircuitScratch& other)
+  {
+    reset(other.blocked.size());
+    for (int v : other.touched) {
+      if (other.blocked.marked(v)) block(v);
+      for (int i = other.B.first(v); i >= 0; i = other.B.next(i))
+        add_dependency(v, other.B.value(i));
+    }
+  }
+};
+
+
+// Pool de objetos de rascunho. Cada task pega um com acquire() e devolve no
+// fim; como tasks podem ser suspensas e retomadas, o pool (e não
+// thread_local) garante que duas tasks vivas nunca dividem o mesmo estado.
+// O número de objetos criados fica limitado ao pico de tasks simultâneas.
+//
+// Uma lista livre por nó NUMA: os arrays de um objeto são tocados primeiro
+// (e portanto alocados) no nó de quem o usou, então acquire() só reaproveita
+// objetos do nó da thread que chama e, se não houver, cria um novo.
+template <typename T>
+class ScratchPool {
+public:
+  class Lease {
+  public:
+    Lease(ScratchPool& pool) : pool(pool), node(numa_current_node()), item(pool.acquire(node)) {}
+    ~Lease() { pool.release(std::move(item), node); }
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+    T& operator*() { return *item; }
+    T* operator->() { return item.get(); }
+  private:
+    ScratchPool& pool;
+    int node;
+    std::unique_ptr<T> item;
+  };
+
+  std::unique_ptr<T> acquire(int node = 0)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if ((int) free_items.size() <= node || free_items[node].empty()) return std::unique_ptr<T>(new T());
+    std::unique_ptr<T> item = std::move(free_items[node].back());
+    free_items[node].pop_back();
+    return item;
+  }
+
+  void release(std::unique_ptr<T> item, int node = 0)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if ((int) free_items.size() <= node) free_items.resize(node + 1);
+    free_items[node].push_back(std::move(item));
+  }
+
+private:
+  std::mutex mutex;
+  std::vector<std::vector<std::unique_ptr<T>>> free_items;
+};
+
+#endif // __SCRATCH_ARENA_H__
@@ -0,0 +1,113 @@
+#ifndef __TASK_SCHEDULER_H__
+#define __TASK_SCHEDULER_H__
+
+#include <string.h>
+#include <functional>
+#include <utility>
+#include <omp.h>
+#include "worker_pool.h"
+#include "work_stealing.h"
+
+// Políticas de escalonamento para kernels recursivos escritos uma vez só,
+// como templates sobre o escalonador (circuit_v7_parallel<Scheduler>):
+//
+//     Scheduler::Group group;
+//     sched.spawn(group, [..]() mutable { ... });   // tarefa filha
+//     sched.wait(group);                            // espera as filhas
+//     sched.run([&] { ... });                       // raiz, nesta thread
+//
+// spawn só vale dentro de run() ou de uma tarefa, e a closure é copiada ou
+// movida para a tarefa (o que ela referencia tem que viver até o wait).
+enum TaskScheduler {
+  TASK_SCHEDULER_POOL,      // WorkerPool: fila única com mutex (padrão da v7)
+  TASK_SCHEDULER_OMP,       // #pragma omp task / taskwait
+  TASK_SCHEDULER_STEALING,  // WorkStealingPool: deques de Chase-Lev
+};
+
+inline const char* task_scheduler_name(TaskScheduler scheduler)
+{
+  switch (scheduler) {
+    case TASK_SCHEDULER_POOL: return "pool";
+    case TASK_SCHEDULER_OMP: return "omp";
+    case TASK_SCHEDULER_STEALING: return "steal";
+  }
+  return "?";
+}
+
+inline bool parse_task_scheduler(const char* name, TaskScheduler& scheduler)
+{
+  for (TaskScheduler s : {TASK_SCHEDULER_POOL, TASK_SCHEDULER_OMP, TASK_SCHEDULER_STEALING}) {
+    if (strcmp(name, task_scheduler_name(s)) == 0) {
+      scheduler = s;
+      return true;
+    }
+  }
+  return false;
+}
+
+
+// Tasks do OpenMP: uma região paralela por run() e uma task (alocada pela
+// libgomp) por spawn
+struct OmpTaskScheduler {
+  struct Group {};
+
+  template <typename F>
+  void run(F&& fn)
+  {
+    #pragma omp parallel
+    {
+      #pragma omp single
+      fn();
+    }
+  }
+
+  template <typename F>
+  void spawn(Group&, F&& fn)
+  {
+    typename std::decay<F>::type task_fn(std::forward<F>(fn));
+    #pragma omp task firstprivate(task_fn)
+    task_fn();
+  }
+
+  void wait(Group&)
+  {
+    #pragma omp taskwait
+  }
+};
+
+
+// WorkerPool persistente: cada spawn vira um std::function na fila única
+struct PoolTaskScheduler {
+  using Group = TaskGroup;
+
+  PoolTaskScheduler() { WorkerPool::instance().reserve(omp_get_max_threads()); }
+
+  template <typename F>
+  void run(F&& fn) { fn(); }
+
+  template <typename F>
+  void spawn(Group& group, F&& fn)
+  {
+    WorkerPool::instance().spawn(group, std::function<void()>(std::forward<F>(fn)));
+  }
+
+  void wait(Group& group) { WorkerPool::instance().wait(group); }
+};
+
+
+// Roubo de trabalho com deques de Chase-Lev por thread
+struct StealingTaskScheduler {
+  using Group = TaskGroup;
+
+  StealingTaskScheduler() { WorkStealingPool::instance().reserve(omp_get_max_threads()); }
+
+  template <typename F>
+  void run(F&& fn) { WorkStealingPool::instance().run(std::forward<F>(fn)); }
+
+  template <typename F>
+  void spawn(Group& group, F&& fn) { WorkStealingPool::instance().spawn(group, std::forward<F>(fn)); }
+
+  void wait(Group& group) { WorkStealingPool::instance().wait(group); }
+};
+
+#endif // __TASK_SCHEDULER_H__
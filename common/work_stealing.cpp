@@ -0,0 +1,269 @@
+#include "work_stealing.h"
+#include "numa_placement.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STEAL_PAUSE() _mm_pause()
+#else
+#define STEAL_PAUSE() std::this_thread::yield()
+#endif
+
+// ----------------------------------------------------------
+// Deque de Chase-Lev
+// ----------------------------------------------------------
+
+ChaseLevDeque::ChaseLevDeque() : top(0), bottom(0), array(new Array(STEAL_DEQUE_CAPACITY))
+{
+}
+
+ChaseLevDeque::~ChaseLevDeque()
+{
+  delete array.load(std::memory_order_relaxed);
+  for (Array* a : retired) delete a;
+}
+
+ChaseLevDeque::Array* ChaseLevDeque::grow(Array* a, int64_t t, int64_t b)
+{
+  Array* bigger = new Array(a->capacity * 2);
+  for (int64_t i = t; i < b; i++) bigger->put(i, a->get(i));
+  retired.push_back(a);
+  array.store(bigger, std::memory_order_release);
+  return bigger;
+}
+
+void ChaseLevDeque::push(StealTask* task)
+{
+  int64_t b = bottom.load(std::memory_order_relaxed);
+  int64_t t = top.load(std::memory_order_acquire);
+  Array* a = array.load(std::memory_order_relaxed);
+  if (b - t > a->capacity - 1) a = grow(a, t, b);
+  a->put(b, task);
+  std::atomic_thread_fence(std::memory_order_release);
+  bottom.store(b + 1, std::memory_order_relaxed);
+}
+
+StealTask* ChaseLevDeque::pop()
+{
+  int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+  Array* a = array.load(std::memory_order_relaxed);
+  bottom.store(b, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  int64_t t = top.load(std::memory_order_relaxed);
+
+  if (t > b) {   // vazio
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  StealTask* task = a->get(b);
+  if (t == b) {  // último elemento: disputa com os ladrões pelo topo
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      task = nullptr;
+    }
+    bottom.store(b + 1, std::memory_order_relaxed);
+  }
+  return task;
+}
+
+StealTask* ChaseLevDeque::steal()
+{
+  int64_t t = top.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  int64_t b = bottom.load(std::memory_order_acquire);
+  if (t >= b) return nullptr;
+
+  Array* a = array.load(std::memory_order_acquire);
+  StealTask* task = a->get(t);
+  if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+    return nullptr;
+  }
+  return task;
+}
+
+
+// ----------------------------------------------------------
+// Pool
+// ----------------------------------------------------------
+
+WorkStealingPool& WorkStealingPool::instance()
+{
+  static WorkStealingPool pool;
+  return pool;
+}
+
+int& WorkStealingPool::current_slot()
+{
+  static thread_local int slot = -1;
+  return slot;
+}
+
+WorkStealingPool::WorkStealingPool() : slots(new Slot[STEAL_MAX_THREADS])
+{
+  for (int i = 0; i < STEAL_MAX_THREADS; i++) {
+    slots[i].rng = 0x9E3779B97F4A7C15ull * (i + 1);
+  }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(park_mutex);
+    stopping = true;
+  }
+  park_cv.notify_all();
+  for (std::thread& t : workers) t.join();
+  for (int i = 0; i < STEAL_MAX_THREADS; i++) {
+    for (char* chunk : slots[i].chunks) ::operator delete(chunk);
+  }
+  delete[] slots;
+}
+
+void WorkStealingPool::reserve(int threads)
+{
+  if (threads < 1) threads = 1;
+  if (threads > STEAL_MAX_THREADS) threads = STEAL_MAX_THREADS;
+  std::lock_guard<std::mutex> lock(park_mutex);
+  while ((int) workers.size() < threads - 1) {
+    const int id = (int) workers.size() + 1;
+    workers.emplace_back([this, id] { worker_loop(id); });
+  }
+  active.store(threads);
+  const int cores = (int) std::thread::hardware_concurrency();
+  spin_limit.store(cores > 0 && threads > cores ? 0 : POOL_SPIN_ITERATIONS);
+  park_cv.notify_all();
+}
+
+void* WorkStealingPool::allocate()
+{
+  Slot& slot = slots[current_slot()];
+  if (!slot.free_list) {
+    char* chunk = static_cast<char*>(::operator new(STEAL_CHUNK_TASKS * STEAL_TASK_BYTES));
+    slot.chunks.push_back(chunk);
+    for (int i = 0; i < STEAL_CHUNK_TASKS; i++) release(chunk + i * STEAL_TASK_BYTES);
+  }
+  void* block = slot.free_list;
+  slot.free_list = *static_cast<void**>(block);
+  return block;
+}
+
+// O bloco volta para a lista de quem executou a tarefa, não de quem a criou
+void WorkStealingPool::release(void* block)
+{
+  Slot& slot = slots[current_slot()];
+  *static_cast<void**>(block) = slot.free_list;
+  slot.free_list = block;
+}
+
+void WorkStealingPool::push(StealTask* task)
+{
+  slots[current_slot()].deque.push(task);
+  // o worker soma parked antes de olhar os deques: ou ele vê a tarefa, ou
+  // nós o vemos dormindo e acordamos alguém
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (parked.load(std::memory_order_relaxed) > 0) {
+    std::lock_guard<std::mutex> lock(park_mutex);
+    park_cv.notify_one();
+  }
+}
+
+StealTask* WorkStealingPool::find_task(int self)
+{
+  if (StealTask* task = slots[self].deque.pop()) return task;
+
+  const int n = active.load(std::memory_order_relaxed);
+  if (n < 2) return nullptr;
+  uint64_t& x = slots[self].rng;
+  auto next_random = [&x]() {
+    x ^= x << 13;   // xorshift64
+    x ^= x >> 7;
+    x ^= x << 17;
+    return x;
+  };
+
+  // primeiro vítimas do mesmo nó NUMA (slots node, node + nós, ...): a
+  // tarefa roubada lê o que a vítima acabou de escrever
+  const int nodes = numa_topology().nodes;
+  if (nodes > 1) {
+    const int node = numa_thread_node(self);
+    const int same_node = (n - node + nodes - 1) / nodes;
+    for (int attempt = 0; same_node > 1 && attempt < 2 * same_node; attempt++) {
+      const int victim = node + (int) (next_random() % (uint64_t) same_node) * nodes;
+      if (victim == self) continue;
+      if (StealTask* task = slots[victim].deque.steal()) return task;
+    }
+  }
+
+  for (int attempt = 0; attempt < 2 * n; attempt++) {
+    const int victim = (int) (next_random() % (uint64_t) n);
+    if (victim == self) continue;
+    if (StealTask* task = slots[victim].deque.steal()) return task;
+  }
+  return nullptr;
+}
+
+void WorkStealingPool::execute(StealTask* task)
+{
+  TaskGroup* group = task->group;
+  task->invoke(task);
+  release(task);
+  group->pending.fetch_sub(1, std::memory_order_release);
+}
+
+void WorkStealingPool::wait(TaskGroup& group)
+{
+  const int self = current_slot();
+  const int spin = spin_limit.load(std::memory_order_relaxed);
+  int idle = 0;
+  while (group.pending.load(std::memory_order_acquire) > 0) {
+    if (StealTask* task = find_task(self)) {
+      execute(task);
+      idle = 0;
+    } else if (++idle < spin) {
+      STEAL_PAUSE();
+    } else {
+      std::this_thread::yield();
+    }
+  }
+}
+
+bool WorkStealingPool::any_work() const
+{
+  std::atomic_thread_fence(std::memory_order_seq_cst);   // par da cerca de push()
+  const int n = active.load(std::memory_order_relaxed);
+  for (int i = 0; i < n; i++) {
+    if (!slots[i].deque.empty()) return true;
+  }
+  return false;
+}
+
+void WorkStealingPool::worker_loop(int id)
+{
+  current_slot() = id;
+  numa_pin_thread(id);   // slot i no nó de i, como a thread i do OpenMP
+  for (;;) {
+    if (id < active.load(std::memory_order_relaxed)) {
+      if (StealTask* task = find_task(id)) {
+        execute(task);
+        continue;
+      }
+    }
+
+    bool found = false;
+    const int spin = spin_limit.load(std::memory_order_relaxed);
+    for (int i = 0; i < spin; i++) {
+      if ((i & 63) == 0 && any_work()) {
+        found = true;
+        break;
+      }
+      STEAL_PAUSE();
+    }
+    if (found && id < active.load(std::memory_order_relaxed)) continue;
+
+    std::unique_lock<std::mutex> lock(park_mutex);
+    parked.fetch_add(1);
+    park_cv.wait(lock, [&] {
+      return stopping || (id < active.load() && any_work());
+    });
+    parked.fetch_sub(1);
+    if (stopping) return;
+  }
+}
@@ -0,0 +1,154 @@
+#ifndef __WORK_STEALING_H__
+#define __WORK_STEALING_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "worker_pool.h"
+
+// Escalonador com roubo de trabalho, alternativa às tasks do OpenMP e à fila
+// única do WorkerPool. Cada thread tem um deque de Chase-Lev sem lock: o dono
+// empilha e desempilha no fundo (LIFO, a tarefa mais funda da recursão) e as
+// outras roubam do topo (a mais velha, normalmente a maior), escolhendo a
+// vítima ao acaso. Os objetos de tarefa vêm de listas livres por thread, sem
+// malloc por spawn. Mesmo ciclo de vida e política de espera do WorkerPool:
+// threads persistentes, spin de POOL_SPIN_ITERATIONS e depois dormir. Com
+// mais de um nó NUMA, o ladrão tenta antes as vítimas do próprio nó.
+#define STEAL_MAX_THREADS 256
+#define STEAL_TASK_BYTES 192        // maior closure aceita por spawn
+#define STEAL_CHUNK_TASKS 64        // blocos alocados de uma vez por thread
+#define STEAL_DEQUE_CAPACITY 256    // capacidade inicial (dobra quando enche)
+
+
+// Tarefa apagada de tipo: invoke roda e destrói a closure guardada logo após
+// o cabeçalho, no mesmo bloco de STEAL_TASK_BYTES
+struct StealTask {
+  void (*invoke)(StealTask*);
+  TaskGroup* group;
+};
+
+
+// Deque de Chase-Lev ("Dynamic Circular Work-Stealing Deque", com as ordens
+// de memória de Lê et al., "Correct and Efficient Work-Stealing for Weak
+// Memory Models"). push/pop só pelo dono; steal por qualquer thread. Os
+// arrays antigos ficam guardados até o fim porque um ladrão pode estar lendo.
+class ChaseLevDeque {
+public:
+  ChaseLevDeque();
+  ~ChaseLevDeque();
+
+  void push(StealTask* task);
+  StealTask* pop();
+  StealTask* steal();   // nullptr se vazio ou se perdeu a corrida
+
+  bool empty() const
+  {
+    return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+  }
+
+private:
+  struct Array {
+    int64_t capacity;   // potência de 2
+    std::atomic<StealTask*>* slots;
+
+    explicit Array(int64_t capacity) : capacity(capacity), slots(new std::atomic<StealTask*>[capacity]) {}
+    ~Array() { delete[] slots; }
+
+    StealTask* get(int64_t i) const { return slots[i & (capacity - 1)].load(std::memory_order_relaxed); }
+    void put(int64_t i, StealTask* t) { slots[i & (capacity - 1)].store(t, std::memory_order_relaxed); }
+  };
+
+  Array* grow(Array* a, int64_t top, int64_t bottom);
+
+  alignas(64) std::atomic<int64_t> top;
+  alignas(64) std::atomic<int64_t> bottom;
+  std::atomic<Array*> array;
+  std::vector<Array*> retired;   // só o dono mexe
+};
+
+
+class WorkStealingPool {
+public:
+  static WorkStealingPool& instance();
+
+  // threads contando a que chama run(); no máximo STEAL_MAX_THREADS
+  void reserve(int threads);
+
+  // Roda fn nesta thread como raiz (deque 0). Uma raiz por vez: chamadas
+  // de threads diferentes são serializadas.
+  template <typename F>
+  void run(F&& fn)
+  {
+    std::lock_guard<std::mutex> lock(root_mutex);
+    current_slot() = 0;
+    fn();
+    current_slot() = -1;
+  }
+
+  // Só dentro de run() ou de uma tarefa
+  template <typename F>
+  void spawn(TaskGroup& group, F&& fn)
+  {
+    using Closure = typename std::decay<F>::type;
+    struct Impl {
+      StealTask header;
+      Closure fn;
+    };
+    static_assert(sizeof(Impl) <= STEAL_TASK_BYTES, "closure maior que STEAL_TASK_BYTES");
+
+    void* block = allocate();
+    Impl* impl = new (block) Impl{StealTask{nullptr, &group}, Closure(std::forward<F>(fn))};
+    impl->header.invoke = [](StealTask* t) {
+      Impl* self = reinterpret_cast<Impl*>(t);
+      self->fn();
+      self->fn.~Closure();
+    };
+    group.pending.fetch_add(1, std::memory_order_relaxed);
+    push(&impl->header);
+  }
+
+  // Executa tarefas (as próprias primeiro, depois roubadas) até o grupo zerar
+  void wait(TaskGroup& group);
+
+  ~WorkStealingPool();
+
+private:
+  struct alignas(64) Slot {
+    ChaseLevDeque deque;
+    void* free_list = nullptr;         // blocos livres, encadeados pelo primeiro ponteiro
+    std::vector<char*> chunks;
+    uint64_t rng = 0;
+  };
+
+  WorkStealingPool();
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  static int& current_slot();
+  void* allocate();
+  void release(void* block);
+  void push(StealTask* task);
+  StealTask* find_task(int self);
+  void execute(StealTask* task);
+  bool any_work() const;
+  void worker_loop(int id);
+
+  Slot* slots;                       // STEAL_MAX_THREADS, fixos (workers leem sem lock)
+  std::mutex root_mutex;
+
+  std::mutex park_mutex;             // também serializa reserve()
+  std::condition_variable park_cv;
+  std::atomic<int> parked{0};
+  std::atomic<int> active{1};        // slots [0, active) valem; worker i usa o slot i
+  std::atomic<int> spin_limit{POOL_SPIN_ITERATIONS};
+  bool stopping = false;
+  std::vector<std::thread> workers;  // workers[i - 1] é o dono do slot i
+};
+
+#endif // __WORK_STEALING_H__
@@ -0,0 +1,128 @@
+#include "worker_pool.h"
+#include "numa_placement.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define POOL_PAUSE() _mm_pause()
+#else
+#define POOL_PAUSE() std::this_thread::yield()
+#endif
+
+WorkerPool& WorkerPool::instance()
+{
+  static WorkerPool pool;
+  return pool;
+}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(park_mutex);
+    stopping = true;
+  }
+  park_cv.notify_all();
+  for (std::thread& t : workers) t.join();
+}
+
+void WorkerPool::reserve(int threads)
+{
+  const int wanted = threads > 1 ? threads - 1 : 0;
+  std::lock_guard<std::mutex> lock(park_mutex);
+  while ((int) workers.size() < wanted) {
+    const int id = (int) workers.size();
+    workers.emplace_back([this, id] { worker_loop(id); });
+  }
+  active.store(wanted);
+  const int cores = (int) std::thread::hardware_concurrency();
+  spin_limit.store(cores > 0 && threads > cores ? 0 : POOL_SPIN_ITERATIONS);
+  park_cv.notify_all();   // quem estava desligado e voltou a valer olha a fila
+}
+
+void WorkerPool::spawn(TaskGroup& group, std::function<void()> fn)
+{
+  group.pending.fetch_add(1, std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    queue.push_back(Task{std::move(fn), &group});
+  }
+  queued.fetch_add(1);
+  // parked é incrementado sob park_mutex antes de o worker reler queued:
+  // ou ele vê a tarefa, ou nós o vemos dormindo e acordamos alguém
+  if (parked.load() > 0) {
+    std::lock_guard<std::mutex> lock(park_mutex);
+    park_cv.notify_one();
+  }
+}
+
+bool WorkerPool::try_pop(Task& task, bool newest)
+{
+  if (queued.load(std::memory_order_relaxed) == 0) return false;
+  std::lock_guard<std::mutex> lock(queue_mutex);
+  if (queue.empty()) return false;
+  if (newest) {
+    task = std::move(queue.back());
+    queue.pop_back();
+  } else {
+    task = std::move(queue.front());
+    queue.pop_front();
+  }
+  queued.fetch_sub(1, std::memory_order_relaxed);
+  return true;
+}
+
+void WorkerPool::run(Task& task)
+{
+  task.fn();
+  task.fn = nullptr;   // solta o que a tarefa capturou antes de avisar o grupo
+  task.group->pending.fetch_sub(1, std::memory_order_release);
+}
+
+void WorkerPool::wait(TaskGroup& group)
+{
+  Task task;
+  const int spin = spin_limit.load(std::memory_order_relaxed);
+  int idle = 0;
+  while (group.pending.load(std::memory_order_acquire) > 0) {
+    if (try_pop(task, true)) {
+      run(task);
+      idle = 0;
+    } else if (++idle < spin) {
+      POOL_PAUSE();   // o resto do grupo está rodando em outros workers
+    } else {
+      std::this_thread::yield();   // mais threads que núcleos: cede o núcleo a eles
+    }
+  }
+}
+
+void WorkerPool::worker_loop(int id)
+{
+  numa_pin_thread(id + 1);   // a thread 0 é quem chama
+  Task task;
+  for (;;) {
+    if (id < active.load(std::memory_order_relaxed) && try_pop(task, false)) {
+      run(task);
+      continue;
+    }
+
+    // spin: uma tarefa nova logo depois (o próximo s, a próxima consulta)
+    // é pega sem passar pelo kernel
+    bool found = false;
+    const int spin = spin_limit.load(std::memory_order_relaxed);
+    for (int i = 0; i < spin; i++) {
+      if (queued.load(std::memory_order_relaxed) > 0) {
+        found = true;
+        break;
+      }
+      POOL_PAUSE();
+    }
+    if (found && id < active.load(std::memory_order_relaxed)) continue;
+
+    std::unique_lock<std::mutex> lock(park_mutex);
+    parked.fetch_add(1);
+    park_cv.wait(lock, [&] {
+      return stopping || (queued.load() > 0 && id < active.load());
+    });
+    parked.fetch_sub(1);
+    if (stopping) return;
+  }
+}
@@ -0,0 +1,83 @@
+#ifndef __WORKER_POOL_H__
+#define __WORKER_POOL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pool de threads persistente, compartilhado pelo processo inteiro. As
+// versões com tasks do OpenMP abrem um #pragma omp parallel por s, ou seja,
+// um fork/join com barreira para cada vértice inicial de cada consulta; aqui
+// as threads são criadas uma vez e ficam vivas entre os s e entre chamadas.
+//
+// Quem chama também trabalha: wait() executa tarefas da fila até o grupo
+// terminar, então um pool de N threads tem N - 1 workers. Worker sem tarefa
+// gira POOL_SPIN_ITERATIONS vezes olhando a fila (acordar custa uma leitura)
+// e depois dorme numa variável de condição (não gasta CPU entre consultas).
+// Com mais threads que núcleos não há spin: girando, o worker só tiraria o
+// núcleo de quem tem trabalho.
+#define POOL_SPIN_ITERATIONS (1 << 14)
+
+
+// Tarefas pendentes de um conjunto de spawns; wait() volta quando zera
+class TaskGroup {
+public:
+  TaskGroup() : pending(0) {}
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+
+private:
+  friend class WorkerPool;
+  friend class WorkStealingPool;
+  std::atomic<int> pending;
+};
+
+
+class WorkerPool {
+public:
+  static WorkerPool& instance();
+
+  // Garante threads - 1 workers acordáveis (o chamador é a thread restante).
+  // Workers já criados além disso continuam vivos, mas não pegam tarefas.
+  void reserve(int threads);
+  int threads() const { return active.load(std::memory_order_relaxed) + 1; }
+
+  void spawn(TaskGroup& group, std::function<void()> fn);
+
+  // Executa tarefas (deste grupo ou de outro) até o grupo zerar
+  void wait(TaskGroup& group);
+
+  ~WorkerPool();
+
+private:
+  struct Task {
+    std::function<void()> fn;
+    TaskGroup* group;
+  };
+
+  WorkerPool() = default;
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  bool try_pop(Task& task, bool newest);
+  void run(Task& task);
+  void worker_loop(int id);
+
+  std::mutex queue_mutex;
+  std::deque<Task> queue;            // wait() tira a mais nova (mais funda), workers a mais velha (maior)
+  std::atomic<int> queued{0};
+
+  std::mutex park_mutex;             // também serializa reserve()
+  std::condition_variable park_cv;
+  std::atomic<int> parked{0};
+  std::atomic<int> active{0};        // workers com id < active pegam tarefas
+  std::atomic<int> spin_limit{0};    // POOL_SPIN_ITERATIONS ou 0 (mais threads que núcleos)
+  bool stopping = false;
+  std::vector<std::thread> workers;
+};
+
+#endif // __WORKER_POOL_H__
@@ -0,0 +1,54 @@
+#ifndef DENSE_SCC_HPP
+#define DENSE_SCC_HPP
+
+#include "graph.h"
+#include "cycle_count.h"
+#include <vector>
+
+// Maior SCC contada pela DP por subconjuntos: a DP de cada s usa
+// 2^(k-1) * (k-1) contadores de 8 bytes (~80 MB para k = 20), e o total de
+// ciclos de qualquer subgrafo simples de K_20 ainda cabe em 64 bits.
+#define DENSE_DP_MAX_VERTICES 20
+
+// Quantas arestas podem faltar para a SCC ainda ser tratada como
+// "completa menos algumas arestas" (inclusão-exclusão em 2^M termos).
+#define DENSE_MAX_MISSING_EDGES 8
+
+// Limiar da v5 para trocar circuit_v5_sequential pela DP num dado s: a DP
+// custa ~2^(k-1) k^2 independentemente da densidade, o Johnson cresce com o
+// número de ciclos. Em grafos aleatórios a DP já ganha a partir de ~30% de
+// densidade para k >= 8 (k = 14, d = 0.5: 0.5 ms contra 0.3 s).
+#define DENSE_DP_MIN_VERTICES 8
+#define DENSE_DP_MIN_DENSITY 0.3
+
+// Número de ciclos simples do dígrafo completo K_k: soma_{j=2}^{k} C(k,j) (j-1)!
+cycle_count_t complete_digraph_cycles(int k);
+
+enum DenseCountResult {
+    DENSE_COUNT_UNSUPPORTED, // nem fórmula nem DP: o chamador usa o Johnson normal
+    DENSE_COUNT_DONE,        // count = todos os ciclos da SCC
+    DENSE_COUNT_STOPPED,     // consulta parada no meio da DP: count = ciclos dos s já contados
+};
+
+// Conta exatamente os ciclos simples contidos na SCC scc_vertices sem
+// enumerá-los: fórmula fechada se a SCC é completa (ou completa menos até
+// DENSE_MAX_MISSING_EDGES arestas), DP por subconjuntos se tem até
+// DENSE_DP_MAX_VERTICES vértices. Os ciclos contados entram no QueryGuard
+// ativo (query_cycles) como os do circuit, e a DP confere a consulta a cada
+// s; count tem sempre os mesmos ciclos que entraram no QueryGuard, também
+// com DENSE_COUNT_STOPPED (o chamador soma a parcial e para).
+DenseCountResult dense_scc_count(Graph G, const std::vector<int>& scc_vertices, cycle_count_t& count);
+
+// Conta só os ciclos cujo menor vértice é o menor vértice da SCC (o s do laço
+// externo do Johnson) pela DP por subconjuntos. Devolve false se a SCC tem
+// mais de DENSE_DP_MAX_VERTICES vértices ou se a consulta ativa já parou.
+bool dense_cycles_from_min(Graph G, const std::vector<int>& scc_vertices, uint64_t& count);
+
+// true se a DP deve ser mais rápida que o Johnson para uma SCC com k vértices
+// e internal_edges arestas internas
+bool dense_dp_preferred(int k, int64_t internal_edges);
+
+// Kernel da DP escolhido em tempo de execução: "avx512", "avx2" ou "scalar"
+const char* dense_dp_kernel_name();
+
+#endif // DENSE_SCC_HPP
@@ -0,0 +1,111 @@
+#ifndef JOHNSON_HPP
+#define JOHNSON_HPP
+
+#include "graph.h"
+#include "compressed_graph.h"
+#include "cycle_count.h"
+#include "scc_multistep.hpp"
+#include "task_scheduler.h"
+#include "sequencial.hpp"
+#include "query_limits.h"
+#include "targeted.hpp"
+#include <memory>
+
+// API estável da biblioteca (lib/libjohnson.a e lib/libjohnson.so) para quem
+// embute a contagem num processo de longa duração: nada é impresso, os
+// resultados voltam em CycleEnumeratorStats e o mesmo grafo já carregado
+// pode ser contado quantas vezes for preciso, com opções diferentes.
+//
+//     CycleEnumeratorOptions options;
+//     options.engine = CYCLE_ENGINE_V6;
+//     options.threads = 8;
+//     CycleEnumerator enumerator(G, options);
+//     CycleEnumeratorStats stats = enumerator.run();
+
+// Mesma numeração de -v em bin/sccs
+enum CycleEngine {
+    CYCLE_ENGINE_SEQUENTIAL,
+    CYCLE_ENGINE_V0,
+    CYCLE_ENGINE_V1,
+    CYCLE_ENGINE_V2,
+    CYCLE_ENGINE_V3,
+    CYCLE_ENGINE_V4,
+    CYCLE_ENGINE_V5,
+    CYCLE_ENGINE_V6,
+    CYCLE_ENGINE_V7,
+};
+
+const char* cycle_engine_name(CycleEngine engine);
+
+struct CycleEnumeratorOptions {
+    CycleEngine engine = CYCLE_ENGINE_V6;
+    int threads = 0;                          // 0 => omp_get_max_threads()
+    bool count_only = false;                  // caminho rápido das SCCs densas (sequencial, v5, v6)
+    SCCBackend scc_backend = SCC_BACKEND_PIVOT;
+    bool compressed = false;                  // v6 sobre o CSR comprimido (feito uma vez e guardado)
+    TaskScheduler scheduler = TASK_SCHEDULER_POOL; // escalonador das tarefas da v7
+
+    // Limites: com max_cycles, max_length ou sink a contagem é a da versão
+    // sequencial, ciclo a ciclo; max_cycles e sink podem parar antes do fim
+    // (stats.complete = false)
+    uint64_t max_cycles = 0;                  // 0 => sem limite
+    int max_length = 0;                       // só ciclos com até max_length vértices; 0 => todos
+    CycleSink sink;                           // cada ciclo encontrado; false para
+
+    // Só os ciclos que passam pelo vértice through, ou pela aresta
+    // through -> through_next (through_next >= 0): busca local à SCC do alvo
+    // (targeted.hpp), ciclo a ciclo como a sequencial; -1 => todos os ciclos
+    int through = -1;
+    int through_next = -1;
+
+    // Limites aproximados em qualquer versão (conferidos a cada
+    // QUERY_CHECK_INTERVAL passos, inclusive nas tasks) e cancelamento por
+    // outra thread; parada => contagem parcial e stats.exact = false
+    QueryLimits limits;
+
+    // Registra os s concluídos e pula os já concluídos (Checkpoint::resume
+    // antes de run()). Só a sequencial e a v5 sabem fazer isso: as outras
+    // versões rodam como v5. Não é copiado nem liberado.
+    Checkpoint* checkpoint = nullptr;
+};
+
+struct CycleEnumeratorStats {
+    cycle_count_t cycles = 0;
+    bool complete = true;      // false se um limite ou o sink parou a enumeração
+    bool overflowed = false;   // contagem saturada em CYCLE_COUNT_MAX
+    bool exact = true;         // complete e sem saturação: cycles é o número exato
+    QueryStop stop_reason = QUERY_STOP_NONE; // qual de options.limits parou a contagem
+    uint64_t search_nodes = 0; // chamadas de circuit* publicadas (só com options.limits)
+    CycleEngine engine = CYCLE_ENGINE_V6;   // versão que de fato rodou
+    int threads = 1;
+    double seconds = 0.0;
+    double scc_seconds = -1.0;      // só a sequencial separa (-1 nas demais)
+    double circuit_seconds = -1.0;
+    int neighborhood_vertices = -1; // com through: vértices da SCC do alvo
+    int64_t neighborhood_visited = -1; // com through: vértices tocados pela busca local
+};
+
+// Não copia nem libera o grafo: G tem que viver mais que o enumerador e não
+// mudar entre chamadas de run(). run() não é reentrante (a quantidade de
+// threads e o backend de SCC do OpenMP/processo são trocados durante a
+// chamada e restaurados no fim).
+class CycleEnumerator {
+public:
+    explicit CycleEnumerator(Graph G, const CycleEnumeratorOptions& options = CycleEnumeratorOptions());
+    ~CycleEnumerator();
+
+    CycleEnumerator(const CycleEnumerator&) = delete;
+    CycleEnumerator& operator=(const CycleEnumerator&) = delete;
+
+    const CycleEnumeratorOptions& options() const { return opts; }
+    void set_options(const CycleEnumeratorOptions& options) { opts = options; }
+
+    CycleEnumeratorStats run();
+
+private:
+    Graph graph;
+    CycleEnumeratorOptions opts;
+    std::unique_ptr<CompressedGraph> compressed_graph;
+};
+
+#endif // JOHNSON_HPP
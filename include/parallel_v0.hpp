@@ -2,13 +2,15 @@
 #define PARALLEL_V0_HPP
 
 #include "graph.h"
+#include "cycle_count.h"
+#include "scratch_arena.h"
 #include <vector>
 #include <iostream>
 #include <algorithm>
 #include <unordered_set>
 #include "CycleTimer.h"
 
-int johnson_cycles_parallel_v0(Graph G);
+cycle_count_t johnson_cycles_parallel_v0(Graph G);
 
 #endif // PARALLEL_V0_HPP
 
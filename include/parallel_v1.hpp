@@ -2,6 +2,8 @@
 #define PARALLEL_V1_HPP
 
 #include "graph.h"
+#include "cycle_count.h"
+#include "scratch_arena.h"
 #include <vector>
 #include <iostream>
 #include <algorithm>
@@ -9,7 +11,7 @@
 #include "CycleTimer.h"
 #include <omp.h>
 
-int johnson_cycles_parallel_v1(Graph G);
+cycle_count_t johnson_cycles_parallel_v1(Graph G);
 
 #endif // PARALLEL_V1_HPP
 
@@ -2,6 +2,8 @@
 #define PARALLEL_V2_HPP
 
 #include "graph.h"
+#include "cycle_count.h"
+#include "scratch_arena.h"
 #include <vector>
 #include <iostream>
 #include <algorithm>
@@ -10,7 +12,7 @@
 #include <omp.h>
 #include <atomic>
 
-int johnson_cycles_parallel_v2(Graph G);
+cycle_count_t johnson_cycles_parallel_v2(Graph G);
 
 #endif // PARALLEL_V2_HPP
 
@@ -2,6 +2,9 @@
 #define PARALLEL_V5_HPP
 
 #include "graph.h"
+#include "cycle_count.h"
+#include "scratch_arena.h"
+#include "checkpoint.h"
 #include <vector>
 #include <iostream>
 #include <algorithm>
@@ -11,6 +14,9 @@
 #include <atomic>
 #include <mutex>
 
-int johnson_cycles_parallel_v5(Graph G);
+// count_only => SCCs pequenas e densas são contadas pela DP por subconjuntos
+// (dense_dp_preferred) em vez de circuit_v5_*. checkpoint => cada tarefa
+// registra o seu s ao terminar (fora de ordem) e os s já concluídos são pulados
+cycle_count_t johnson_cycles_parallel_v5(Graph G, bool count_only = false, Checkpoint* checkpoint = nullptr);
 
 #endif // PARALLEL_V5_HPP
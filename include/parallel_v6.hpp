@@ -0,0 +1,25 @@
+#ifndef PARALLEL_V6_HPP
+#define PARALLEL_V6_HPP
+
+#include "graph.h"
+#include "compressed_graph.h"
+#include "cycle_count.h"
+#include "scratch_arena.h"
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include "CycleTimer.h"
+#include <omp.h>
+
+// Decompõe o grafo uma vez e trata cada SCC não trivial como um job
+// independente (uma task) com o seu próprio sub-Johnson: s em ordem crescente
+// dentro da SCC, redecompondo só os vértices dela. Sub-SCCs grandes ainda
+// viram uma task por s. count_only => SCCs completas/quase completas ou
+// pequenas são contadas sem enumeração, como na sequencial e na v5.
+cycle_count_t johnson_cycles_parallel_v6(Graph G, bool count_only = false);
+
+// Mesma versão sobre o CSR comprimido (BFS e circuit decodificam as listas
+// durante a busca). Sem trim, Multistep nem contagem sem enumeração.
+cycle_count_t johnson_cycles_parallel_v6(const CompressedGraph* G);
+
+#endif // PARALLEL_V6_HPP
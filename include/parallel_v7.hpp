@@ -0,0 +1,28 @@
+#ifndef PARALLEL_V7_HPP
+#define PARALLEL_V7_HPP
+
+#include "graph.h"
+#include "cycle_count.h"
+#include "scratch_arena.h"
+#include "task_scheduler.h"
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <unordered_set>
+#include "CycleTimer.h"
+#include <omp.h>
+#include <atomic>
+
+// A v3 (spawn até PARALLEL_DEPTH níveis, cópia de blocked/B por tarefa)
+// sobre o WorkerPool persistente em vez de tasks do OpenMP: nenhuma região
+// paralela por s, e os workers continuam vivos entre os s e entre chamadas.
+// Usa omp_get_max_threads() threads, contando a que chama. O kernel é um
+// template sobre o escalonador: scheduler troca o pool pelas tasks do OpenMP
+// ou pelo roubo de trabalho com deques de Chase-Lev, sem mudar a busca.
+// Máscara da SCC, blocked e B são os rascunhos com época da v5
+// (scratch_arena.h): nada O(n) por s, e a cópia de uma tarefa custa
+// O(vértices tocados).
+cycle_count_t johnson_cycles_parallel_v7(Graph G, TaskScheduler scheduler = TASK_SCHEDULER_POOL);
+
+#endif // PARALLEL_V7_HPP
+
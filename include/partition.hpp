@@ -0,0 +1,56 @@
+#ifndef PARTITION_HPP
+#define PARTITION_HPP
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Particionamento fora da memória de um grafo binário (.graph/.bin) maior
+// que a RAM. Ciclos simples nunca cruzam SCCs, então basta contar os ciclos
+// de cada SCC não trivial (2+ vértices, ou 1 com laço próprio) isoladamente.
+//
+// A decomposição é semi-externa: só arrays por vértice (4 ints e 1 byte)
+// ficam em memória; as arestas são relidas do arquivo, em sequência, a cada
+// passada. Mesmos passos do Multistep: trim, um FW-BW a partir do vértice de
+// maior grau_entrada * grau_saída e coloração por propagação do máximo, cada
+// propagação repetindo passadas até estabilizar. Quando as arestas entre os
+// vértices que sobraram cabem em memory_edges, esse subgrafo é carregado
+// (8 bytes por aresta, os dois CSRs) e termina no Multistep em memória
+// (memory_edges < 0: tudo pelo arquivo).
+//
+// Cada SCC vira parte de um arquivo no mesmo formato binário, com os
+// vértices renumerados (ordem original preservada) e só as arestas internas
+// à SCC. SCCs pequenas são agrupadas no mesmo arquivo até part_edges arestas
+// (a contagem de ciclos de uma união disjunta é a soma); uma SCC maior que
+// isso fica sozinha. O diretório recebe também o índice parts.txt.
+#define PARTITION_PART_EDGES (1 << 22)
+#define PARTITION_MEMORY_EDGES (1 << 25)
+#define PARTITION_INDEX_FILE "parts.txt"
+
+struct PartitionPart {
+    std::string file;  // relativo ao diretório
+    int nodes = 0;
+    int edges = 0;
+    int sccs = 0;
+};
+
+struct PartitionStats {
+    int num_nodes = 0;
+    int num_edges = 0;
+    int edge_passes = 0;        // leituras completas das arestas do arquivo
+    bool in_memory_finish = false;
+    int cyclic_sccs = 0;
+    int64_t part_edges = 0;     // arestas gravadas (as demais não estão em ciclo)
+    size_t vertex_bytes = 0;    // memória dos arrays por vértice
+    std::vector<PartitionPart> parts;
+};
+
+// Lê filename e grava as partes em dir (que já deve existir)
+PartitionStats partition_graph_file(const char* filename, const char* dir,
+                                    int part_edges = PARTITION_PART_EDGES,
+                                    int64_t memory_edges = PARTITION_MEMORY_EDGES);
+
+// Partes listadas em dir/parts.txt; false se o índice não existe
+bool load_partition_index(const char* dir, std::vector<PartitionPart>& parts);
+
+#endif // PARTITION_HPP
@@ -0,0 +1,39 @@
+#ifndef REORDER_HPP
+#define REORDER_HPP
+
+#include "graph.h"
+#include <vector>
+
+// Renumeração opcional dos vértices na carga. O Johnson depende dos IDs (o
+// filtro w < s e a escolha do menor vértice s), e os IDs do arquivo SNAP vêm
+// em ordem arbitrária; a ordem muda tanto a localidade dos CSRs quanto quanto
+// cada circuit(s) consegue podar.
+enum VertexOrder {
+    ORDER_ORIGINAL,     // IDs do arquivo
+    ORDER_DEGREE_ASC,   // grau total (entrada + saída) crescente
+    ORDER_DEGREE_DESC,  // grau total decrescente
+    ORDER_SCC,          // vértices de cada SCC contíguos
+    ORDER_RCM,          // Reverse Cuthill-McKee sobre o grafo não direcionado
+    ORDER_GORDER,       // Gorder guloso (janela de 5 vértices)
+};
+
+// Nomes aceitos: "original", "degree-asc", "degree-desc", "scc", "rcm", "gorder"
+bool parse_vertex_order(const char* name, VertexOrder& order);
+const char* vertex_order_name(VertexOrder order);
+
+// Permutação dos vértices: new_id[v] é o novo ID do vértice v do arquivo e
+// old_id[v'] o inverso, para mapear a saída de volta aos IDs originais.
+// Empates em qualquer ordem são decididos pelo ID original.
+struct VertexRelabeling {
+    std::vector<int> new_id;
+    std::vector<int> old_id;
+};
+
+VertexRelabeling compute_vertex_order(Graph G, VertexOrder order);
+
+// Novo grafo (CSR de saída e de entrada) com os vértices renumerados. A
+// ordem das arestas de cada vértice é preservada (as de um grafo normalizado
+// voltam a ser repetidas). O chamador libera G.
+Graph relabel_graph(Graph G, const VertexRelabeling& relabeling);
+
+#endif // REORDER_HPP
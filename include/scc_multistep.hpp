@@ -0,0 +1,33 @@
+#ifndef SCC_MULTISTEP_HPP
+#define SCC_MULTISTEP_HPP
+
+#include "graph.h"
+#include "scratch_arena.h"
+#include <vector>
+
+// Backend da decomposição em SCCs usado por BFS_foward_backward_SCCs*:
+// PIVOT é o laço de pivôs com BFS forward/backward de cada versão; MULTISTEP
+// é o algoritmo Multistep (trim, um FW-BW para a SCC gigante, coloração por
+// propagação de rótulos para o resto), melhor com milhares de SCCs pequenas.
+enum SCCBackend {
+    SCC_BACKEND_PIVOT,
+    SCC_BACKEND_MULTISTEP,
+};
+
+// O padrão vem da variável de ambiente SCC_BACKEND ("pivot" ou "multistep");
+// sem ela, PIVOT
+SCCBackend scc_backend();
+void set_scc_backend(SCCBackend backend);
+const char* scc_backend_name();
+
+// Mesma entrada e mesmo conjunto de SCCs que BFS_foward_backward_SCCs*
+// (vértices >= min_vertex e ativos, cada um em exatamente uma SCC), em outra
+// ordem. Coloração e buscas para trás rodam em paralelo com muitos vértices.
+std::vector<std::vector<int>> multistep_SCCs(Graph G, const std::vector<int>& active, int min_vertex,
+                                             SCCScratch& scratch);
+
+// Forma canônica de uma decomposição: cada SCC ordenada e as SCCs ordenadas
+// pelo menor vértice. Duas decomposições do mesmo subgrafo ficam idênticas.
+void canonicalize_sccs(std::vector<std::vector<int>>& SCCs);
+
+#endif // SCC_MULTISTEP_HPP
@@ -2,13 +2,48 @@
 #define JOHNSON_CYCLES_HPP
 
 #include "../common/graph.h"
+#include "../common/cycle_count.h"
+#include "../common/scratch_arena.h"
+#include "../common/checkpoint.h"
 #include <vector>
 #include <iostream>
 #include <algorithm>
 #include <unordered_set>
+#include <functional>
 #include "common/CycleTimer.h"
 
-// Algoritmo de Johnson para contar todos os ciclos simples em um grafo dirigido
-int johnson_cycles(Graph G);
+// Recebe cada ciclo como a lista de vértices a partir do menor (s), na ordem
+// das arestas, e quantos ciclos do multigrafo ele representa (produto das
+// multiplicidades das arestas num grafo normalizado). false para a enumeração.
+using CycleSink = std::function<bool(const std::vector<int>& cycle, uint64_t multiplicity)>;
+
+// Entrada e saída opcionais de johnson_cycles. Com sink, max_cycles ou max_length a
+// contagem segue ciclo a ciclo (sem o caminho rápido de count_only) e pode
+// parar antes do fim; stopped diz se parou.
+struct JohnsonRun {
+    const CycleSink* sink = nullptr;
+    uint64_t max_cycles = 0;    // 0 => sem limite; para ao atingir (a contagem fica >= max_cycles)
+    // 0 => sem limite; só ciclos com no máximo max_length vértices. Um ramo
+    // cortado pelo comprimento desbloqueia o caminho como se tivesse achado
+    // ciclo (o bloqueio de Johnson só vale para buscas completas)
+    int max_length = 0;
+    // Registra cada s concluído e pula os que já estavam concluídos (retomada);
+    // max_cycles conta só os ciclos desta execução
+    Checkpoint* checkpoint = nullptr;
+
+    double scc_time = 0.0;
+    double circuit_time = 0.0;
+    bool stopped = false;
+};
+
+// Algoritmo de Johnson para contar todos os ciclos simples em um grafo dirigido.
+// count_only => SCCs completas/quase completas ou pequenas são contadas sem
+// enumeração (dense_scc_count); com false roda sempre o Johnson normal.
+cycle_count_t johnson_cycles(Graph G, bool count_only = false, JohnsonRun* run = nullptr);
+
+// Decomposição em SCCs do subgrafo ativo (vértices >= min_vertex com
+// active[v] != 0) usada no laço externo; o backend segue scc_backend()
+std::vector<std::vector<int>> BFS_foward_backward_SCCs(Graph G, const std::vector<int>& active, int min_vertex,
+                                                       SCCScratch& scratch);
 
 #endif // JOHNSON_CYCLES_HPP
\ No newline at end of file
@@ -0,0 +1,89 @@
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include "johnson.hpp"
+#include <stdint.h>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Modo servidor (bin/sccs --serve SOCKET): os grafos são carregados uma vez
+// e as consultas chegam por um socket Unix, uma por linha, com a resposta
+// também em linhas de texto:
+//
+//     graphs                          => graph NOME nodes=N edges=M ... ok graphs=K
+//     count GRAFO [chave=valor ...]   => ok cycles=X exact=1 stop=none ...
+//     list GRAFO [chave=valor ...]    => cycle MULT v1 v2 ... (um por ciclo) ... ok ...
+//     stats                           => ok queries=Q cache_hits=H
+//     quit | shutdown                 => fecha a conexão | para o servidor
+//
+// Chaves: engine=seq|v0..v7, threads=N, vertices=LISTA (ids e faixas a-b
+// separados por vírgula: só o subgrafo induzido), max-length=L, count-only,
+// through=V ou through-edge=U,V (só os ciclos pelo alvo, targeted.hpp),
+// max-seconds=S, max-cycles=N, max-search-nodes=N. Erros voltam como
+// "error mensagem". Os ciclos de list saem com os ids do grafo carregado,
+// a partir do menor (com through, do alvo), em blocos de
+// SERVER_WRITE_BUFFER bytes; cliente que fecha a conexão ou fica
+// send_timeout segundos sem ler para a enumeração (e solta a fila).
+//
+// Cada conexão tem a sua thread (leitura, subgrafo, resposta), mas as
+// contagens passam uma por vez pelo pool do processo (OpenMP e WorkerPool),
+// cada uma com as threads que pedir, até omp_get_num_procs(): o QueryGuard,
+// o número de threads e o backend de SCC são globais. shutdown cancela a
+// contagem em andamento e as da fila (stop=cancelled). Contagens exatas ficam num cache por (grafo,
+// vértices, max-length, alvo), de modo que a repetição volta sem rodar nada; a
+// espera na fila sai em queued=.
+#define SERVER_WRITE_BUFFER (1 << 16)
+#define SERVER_CACHE_ENTRIES 4096
+#define SERVER_SEND_TIMEOUT_SECONDS 10.0
+
+class CycleServer {
+public:
+    // send_timeout <= 0: escrita sem prazo
+    explicit CycleServer(const std::string& socket_path, double send_timeout = SERVER_SEND_TIMEOUT_SECONDS);
+    ~CycleServer();
+    CycleServer(const CycleServer&) = delete;
+    CycleServer& operator=(const CycleServer&) = delete;
+
+    // Não copia nem libera o grafo (tem que viver mais que o servidor)
+    void add_graph(const std::string& name, Graph G);
+
+    // Cria o socket (apaga um arquivo antigo no caminho); false com error
+    bool listen(std::string& error);
+    // Atende até shutdown ou stop(); espera as conexões terminarem
+    void serve();
+    // De outra thread (ou do comando shutdown)
+    void stop();
+
+private:
+    struct Connection;
+    struct CachedCount {
+        cycle_count_t cycles;
+        CycleEngine engine;
+    };
+
+    void handle(int fd);
+    bool query(Connection& conn, const std::vector<std::string>& words, bool list);
+
+    const std::string socket_path;
+    const double send_timeout;             // SO_SNDTIMEO dos clientes
+    std::map<std::string, Graph> graphs;
+    int listen_fd = -1;
+    std::atomic<bool> stopping{false};
+
+    std::mutex run_mutex;                  // uma contagem por vez no pool
+    CancellationToken cancel_runs;         // limits.cancel de toda consulta; stop() cancela
+
+    std::mutex state_mutex;                // clientes, cache e contadores
+    std::set<int> client_fds;
+    std::vector<std::thread> clients;
+    std::map<std::string, CachedCount> cache;
+    uint64_t queries = 0;
+    uint64_t cache_hits = 0;
+};
+
+#endif // SERVER_HPP
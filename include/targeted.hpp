@@ -0,0 +1,35 @@
+#ifndef TARGETED_HPP
+#define TARGETED_HPP
+
+#include "graph.h"
+#include "cycle_count.h"
+#include "sequencial.hpp"
+
+// Consultas dirigidas: só os ciclos que passam por um vértice ou por uma
+// aresta. Todo ciclo desses está na SCC do alvo, então a busca começa por
+// ela: BFS para frente e para trás a partir do alvo, em passos alternados;
+// a que termina primeiro dá um fecho completo R, e a SCC é a outra busca
+// restrita a R. O custo é o do menor dos dois fechos, não o do grafo.
+//
+// A SCC vira um CSR local (o alvo é o vértice 0) e um único circuit de
+// Johnson a partir do alvo, sem o corte w < s: cada ciclo pelo alvo é
+// achado uma vez, começando nele. Todo vértice da SCC alcança o alvo e é
+// alcançado por ele, e o bloqueio poda o que não volta ao alvo sem passar
+// pelo caminho atual. Com aresta u -> v, o primeiro passo a partir de u é
+// só para v. Os ciclos chegam ao sink com os ids de G, a partir do alvo
+// (ou de u); sink, max_cycles, max_length e o QueryGuard ativo valem como
+// em johnson_cycles (checkpoint não).
+struct TargetNeighborhood {
+    int vertices = 0;       // vértices da SCC do alvo
+    int64_t edges = 0;      // arestas internas a ela
+    int64_t visited = 0;    // vértices distintos tocados pelas BFS (o custo da busca local)
+};
+
+cycle_count_t cycles_through_vertex(Graph G, int vertex, JohnsonRun* run = nullptr,
+                                    TargetNeighborhood* neighborhood = nullptr);
+
+// 0 se a aresta não existe; arestas paralelas contam pela multiplicidade
+cycle_count_t cycles_through_edge(Graph G, int source, int target, JohnsonRun* run = nullptr,
+                                  TargetNeighborhood* neighborhood = nullptr);
+
+#endif // TARGETED_HPP
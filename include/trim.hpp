@@ -0,0 +1,28 @@
+#ifndef TRIM_HPP
+#define TRIM_HPP
+
+#include "graph.h"
+#include "scratch_arena.h"
+#include <vector>
+
+// Pré-processamento das decomposições em SCCs. Um vértice sem vizinho de
+// entrada ou sem vizinho de saída no subgrafo ativo (vértices >= min_vertex,
+// ativos e ainda sem SCC) é sozinho uma SCC trivial (Trim-1); repetindo até
+// o ponto fixo, cada um custa O(grau) em vez de duas BFS. Trim-2 acha pares
+// {u, v} com u <-> v em que nenhum dos dois tem outro vizinho de entrada (ou
+// de saída) ativo: o par é uma SCC de 2 vértices.
+//
+// Marca os vértices removidos em scratch.assigned (que o laço de pivôs já
+// pula) e acrescenta as SCCs encontradas em SCCs. Devolve quantos vértices
+// foram removidos. Com muitos candidatos roda em paralelo (taskloop se já
+// estiver dentro de uma região paralela).
+int trim_trivial_sccs(Graph G, const std::vector<int>& active, int min_vertex,
+                      SCCScratch& scratch, std::vector<std::vector<int>>& SCCs);
+
+// Filtro global antes do laço externo do Johnson: desativa em active os
+// vértices que não estão em nenhum ciclo (Trim-1 até o ponto fixo sobre o
+// grafo inteiro). Vértices com laço próprio nunca são removidos. Devolve
+// quantos vértices foram desativados.
+int trim_acyclic_vertices(Graph G, std::vector<int>& active);
+
+#endif // TRIM_HPP
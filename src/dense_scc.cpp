@@ -0,0 +1,490 @@
+#include "dense_scc.hpp"
+#include "query_limits.h"
+
+#include <algorithm>
+#include <string>
+#include <stdint.h>
+#include <stdlib.h>
+#include <omp.h>
+
+// Camadas da DP com menos máscaras que isso rodam sem abrir região paralela
+#define DP_PARALLEL_MIN_MASKS 4096
+
+// Os contadores da DP são uint64_t; overflow satura em UINT64_MAX
+static inline uint64_t sat_add64(uint64_t a, uint64_t b)
+{
+    uint64_t r;
+    return __builtin_add_overflow(a, b, &r) ? UINT64_MAX : r;
+}
+
+static inline uint64_t sat_mul64(uint64_t a, uint64_t b)
+{
+    uint64_t r;
+    return __builtin_mul_overflow(a, b, &r) ? UINT64_MAX : r;
+}
+
+static cycle_count_t gcd_count(cycle_count_t a, cycle_count_t b)
+{
+    while (b != 0) {
+        cycle_count_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// C(a,b) com saturação. Cada passo C(a,j) = C(a,j-1) (a-j+1) / j é feito
+// dividindo antes de multiplicar (j/g sempre divide a-j+1), então só satura
+// se o próprio resultado não couber.
+static cycle_count_t binomial(int a, int b)
+{
+    if (b < 0 || b > a) return 0;
+    cycle_count_t c = 1;
+    for (int j = 1; j <= b; j++) {
+        cycle_count_t g = gcd_count(c, (cycle_count_t) j);
+        c = cycle_count_mul(c / g, (cycle_count_t)(a - j + 1) / ((cycle_count_t) j / g));
+        if (cycle_count_overflowed(c)) return CYCLE_COUNT_MAX;
+    }
+    return c;
+}
+
+static cycle_count_t factorial(int a)
+{
+    cycle_count_t f = 1;
+    for (int i = 2; i <= a && !cycle_count_overflowed(f); i++)
+        f = cycle_count_mul(f, (cycle_count_t) i);
+    return f;
+}
+
+// Subgrafo induzido por uma SCC, com índices locais (vértices em ordem
+// crescente, então o índice local 0 é o menor vértice da SCC)
+struct SccMatrix {
+    int k;
+    std::vector<int> verts;
+    std::vector<uint64_t> A;          // A[a*k + b] = multiplicidade da aresta a -> b
+    std::vector<uint64_t> self_loops; // auto-laços por vértice local
+    int64_t internal_edges;           // arestas internas sem contar auto-laços
+    bool simple;                      // nenhuma aresta repetida
+    bool maybe_near_complete;
+};
+
+// Ciclos de K_k que contêm um conjunto fixo de arestas formando c caminhos
+// disjuntos com e arestas no total (e + c vértices cobertos). Contraindo cada
+// caminho num único vértice, um ciclo de comprimento e + m vira um ciclo de m
+// "unidades": as c contrações mais m - c vértices livres escolhidos entre os
+// k - e - c restantes, arranjados de (m-1)! maneiras.
+static cycle_count_t cycles_containing_paths(int k, int e, int c)
+{
+    cycle_count_t total = 0;
+    for (int m = std::max(c, 1); m <= k - e; m++) {
+        if (e + m < 2) continue;
+        cycle_count_t term = cycle_count_mul(binomial(k - e - c, m - c), factorial(m - 1));
+        total = cycle_count_add(total, term);
+        if (cycle_count_overflowed(total)) break;
+    }
+    return total;
+}
+
+cycle_count_t complete_digraph_cycles(int k)
+{
+    return cycles_containing_paths(k, 0, 0);
+}
+
+// Inclusão-exclusão sobre as arestas faltantes M de K_k:
+//   ciclos = soma_{F ⊆ M} (-1)^|F| N(F)
+// onde N(F) = ciclos de K_k que usam todas as arestas de F.
+static cycle_count_t near_complete_cycles(int k, const std::vector<std::pair<int,int>>& missing)
+{
+    const int num_missing = (int) missing.size();
+
+    cycle_count_t positive = complete_digraph_cycles(k);
+    cycle_count_t negative = 0;
+    if (cycle_count_overflowed(positive)) return CYCLE_COUNT_MAX;
+
+    // N(F) só depende de (e, c) quando F é uma união de caminhos
+    std::vector<cycle_count_t> memo((DENSE_MAX_MISSING_EDGES + 1) * (DENSE_MAX_MISSING_EDGES + 1), 0);
+    std::vector<char> memo_set(memo.size(), 0);
+
+    std::vector<int> out_deg(k, 0), in_deg(k, 0), succ(k, -1), touched;
+
+    for (uint32_t F = 1; F < (1u << num_missing); F++) {
+        int e = __builtin_popcount(F);
+        touched.clear();
+        bool valid = true;
+        for (int i = 0; i < num_missing; i++) {
+            if (!(F & (1u << i))) continue;
+            int u = missing[i].first, v = missing[i].second;
+            if (out_deg[u] == 0 && in_deg[u] == 0) touched.push_back(u);
+            if (out_deg[v] == 0 && in_deg[v] == 0) touched.push_back(v);
+            out_deg[u]++;
+            in_deg[v]++;
+            succ[u] = v;
+            if (out_deg[u] > 1 || in_deg[v] > 1) valid = false;
+        }
+
+        // Com graus <= 1, F é uma união de caminhos e ciclos. Percorre os
+        // caminhos a partir das origens; arestas que sobram estão em ciclos.
+        cycle_count_t N = 0;
+        if (valid) {
+            int c = 0, path_edges = 0;
+            for (int v : touched) {
+                if (in_deg[v] != 0) continue;
+                c++;
+                for (int cur = v; succ[cur] >= 0; cur = succ[cur]) path_edges++;
+            }
+
+            if (c == 0) {
+                // Só ciclos: conta (como 1) se F é um único ciclo
+                int start = touched[0], cur = start, len = 0;
+                do {
+                    cur = succ[cur];
+                    len++;
+                } while (cur != start);
+                N = (len == e) ? 1 : 0;
+            } else if (path_edges == e) {
+                int slot = e * (DENSE_MAX_MISSING_EDGES + 1) + c;
+                if (!memo_set[slot]) {
+                    memo[slot] = cycles_containing_paths(k, e, c);
+                    memo_set[slot] = 1;
+                }
+                N = memo[slot];
+            }
+            // caminhos junto com algum ciclo: nenhum ciclo simples contém F
+        }
+
+        if (e % 2 == 0) positive = cycle_count_add(positive, N);
+        else negative = cycle_count_add(negative, N);
+
+        for (int v : touched) {
+            out_deg[v] = in_deg[v] = 0;
+            succ[v] = -1;
+        }
+    }
+
+    if (cycle_count_overflowed(positive) || cycle_count_overflowed(negative)) return CYCLE_COUNT_MAX;
+    return positive - negative;
+}
+
+// ----------------------------------------------------------
+// Kernels da transição da DP (grafo simples)
+// ----------------------------------------------------------
+//
+// Para uma máscara P, t[v] = soma_{u ∈ P} dp[P][u] * A[u][v]. Num grafo
+// simples A[u][v] é 0 ou 1, então o produto vira um AND com uma máscara de
+// 64 bits (0 ou ~0) e cada linha de A é um vetor de DP_SIMD_WIDTH lanes.
+
+// Largura (em uint64) das linhas de máscara: múltiplo de 8 (AVX-512) que
+// cobre os m <= DENSE_DP_MAX_VERTICES - 1 vértices acima de s
+#define DP_SIMD_WIDTH (((DENSE_DP_MAX_VERTICES - 1) + 7) / 8 * 8)
+
+typedef void (*TransitionKernel)(const uint64_t* row, uint32_t P, const uint64_t* masks, uint64_t* t);
+
+static void transition_scalar(const uint64_t* row, uint32_t P, const uint64_t* masks, uint64_t* t)
+{
+    for (int v = 0; v < DP_SIMD_WIDTH; v++) t[v] = 0;
+    for (uint32_t bits = P; bits; bits &= bits - 1) {
+        int u = __builtin_ctz(bits);
+        const uint64_t* mrow = masks + (size_t) u * DP_SIMD_WIDTH;
+        for (int v = 0; v < DP_SIMD_WIDTH; v++) t[v] += row[u] & mrow[v];
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+__attribute__((target("avx2")))
+static void transition_avx2(const uint64_t* row, uint32_t P, const uint64_t* masks, uint64_t* t)
+{
+    __m256i acc[DP_SIMD_WIDTH / 4];
+    for (int j = 0; j < DP_SIMD_WIDTH / 4; j++) acc[j] = _mm256_setzero_si256();
+    for (uint32_t bits = P; bits; bits &= bits - 1) {
+        int u = __builtin_ctz(bits);
+        const __m256i b = _mm256_set1_epi64x((long long) row[u]);
+        const uint64_t* mrow = masks + (size_t) u * DP_SIMD_WIDTH;
+        for (int j = 0; j < DP_SIMD_WIDTH / 4; j++) {
+            __m256i m = _mm256_loadu_si256((const __m256i*)(mrow + 4 * j));
+            acc[j] = _mm256_add_epi64(acc[j], _mm256_and_si256(b, m));
+        }
+    }
+    for (int j = 0; j < DP_SIMD_WIDTH / 4; j++) _mm256_storeu_si256((__m256i*)(t + 4 * j), acc[j]);
+}
+
+__attribute__((target("avx512f")))
+static void transition_avx512(const uint64_t* row, uint32_t P, const uint64_t* masks, uint64_t* t)
+{
+    __m512i acc[DP_SIMD_WIDTH / 8];
+    for (int j = 0; j < DP_SIMD_WIDTH / 8; j++) acc[j] = _mm512_setzero_si512();
+    for (uint32_t bits = P; bits; bits &= bits - 1) {
+        int u = __builtin_ctz(bits);
+        const __m512i b = _mm512_set1_epi64((long long) row[u]);
+        const uint64_t* mrow = masks + (size_t) u * DP_SIMD_WIDTH;
+        for (int j = 0; j < DP_SIMD_WIDTH / 8; j++) {
+            __m512i m = _mm512_loadu_si512((const void*)(mrow + 8 * j));
+            acc[j] = _mm512_add_epi64(acc[j], _mm512_and_si512(b, m));
+        }
+    }
+    for (int j = 0; j < DP_SIMD_WIDTH / 8; j++) _mm512_storeu_si512((void*)(t + 8 * j), acc[j]);
+}
+#endif
+
+// Escolhe o kernel pelo que a CPU suporta em tempo de execução.
+// DENSE_DP_KERNEL=scalar|avx2 força um kernel mais simples (para comparar).
+static TransitionKernel pick_transition_kernel(const char** name)
+{
+    const char* forced = getenv("DENSE_DP_KERNEL");
+    std::string want = forced ? forced : "";
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (want.empty() && __builtin_cpu_supports("avx512f")) { *name = "avx512"; return transition_avx512; }
+    if ((want.empty() || want == "avx2") && __builtin_cpu_supports("avx2")) { *name = "avx2"; return transition_avx2; }
+#endif
+    *name = "scalar";
+    return transition_scalar;
+}
+
+static const char* kernel_name = nullptr;
+static const TransitionKernel transition_simd = pick_transition_kernel(&kernel_name);
+
+const char* dense_dp_kernel_name()
+{
+    return kernel_name;
+}
+
+#pragma omp declare reduction(sat_add : uint64_t : omp_out = sat_add64(omp_out, omp_in)) initializer(omp_priv = 0)
+
+// Soma body(i) para i em [begin, end). Camadas grandes rodam em paralelo:
+// taskloop quando já estamos dentro de uma região paralela (ex.: numa task da
+// v5, onde um parallel aninhado seria serializado), parallel for caso contrário.
+template <typename Body>
+static uint64_t reduce_layer(int64_t begin, int64_t end, Body body)
+{
+    uint64_t total = 0;
+    if (end - begin < DP_PARALLEL_MIN_MASKS) {
+        for (int64_t i = begin; i < end; i++) total = sat_add64(total, body(i));
+    } else if (omp_in_parallel()) {
+        #pragma omp taskloop reduction(sat_add : total) grainsize(DP_PARALLEL_MIN_MASKS / 4)
+        for (int64_t i = begin; i < end; i++) total = sat_add64(total, body(i));
+    } else {
+        #pragma omp parallel for reduction(sat_add : total) schedule(static)
+        for (int64_t i = begin; i < end; i++) total = sat_add64(total, body(i));
+    }
+    return total;
+}
+
+// DP por subconjuntos para os ciclos cujo menor vértice (índice local) é s.
+// Vértices acima de s viram os bits 0..m-1; dp[P*m + v] = número de caminhos
+// simples que saem de s, visitam exatamente P e terminam em v ∈ P. As camadas
+// são processadas por popcount: cada (P ∪ {v}, v) é escrito por um único P,
+// então todas as máscaras de uma camada podem rodar em paralelo.
+//
+// Num grafo simples com k <= DENSE_DP_MAX_VERTICES nenhum contador passa do
+// total de ciclos de K_k, que cabe em 64 bits: usa os kernels SIMD sem
+// checagem. Com multiplicidades usa a versão escalar com saturação.
+static uint64_t dp_cycles_from(int s, const SccMatrix& M, std::vector<uint64_t>& dp, std::vector<uint32_t>& order)
+{
+    const int k = M.k;
+    const int m = k - 1 - s;
+    if (m <= 0) return 0;
+
+    const std::vector<uint64_t>& A = M.A;
+    const uint32_t num_masks = 1u << m;
+    std::vector<uint64_t> up((size_t) m * m), to_s(m), from_s(m);
+    for (int a = 0; a < m; a++) {
+        to_s[a] = A[(size_t)(s + 1 + a) * k + s];
+        from_s[a] = A[(size_t) s * k + (s + 1 + a)];
+        for (int b = 0; b < m; b++)
+            up[(size_t) a * m + b] = A[(size_t)(s + 1 + a) * k + (s + 1 + b)];
+    }
+
+    // Máscaras ordenadas por popcount (counting sort)
+    std::vector<uint32_t> layer_start(m + 2, 0);
+    for (uint32_t P = 0; P < num_masks; P++) layer_start[__builtin_popcount(P) + 1]++;
+    for (int p = 1; p <= m + 1; p++) layer_start[p] += layer_start[p - 1];
+    order.resize(num_masks);
+    {
+        std::vector<uint32_t> fill(layer_start.begin(), layer_start.end() - 1);
+        for (uint32_t P = 0; P < num_masks; P++) order[fill[__builtin_popcount(P)]++] = P;
+    }
+
+    dp.resize((size_t) num_masks * m);
+    for (int v = 0; v < m; v++) dp[(size_t)(1u << v) * m + v] = from_s[v];
+
+    // Linhas de A como máscaras de 64 bits, com padding até DP_SIMD_WIDTH
+    std::vector<uint64_t> masks;
+    if (M.simple) {
+        masks.assign((size_t) m * DP_SIMD_WIDTH, 0);
+        for (int a = 0; a < m; a++)
+            for (int b = 0; b < m; b++)
+                masks[(size_t) a * DP_SIMD_WIDTH + b] = up[(size_t) a * m + b] ? ~(uint64_t) 0 : 0;
+    }
+
+    uint64_t cycles = 0;
+    for (int p = 1; p <= m; p++) {
+        const bool last = (p == m);
+
+        auto simple_body = [&](int64_t i) -> uint64_t {
+            const uint32_t P = order[i];
+            const uint64_t* row = &dp[(size_t) P * m];
+            uint64_t closed = 0;
+            for (uint32_t bits = P; bits; bits &= bits - 1) {
+                int u = __builtin_ctz(bits);
+                closed += to_s[u] ? row[u] : 0;
+            }
+            if (last) return closed;
+
+            alignas(64) uint64_t t[DP_SIMD_WIDTH];
+            transition_simd(row, P, masks.data(), t);
+            for (uint32_t bits = ~P & (num_masks - 1); bits; bits &= bits - 1) {
+                int v = __builtin_ctz(bits);
+                dp[(size_t)(P | (1u << v)) * m + v] = t[v];
+            }
+            return closed;
+        };
+
+        auto checked_body = [&](int64_t i) -> uint64_t {
+            const uint32_t P = order[i];
+            const uint64_t* row = &dp[(size_t) P * m];
+            uint64_t closed = 0;
+            for (uint32_t bits = P; bits; bits &= bits - 1) {
+                int u = __builtin_ctz(bits);
+                closed = sat_add64(closed, sat_mul64(row[u], to_s[u]));
+            }
+            if (last) return closed;
+
+            for (uint32_t vbits = ~P & (num_masks - 1); vbits; vbits &= vbits - 1) {
+                int v = __builtin_ctz(vbits);
+                uint64_t t = 0;
+                for (uint32_t bits = P; bits; bits &= bits - 1) {
+                    int u = __builtin_ctz(bits);
+                    t = sat_add64(t, sat_mul64(row[u], up[(size_t) u * m + v]));
+                }
+                dp[(size_t)(P | (1u << v)) * m + v] = t;
+            }
+            return closed;
+        };
+
+        const int64_t begin = layer_start[p], end = layer_start[p + 1];
+        uint64_t layer = M.simple ? reduce_layer(begin, end, simple_body)
+                                  : reduce_layer(begin, end, checked_body);
+        cycles = sat_add64(cycles, layer);
+    }
+
+    return cycles;
+}
+
+// Monta a matriz de adjacência local da SCC. A matriz k x k só é preenchida
+// quando a SCC é pequena ou quase completa (aí ela tem o tamanho da própria
+// lista de arestas); caso contrário fica vazia.
+static SccMatrix build_scc_matrix(Graph G, const std::vector<int>& scc_vertices)
+{
+    SccMatrix M;
+    M.k = (int) scc_vertices.size();
+    M.verts = scc_vertices;
+    std::sort(M.verts.begin(), M.verts.end());
+    const int k = M.k;
+
+    auto local_id = [&](int v) -> int {
+        auto it = std::lower_bound(M.verts.begin(), M.verts.end(), v);
+        return (it != M.verts.end() && *it == v) ? (int)(it - M.verts.begin()) : -1;
+    };
+
+    // Arestas internas (auto-laços à parte: cada um é um ciclo)
+    M.internal_edges = 0;
+    M.self_loops.assign(k, 0);
+    for (int a = 0; a < k; a++) {
+        int v = M.verts[a];
+        for (const Vertex* w = outgoing_begin(G, v); w != outgoing_end(G, v); ++w) {
+            if (*w == v) M.self_loops[a]++;
+            else if (local_id(*w) >= 0) M.internal_edges++;
+        }
+    }
+
+    const int64_t complete_edges = (int64_t) k * (k - 1);
+    M.maybe_near_complete = M.internal_edges >= complete_edges - DENSE_MAX_MISSING_EDGES;
+    M.simple = true;
+    if (!M.maybe_near_complete && k > DENSE_DP_MAX_VERTICES) return M;
+
+    M.A.assign((size_t) k * k, 0);
+    for (int a = 0; a < k; a++) {
+        int v = M.verts[a];
+        for (const Vertex* w = outgoing_begin(G, v); w != outgoing_end(G, v); ++w) {
+            int b = (*w == v) ? -1 : local_id(*w);
+            if (b < 0) continue;
+            if (++M.A[(size_t) a * k + b] > 1) M.simple = false;
+        }
+    }
+    return M;
+}
+
+DenseCountResult dense_scc_count(Graph G, const std::vector<int>& scc_vertices, cycle_count_t& count)
+{
+    const int k = (int) scc_vertices.size();
+    if (k == 0) {
+        count = 0;
+        return DENSE_COUNT_DONE;
+    }
+
+    SccMatrix M = build_scc_matrix(G, scc_vertices);
+    if (M.A.empty()) return DENSE_COUNT_UNSUPPORTED;
+
+    uint64_t self_loops = 0;
+    for (uint64_t l : M.self_loops) self_loops = sat_add64(self_loops, l);
+
+    if (M.simple && M.maybe_near_complete) {
+        std::vector<std::pair<int,int>> missing;
+        for (int a = 0; a < k; a++)
+            for (int b = 0; b < k; b++)
+                if (a != b && M.A[(size_t) a * k + b] == 0) missing.emplace_back(a, b);
+
+        if ((int) missing.size() <= DENSE_MAX_MISSING_EDGES) {
+            count = cycle_count_add(near_complete_cycles(k, missing), self_loops);
+            query_cycles(local_count_from(count));
+            query_poll(); // publica já: max_cycles vê a SCC inteira
+            return DENSE_COUNT_DONE;
+        }
+    }
+
+    if (k > DENSE_DP_MAX_VERTICES) return DENSE_COUNT_UNSUPPORTED;
+
+    // Cada s conta para os limites da consulta e publica na hora; parada
+    // antes do último s devolve a parcial, que é o que o QueryGuard já viu
+    std::vector<uint64_t> dp;
+    std::vector<uint32_t> order;
+    uint64_t total = self_loops;
+    query_cycles(self_loops);
+    DenseCountResult result = DENSE_COUNT_DONE;
+    for (int s = 0; s < k; s++) {
+        if (query_poll()) {
+            result = DENSE_COUNT_STOPPED;
+            break;
+        }
+        const uint64_t from_s = dp_cycles_from(s, M, dp, order);
+        query_cycles(from_s);
+        total = sat_add64(total, from_s);
+    }
+    if (result == DENSE_COUNT_DONE) query_poll();
+
+    count = (total == UINT64_MAX) ? CYCLE_COUNT_MAX : (cycle_count_t) total;
+    return result;
+}
+
+bool dense_cycles_from_min(Graph G, const std::vector<int>& scc_vertices, uint64_t& count)
+{
+    const int k = (int) scc_vertices.size();
+    if (k == 0 || k > DENSE_DP_MAX_VERTICES || query_poll()) return false;
+
+    SccMatrix M = build_scc_matrix(G, scc_vertices);
+    std::vector<uint64_t> dp;
+    std::vector<uint32_t> order;
+    count = sat_add64(M.self_loops[0], dp_cycles_from(0, M, dp, order));
+    query_cycles(count);
+    query_poll();
+    return true;
+}
+
+bool dense_dp_preferred(int k, int64_t internal_edges)
+{
+    if (k < DENSE_DP_MIN_VERTICES || k > DENSE_DP_MAX_VERTICES) return false;
+    double density = (double) internal_edges / ((double) k * (k - 1));
+    return density >= DENSE_DP_MIN_DENSITY;
+}
@@ -0,0 +1,105 @@
+#include "johnson.hpp"
+#include "parallel_v0.hpp"
+#include "parallel_v1.hpp"
+#include "parallel_v2.hpp"
+#include "parallel_v3.hpp"
+#include "parallel_v4.hpp"
+#include "parallel_v5.hpp"
+#include "parallel_v6.hpp"
+#include "parallel_v7.hpp"
+#include <omp.h>
+
+const char* cycle_engine_name(CycleEngine engine)
+{
+    switch (engine) {
+        case CYCLE_ENGINE_SEQUENTIAL: return "sequential";
+        case CYCLE_ENGINE_V0: return "v0";
+        case CYCLE_ENGINE_V1: return "v1";
+        case CYCLE_ENGINE_V2: return "v2";
+        case CYCLE_ENGINE_V3: return "v3";
+        case CYCLE_ENGINE_V4: return "v4";
+        case CYCLE_ENGINE_V5: return "v5";
+        case CYCLE_ENGINE_V6: return "v6";
+        case CYCLE_ENGINE_V7: return "v7";
+    }
+    return "?";
+}
+
+CycleEnumerator::CycleEnumerator(Graph G, const CycleEnumeratorOptions& options)
+    : graph(G), opts(options)
+{
+}
+
+CycleEnumerator::~CycleEnumerator() = default;
+
+CycleEnumeratorStats CycleEnumerator::run()
+{
+    CycleEnumeratorStats stats;
+    const bool listing = opts.max_cycles || opts.max_length || opts.sink || opts.through >= 0;
+    stats.engine = listing ? CYCLE_ENGINE_SEQUENTIAL : opts.engine;
+    if (opts.checkpoint && stats.engine != CYCLE_ENGINE_SEQUENTIAL) stats.engine = CYCLE_ENGINE_V5;
+
+    const int saved_threads = omp_get_max_threads();
+    const SCCBackend saved_backend = scc_backend();
+    if (opts.threads > 0) omp_set_num_threads(opts.threads);
+    set_scc_backend(opts.scc_backend);
+    stats.threads = stats.engine == CYCLE_ENGINE_SEQUENTIAL ? 1 : omp_get_max_threads();
+
+    if (opts.compressed && stats.engine == CYCLE_ENGINE_V6 && !compressed_graph) {
+        compressed_graph.reset(new CompressedGraph(compress_graph(graph)));
+    }
+
+    std::unique_ptr<QueryGuard> query;
+    if (opts.limits.any()) query.reset(new QueryGuard(opts.limits));
+
+    double t0 = CycleTimer::currentSeconds();
+    switch (stats.engine) {
+        case CYCLE_ENGINE_SEQUENTIAL: {
+            JohnsonRun run;
+            if (opts.sink) run.sink = &opts.sink;
+            run.max_cycles = opts.max_cycles;
+            run.max_length = opts.max_length;
+            if (opts.through >= 0) {
+                TargetNeighborhood neighborhood;
+                stats.cycles = opts.through_next >= 0
+                                   ? cycles_through_edge(graph, opts.through, opts.through_next, &run, &neighborhood)
+                                   : cycles_through_vertex(graph, opts.through, &run, &neighborhood);
+                stats.neighborhood_vertices = neighborhood.vertices;
+                stats.neighborhood_visited = neighborhood.visited;
+                stats.complete = !run.stopped;
+                stats.scc_seconds = run.scc_time;
+                stats.circuit_seconds = run.circuit_time;
+                break;
+            }
+            run.checkpoint = opts.checkpoint;
+            stats.cycles = johnson_cycles(graph, opts.count_only, &run);
+            stats.complete = !run.stopped;
+            stats.scc_seconds = run.scc_time;
+            stats.circuit_seconds = run.circuit_time;
+            break;
+        }
+        case CYCLE_ENGINE_V0: stats.cycles = johnson_cycles_parallel_v0(graph); break;
+        case CYCLE_ENGINE_V1: stats.cycles = johnson_cycles_parallel_v1(graph); break;
+        case CYCLE_ENGINE_V2: stats.cycles = johnson_cycles_parallel_v2(graph); break;
+        case CYCLE_ENGINE_V3: stats.cycles = johnson_cycles_parallel_v3(graph); break;
+        case CYCLE_ENGINE_V4: stats.cycles = johnson_cycles_parallel_v4(graph); break;
+        case CYCLE_ENGINE_V5: stats.cycles = johnson_cycles_parallel_v5(graph, opts.count_only, opts.checkpoint); break;
+        case CYCLE_ENGINE_V6:
+            stats.cycles = opts.compressed ? johnson_cycles_parallel_v6(compressed_graph.get())
+                                           : johnson_cycles_parallel_v6(graph, opts.count_only);
+            break;
+        case CYCLE_ENGINE_V7: stats.cycles = johnson_cycles_parallel_v7(graph, opts.scheduler); break;
+    }
+    stats.seconds = CycleTimer::currentSeconds() - t0;
+    stats.overflowed = cycle_count_overflowed(stats.cycles);
+    if (query) {
+        stats.stop_reason = query->reason();
+        stats.search_nodes = query->search_nodes();
+        stats.complete = stats.complete && query->exact();
+    }
+    stats.exact = stats.complete && !stats.overflowed;
+
+    set_scc_backend(saved_backend);
+    omp_set_num_threads(saved_threads);
+    return stats;
+}
@@ -4,22 +4,168 @@
 #include <string>
 #include <getopt.h>
 #include <algorithm>
+#include <sys/stat.h>
 
 #include <iostream>
 #include <sstream>
 #include <vector>
+#include <memory>
 
 #include "common/CycleTimer.h"
 #include "common/graph.h"
+#include "common/cycle_count.h"
 #include "parallel_v0.hpp"
 #include "parallel_v1.hpp"
 #include "parallel_v2.hpp"
 #include "parallel_v3.hpp"
 #include "parallel_v4.hpp"
 #include "parallel_v5.hpp"
+#include "parallel_v6.hpp"
+#include "parallel_v7.hpp"
+#include "partition.hpp"
+#include "johnson.hpp"
+#include "reorder.hpp"
 #include "sequencial.hpp"
+#include "scc_multistep.hpp"
+#include "numa_placement.h"
+#include "huge_pages.h"
+#include "perf_counters.h"
+#include "checkpoint.h"
+#include "query_limits.h"
+#include "progress.h"
+#include "server.hpp"
+#include "targeted.hpp"
 
 
+// Conta os ciclos de um diretório gerado por -p, uma parte por vez: a
+// memória é a da maior parte, não a do grafo inteiro
+static int count_partition(const char* dir, int version, bool count_only, bool normalize, TaskScheduler scheduler)
+{
+    std::vector<PartitionPart> parts;
+    if (!load_partition_index(dir, parts)) {
+        std::cerr << "Could not read " << dir << "/" << PARTITION_INDEX_FILE << "\n";
+        return 1;
+    }
+    if (version < 0) version = 7;
+    if (version > 8) {
+        std::cerr << "Invalid -v value. Use 0 (seq), 1 (v0), 2 (v1), 3 (v2), 4 (v3), 5 (v4), 6 (v5), 7 (v6), 8 (v7).\n";
+        return 1;
+    }
+    CycleEnumeratorOptions options;
+    options.engine = (CycleEngine) version; // mesma numeração de -v
+    options.count_only = count_only;
+    options.scc_backend = scc_backend();
+    options.scheduler = scheduler;
+
+    printf("Partition: %s (%zu parts), version %d\n", dir, parts.size(), version);
+    cycle_count_t total = 0;
+    double t0 = CycleTimer::currentSeconds();
+    for (const PartitionPart& part : parts) {
+        double p0 = CycleTimer::currentSeconds();
+        Graph g = load_graph_binary((std::string(dir) + "/" + part.file).c_str());
+        if (normalize) {
+            Graph normalized = normalize_graph(g);
+            free_graph(g);
+            g = normalized;
+        }
+        cycle_count_t cycles = CycleEnumerator(g, options).run().cycles;
+        free_graph(g);
+        total = cycle_count_add(total, cycles);
+        double p1 = CycleTimer::currentSeconds();
+        printf("  %s: %d nodes, %d edges, %d SCCs, %s cycles (%.6f seconds)\n", part.file.c_str(),
+               part.nodes, part.edges, part.sccs, cycle_count_str(cycles).c_str(), p1 - p0);
+    }
+    double t1 = CycleTimer::currentSeconds();
+    printf("----------------------------------------------------------\n");
+    printf("Time taken: %.6f seconds\n", t1 - t0);
+    printf("       Number of simple cycles found: %s\n", cycle_count_str(total).c_str());
+    printf("----------------------------------------------------------\n");
+    return 0;
+}
+
+
+// Contagem longa com checkpoint (-C): só a versão pedida (sequencial ou v5),
+// sem a linha de base; --resume pula os s que o arquivo dá como concluídos
+static int count_with_checkpoint(Graph g, int version, bool count_only, const char* path, bool resume,
+                                 double interval)
+{
+    if (version != 0 && version != 6) {
+        std::cerr << "-C needs -v 0 (sequential) or -v 6 (v5).\n";
+        return 1;
+    }
+    Checkpoint checkpoint(path, g, interval);
+    if (resume) {
+        std::string error;
+        if (!checkpoint.resume(error)) {
+            std::cerr << "Cannot resume: " << error << "\n";
+            return 1;
+        }
+        printf("Checkpoint: %s (resumed: %d of %d start vertices done, %s cycles)\n", path,
+               checkpoint.completed(), g->num_nodes, cycle_count_str(checkpoint.resumed_cycles()).c_str());
+    } else {
+        printf("Checkpoint: %s (every %.0f seconds)\n", path, interval);
+    }
+
+    double t0 = CycleTimer::currentSeconds();
+    cycle_count_t sol;
+    if (version == 0) {
+        JohnsonRun run;
+        run.checkpoint = &checkpoint;
+        sol = johnson_cycles(g, count_only, &run);
+        printf("Sequencial Johnson\n");
+    } else {
+        sol = johnson_cycles_parallel_v5(g, count_only, &checkpoint);
+        printf("Parallel v5 Johnson (Multi-SCC Tasks)\n");
+    }
+    double t1 = CycleTimer::currentSeconds();
+    const bool saved = checkpoint.save();
+    printf("       Time taken: %.6f seconds\n", t1 - t0);
+    printf("       Number of simple cycles found: %s\n", cycle_count_str(sol).c_str());
+    printf("       Checkpoint %s: %d start vertices done\n", saved ? "saved" : "NOT saved", checkpoint.completed());
+    printf("----------------------------------------------------------\n");
+    return saved ? 0 : 1;
+}
+
+// --serve: carrega cada grafo ([nome=]arquivo) uma vez e atende consultas
+// no socket até o comando shutdown
+static int serve_graphs(const char* socket_path, char** files, int count, bool binary, bool normalize)
+{
+    CycleServer server(socket_path);
+    std::vector<Graph> loaded;
+    for (int i = 0; i < count; i++) {
+        std::string name = files[i], path = files[i];
+        const size_t eq = name.find('=');
+        if (eq != std::string::npos) {
+            path = name.substr(eq + 1);
+            name = name.substr(0, eq);
+        } else {
+            name = name.substr(name.find_last_of('/') + 1);
+        }
+        double t0 = CycleTimer::currentSeconds();
+        Graph g = binary ? load_graph_binary(path.c_str()) : load_graph(path.c_str());
+        if (normalize) {
+            Graph normalized = normalize_graph(g);
+            free_graph(g);
+            g = normalized;
+        }
+        loaded.push_back(g);
+        server.add_graph(name, g);
+        printf("Loaded %s: %d nodes, %d edges (%.6f seconds)\n", name.c_str(), g->num_nodes, g->num_edges,
+               CycleTimer::currentSeconds() - t0);
+    }
+
+    std::string error;
+    if (!server.listen(error)) {
+        std::cerr << "Cannot serve: " << error << "\n";
+        for (Graph g : loaded) free_graph(g);
+        return 1;
+    }
+    printf("Serving %d graphs on %s\n", count, socket_path);
+    fflush(stdout);
+    server.serve();
+    for (Graph g : loaded) free_graph(g);
+    return 0;
+}
 
 int main(int argc, char** argv) {
 
@@ -27,14 +173,86 @@ int main(int argc, char** argv) {
     int version = -1;            // -1 => run all; 0 => sequential; 1..5 => v0..v4
     int use_binary_graph = 1;    // 1 => load binary graph; 0 => load from text
     bool eval_mode = false;      // true => run 5x and average middle 3
+    bool count_only = false;     // true => dense SCCs counted without enumeration (sequential, v5, v6)
+    bool multistep = false;      // true => Multistep SCC backend instead of the pivot loop
+    VertexOrder vertex_order = ORDER_ORIGINAL; // -r: relabel vertices at load time
+    bool normalize = true;       // false (-k) => keep duplicate edges and self-loops in the lists
+    bool compressed = false;     // true (-z) => v6 runs on the compressed CSR
+    TaskScheduler scheduler = TASK_SCHEDULER_POOL; // -w: v7 task scheduler
+    NumaPlacement numa_placement = NUMA_PLACEMENT_NONE; // -n: interleave or replicate the graph, pin threads
+    HugePageMode huge_pages = HUGE_PAGES_OFF; // -H: graph and scratch arrays on 2 MB pages
+    const char* partition_dir = NULL; // -p: split the binary file into SCC parts in this directory
+    const char* checkpoint_path = NULL; // -C/--checkpoint: completed start vertices saved here
+    bool resume = false;         // --resume: skip the start vertices the checkpoint marks as done
+    double checkpoint_interval = CHECKPOINT_INTERVAL_SECONDS; // --checkpoint-interval
+    QueryLimits query_limits;    // --max-seconds, --max-search-nodes, --max-cycles: each version stops early
+    double progress_interval = 0.0; // --progress <seconds>: progress line on stderr while each version runs
+    const char* status_file = NULL; // --status-file <file>: the same sample, rewritten in place
+    const char* serve_socket = NULL; // --serve <socket>: load the graphs once and answer queries
+    int through = -1;            // --through V / --through-edge U,V: only the cycles through V (or U->V)
+    int through_next = -1;
 
     std::string graph_filename;
 
-    // Parse flags: -v <int>, -s, -eval
-    // Remaining args: <path/to/graph/file> [num_threads]
+    // Parse flags: -v <int>, -s, -e, -c, -m, -r <order>, -k, -z, -p <dir>, -w <scheduler>, -n <placement>, -H <mode>,
+    // -C/--checkpoint <file>, --resume, --checkpoint-interval <seconds>,
+    // --max-seconds <s>, --max-search-nodes <n>, --max-cycles <n>, --progress <s>, --status-file <file>,
+    // --serve <socket>, --through <v>, --through-edge <u,v>
+    // Remaining args: <path/to/graph/file or partition dir> [num_threads]
+    // (with --serve: [name=]<graph file> ...)
+    static const struct option long_options[] = {
+        {"checkpoint", required_argument, NULL, 'C'},
+        {"resume", no_argument, NULL, 'R'},
+        {"checkpoint-interval", required_argument, NULL, 'I'},
+        {"max-seconds", required_argument, NULL, 'T'},
+        {"max-search-nodes", required_argument, NULL, 'N'},
+        {"max-cycles", required_argument, NULL, 'M'},
+        {"progress", required_argument, NULL, 'P'},
+        {"status-file", required_argument, NULL, 'S'},
+        {"serve", required_argument, NULL, 'D'},
+        {"through", required_argument, NULL, 'V'},
+        {"through-edge", required_argument, NULL, 'E'},
+        {NULL, 0, NULL, 0},
+    };
     int opt;
-    while ((opt = getopt(argc, argv, "v:se")) != -1) {
+    while ((opt = getopt_long(argc, argv, "v:secmr:kzp:w:n:H:C:", long_options, NULL)) != -1) {
         switch (opt) {
+            case 'C':
+                checkpoint_path = optarg;
+                break;
+            case 'R':
+                resume = true;
+                break;
+            case 'I':
+                checkpoint_interval = atof(optarg);
+                break;
+            case 'T':
+                query_limits.max_seconds = atof(optarg);
+                break;
+            case 'N':
+                query_limits.max_search_nodes = strtoull(optarg, NULL, 10);
+                break;
+            case 'M':
+                query_limits.max_cycles = strtoull(optarg, NULL, 10);
+                break;
+            case 'P':
+                progress_interval = atof(optarg);
+                break;
+            case 'S':
+                status_file = optarg;
+                break;
+            case 'D':
+                serve_socket = optarg;
+                break;
+            case 'V':
+                through = atoi(optarg);
+                break;
+            case 'E':
+                if (sscanf(optarg, "%d,%d", &through, &through_next) != 2 || through < 0 || through_next < 0) {
+                    std::cerr << "Invalid --through-edge value. Use U,V.\n";
+                    return 1;
+                }
+                break;
             case 'v':
                 version = atoi(optarg);
                 break;
@@ -44,20 +262,88 @@ int main(int argc, char** argv) {
             case 'e':
                 eval_mode = true;
                 break;
+            case 'c':
+                count_only = true;
+                break;
+            case 'm':
+                multistep = true;
+                break;
+            case 'z':
+                compressed = true;
+                break;
+            case 'k':
+                normalize = false;
+                break;
+            case 'p':
+                partition_dir = optarg;
+                break;
+            case 'n':
+                if (!parse_numa_placement(optarg, numa_placement)) {
+                    std::cerr << "Invalid -n value. Use none, interleave or replicate.\n";
+                    return 1;
+                }
+                break;
+            case 'H':
+                if (!parse_huge_page_mode(optarg, huge_pages)) {
+                    std::cerr << "Invalid -H value. Use off, thp or hugetlb.\n";
+                    return 1;
+                }
+                break;
+            case 'w':
+                if (!parse_task_scheduler(optarg, scheduler)) {
+                    std::cerr << "Invalid -w value. Use pool, omp or steal.\n";
+                    return 1;
+                }
+                break;
+            case 'r':
+                if (!parse_vertex_order(optarg, vertex_order)) {
+                    std::cerr << "Invalid -r value. Use original, degree-asc, degree-desc, scc, rcm or gorder.\n";
+                    return 1;
+                }
+                break;
             default:
-                std::cerr << "Usage: [-v N] [-s] [-e] <path/to/graph/file> [num_threads]\n";
+                std::cerr << "Usage: [-v N] [-s] [-e] [-c] [-m] [-r ORDER] [-k] [-z] [-p DIR] [-w SCHED] [-n PLACEMENT] [-H MODE] [-C FILE [--resume]] <path/to/graph/file or partition dir> [num_threads]\n";
                 return 1;
         }
     }
 
     if (optind >= argc) {
-        std::cerr << "Usage: [-v N] [-s] [-e] <path/to/graph/file> [num_threads]\n";
-        std::cerr << "  -v N : version to execute (0=sequential, 1=v0, 2=v1, 3=v2, 4=v3, 5=v4, 6=v5). If omitted, run all.\n";
+        std::cerr << "Usage: [-v N] [-s] [-e] [-c] [-m] [-r ORDER] [-k] [-z] [-p DIR] [-w SCHED] [-n PLACEMENT] [-H MODE] [-C FILE [--resume]] <path/to/graph/file or partition dir> [num_threads]\n";
+        std::cerr << "  -v N : version to execute (0=sequential, 1=v0, 2=v1, 3=v2, 4=v3, 5=v4, 6=v5, 7=v6, 8=v7). If omitted, run all.\n";
         std::cerr << "  -s   : load graph from text (disable binary).\n";
         std::cerr << "  -e   : evaluation mode - run 5 times and average middle 3.\n";
+        std::cerr << "  -c   : count only - sequential, v5 and v6 count dense/small SCCs without enumerating.\n";
+        std::cerr << "  -m   : Multistep SCC decomposition (trim + FW-BW + coloring) instead of the pivot loop.\n";
+        std::cerr << "  -r O : relabel vertices at load time (original, degree-asc, degree-desc, scc, rcm, gorder).\n";
+        std::cerr << "  -k   : keep duplicate edges and self-loops in the adjacency lists (no normalization).\n";
+        std::cerr << "  -z   : v6 runs on a delta + varint compressed CSR.\n";
+        std::cerr << "  -p D : split the binary graph out of core into one file per SCC group in D,\n";
+        std::cerr << "         then count them; a directory written by -p can be given as the graph.\n";
+        std::cerr << "  -w S : v7 task scheduler (pool, omp, steal).\n";
+        std::cerr << "  -n P : NUMA placement of the graph (none, interleave, replicate); pins threads to nodes.\n";
+        std::cerr << "         NUMA_SIMULATE_NODES=K simulates K nodes on a single-node machine.\n";
+        std::cerr << "  -H M : graph and scratch arrays on 2 MB pages (off, thp, hugetlb); dTLB misses are reported.\n";
+        std::cerr << "  -C F : (--checkpoint) save the completed start vertices and the partial count to F\n";
+        std::cerr << "         every --checkpoint-interval seconds (default 60); only -v 0 or -v 6 runs.\n";
+        std::cerr << "  --resume : continue from the checkpoint in -C, skipping the completed start vertices.\n";
+        std::cerr << "  --max-seconds S, --max-search-nodes N, --max-cycles N : stop each version early\n";
+        std::cerr << "         (checked every 1024 search steps) and report a partial count.\n";
+        std::cerr << "  --progress S : print progress (current s, cycles, nodes/s, ETA) to stderr every S seconds.\n";
+        std::cerr << "  --status-file F : rewrite F with the same sample (every --progress seconds, default 1).\n";
+        std::cerr << "  --through V, --through-edge U,V : count only the cycles through vertex V (or edge U->V),\n";
+        std::cerr << "         searching just the SCC of the target.\n";
+        std::cerr << "  --serve SOCK [name=]FILE ... : keep the graphs loaded and answer count/list queries\n";
+        std::cerr << "         on the Unix socket SOCK (one per line, see include/server.hpp).\n";
         return 1;
     }
 
+    if (serve_socket) {
+        set_huge_page_mode(huge_pages);
+        if (multistep)
+            set_scc_backend(SCC_BACKEND_MULTISTEP);
+        return serve_graphs(serve_socket, argv + optind, argc - optind, use_binary_graph, normalize);
+    }
+
     int thread_count = -1;
     graph_filename = argv[optind++];
     if (optind < argc) {
@@ -65,6 +351,7 @@ int main(int argc, char** argv) {
     }
 
     Graph g;
+    set_huge_page_mode(huge_pages);
 
     printf("----------------------------------------------------------\n");
     printf("Max system threads = %d\n", omp_get_max_threads());
@@ -75,6 +362,34 @@ int main(int argc, char** argv) {
     }
     printf("----------------------------------------------------------\n");
 
+    // Grafo maior que a RAM: SCCs pelo arquivo (-p) e ciclos de uma parte por vez
+    struct stat path_stat;
+    const bool partition_input = stat(graph_filename.c_str(), &path_stat) == 0 && S_ISDIR(path_stat.st_mode);
+    if (partition_dir || partition_input) {
+        if (thread_count > 0)
+            omp_set_num_threads(thread_count);
+        if (multistep)
+            set_scc_backend(SCC_BACKEND_MULTISTEP);
+        if (partition_input) return count_partition(graph_filename.c_str(), version, count_only, normalize, scheduler);
+
+        if (!use_binary_graph) {
+            std::cerr << "-p needs a binary graph file.\n";
+            return 1;
+        }
+        mkdir(partition_dir, 0755);
+        double t0 = CycleTimer::currentSeconds();
+        PartitionStats stats = partition_graph_file(graph_filename.c_str(), partition_dir);
+        double t1 = CycleTimer::currentSeconds();
+        printf("Out-of-core partition: %.6f seconds, %d edge passes, %.2f MB of vertex arrays%s\n",
+               t1 - t0, stats.edge_passes, stats.vertex_bytes / 1e6,
+               stats.in_memory_finish ? ", finished in memory" : "");
+        printf("  Nodes: %d, edges: %d\n", stats.num_nodes, stats.num_edges);
+        printf("  Cyclic SCCs: %d in %zu parts (%lld edges kept)\n", stats.cyclic_sccs, stats.parts.size(),
+               (long long) stats.part_edges);
+        printf("----------------------------------------------------------\n");
+        return count_partition(partition_dir, version, count_only, normalize, scheduler);
+    }
+
     printf("Loading graph...\n");
     if (use_binary_graph) {
         g = load_graph_binary(graph_filename.c_str());
@@ -82,18 +397,127 @@ int main(int argc, char** argv) {
         g = load_graph(graph_filename.c_str());
     }
 
+    // Renumeração opcional; relabeling.old_id mapeia os IDs de volta ao arquivo
+    VertexRelabeling relabeling;
+    if (vertex_order != ORDER_ORIGINAL) {
+        double t0 = CycleTimer::currentSeconds();
+        relabeling = compute_vertex_order(g, vertex_order);
+        Graph relabeled = relabel_graph(g, relabeling);
+        free_graph(g);
+        g = relabeled;
+        double t1 = CycleTimer::currentSeconds();
+        printf("Vertex order: %s (%.6f seconds)\n", vertex_order_name(vertex_order), t1 - t0);
+    }
+
+    // Listas ordenadas e sem repetição; multiplicidades e laços próprios à
+    // parte (as versões multiplicam as multiplicidades ao longo de cada ciclo)
+    int loaded_edges = g->num_edges;
+    if (normalize) {
+        Graph normalized = normalize_graph(g);
+        free_graph(g);
+        g = normalized;
+    }
+
     printf("\n");
     printf("Graph stats:\n");
-    printf("  Edges: %d\n", g->num_edges);
+    printf("  Edges: %d\n", loaded_edges);
+    if (normalize)
+        printf("  Distinct edges: %d (+ %llu self-loops)\n", g->num_edges,
+               (unsigned long long) separate_self_loops(g));
     printf("  Nodes: %d\n", g->num_nodes);
+    // CSR comprimido para a v6: memória e tempo de uma varredura completa
+    // das duas direções, comparados com o CSR comum
+    CompressedGraph compressed_graph;
+    if (compressed) {
+        compressed_graph = compress_graph(g);
+        auto scan = [&](auto G) {
+            uint64_t checksum = 0;
+            double t0 = CycleTimer::currentSeconds();
+            for (int v = 0; v < G->num_nodes; v++) {
+                for (Vertex w : outgoing(G, v)) checksum += w;
+                for (Vertex u : incoming(G, v)) checksum += u;
+            }
+            double t1 = CycleTimer::currentSeconds();
+            return std::make_pair(t1 - t0, checksum);
+        };
+        auto plain_scan = scan(g);
+        auto compressed_scan = scan((const CompressedGraph*) &compressed_graph);
+        double plain_mb = plain_graph_bytes(g) / 1e6;
+        double compressed_mb = compressed_graph.memory_bytes() / 1e6;
+        printf("  Compressed CSR: %.2f MB (plain %.2f MB, %.2fx smaller)\n",
+               compressed_mb, plain_mb, plain_mb / compressed_mb);
+        printf("  Full scan: %.6f s compressed, %.6f s plain%s\n", compressed_scan.first, plain_scan.first,
+               compressed_scan.second == plain_scan.second ? "" : " (MISMATCH)");
+    }
+
     printf("\n");
-    printf("----------------------------------------------------------\n");
+    if (multistep)
+        set_scc_backend(SCC_BACKEND_MULTISTEP);
+    printf("SCC backend: %s\n", scc_backend_name());
 
     if (thread_count > 0)
         omp_set_num_threads(thread_count);
     else
         omp_set_num_threads(omp_get_max_threads());
 
+    // NUMA (-n): threads fixadas nos nós (spread) e arrays do grafo
+    // intercalados ou replicados; NUMA_SIMULATE_NODES=K simula K nós
+    if (numa_placement != NUMA_PLACEMENT_NONE) {
+        double t0 = CycleTimer::currentSeconds();
+        numa_set_pinning(true);
+        numa_pin_omp_threads();
+        if (numa_placement == NUMA_PLACEMENT_INTERLEAVE)
+            numa_interleave_graph(g);
+        else
+            numa_replicate_graph(g);
+        double t1 = CycleTimer::currentSeconds();
+        printf("NUMA: %s (%.6f seconds)\n", numa_describe(numa_placement).c_str(), t1 - t0);
+    } else {
+        huge_pages_graph(g);
+        printf("NUMA: %s\n", numa_describe(numa_placement).c_str());
+    }
+    if (huge_pages != HUGE_PAGES_OFF) {
+        HugePageStats hp = huge_page_stats();
+        int64_t resident = huge_pages_resident_bytes();
+        printf("Huge pages: %s (%.2f MB madvised, %.2f MB hugetlb, %llu fallbacks, %s MB resident in huge pages)\n",
+               huge_page_mode_name(huge_pages), hp.thp_bytes / 1e6, hp.hugetlb_bytes / 1e6,
+               (unsigned long long) hp.fallbacks, resident < 0 ? "?" : std::to_string(resident / 1000000).c_str());
+    }
+    printf("----------------------------------------------------------\n");
+
+    const bool progress = progress_interval > 0.0 || status_file;
+    if ((query_limits.any() || progress) && eval_mode) {
+        std::cerr << "Query limits and progress reporting cannot be combined with -e.\n";
+        numa_free_replicas();
+        free_graph(g);
+        return 1;
+    }
+    // Cada versão roda sob um QueryGuard novo (o relógio começa nela); o
+    // reporter de progresso lê os contadores por thread dele
+    struct QueryScope {
+        std::unique_ptr<QueryGuard> guard;
+        std::unique_ptr<ProgressReporter> reporter;
+    };
+    auto begin_query = [&]() {
+        std::unique_ptr<QueryScope> scope(new QueryScope());
+        if (!query_limits.any() && !progress) return scope;
+        scope->guard.reset(new QueryGuard(query_limits));
+        if (progress) {
+            scope->reporter.reset(new ProgressReporter(*scope->guard, g,
+                                                       progress_interval > 0.0 ? progress_interval : PROGRESS_INTERVAL_SECONDS,
+                                                       progress_interval > 0.0 ? stderr : NULL,
+                                                       status_file ? status_file : ""));
+        }
+        return scope;
+    };
+    auto print_query = [](QueryScope* query) {
+        if (query->reporter) query->reporter->stop();
+        const QueryGuard* guard = query->guard.get();
+        if (guard && !guard->exact())
+            printf("       Stopped early (%s): partial count, about %llu search nodes\n",
+                   query_stop_name(guard->reason()), (unsigned long long) guard->search_nodes());
+    };
+
     // compute average of middle 3 from 5 runs
     auto compute_avg_middle3 = [](std::vector<double>& times) -> double {
         if (times.size() != 5) return times[0];
@@ -104,27 +528,35 @@ int main(int argc, char** argv) {
     auto run_seq = [&](bool print_header) {
         if (eval_mode) {
             std::vector<double> times;
-            int sol = 0;
+            cycle_count_t sol = 0;
             printf("Sequencial Johnson (Evaluation mode: 5 runs)\n");
             for (int i = 0; i < 5; i++) {
+                JohnsonRun run;
                 double t0 = CycleTimer::currentSeconds();
-                sol = johnson_cycles(g);
+                sol = johnson_cycles(g, count_only, &run);
                 double t1 = CycleTimer::currentSeconds();
+                printf("Total SCC time: %.6f seconds\n", run.scc_time);
+                printf("Total circuit time: %.6f seconds\n", run.circuit_time);
                 times.push_back(t1 - t0);
                 printf("       Run %d: %.6f seconds\n", i + 1, t1 - t0);
             }
             double avg_time = compute_avg_middle3(times);
             printf("       Average (middle 3): %.6f seconds\n", avg_time);
-            printf("       Number of simple cycles found: %d\n", sol);
+            printf("       Number of simple cycles found: %s\n", cycle_count_str(sol).c_str());
             printf("----------------------------------------------------------\n");
             return avg_time;
         } else {
+            JohnsonRun run;
+            auto query = begin_query();
             double t0 = CycleTimer::currentSeconds();
-            int sol = johnson_cycles(g);
+            cycle_count_t sol = johnson_cycles(g, count_only, &run);
             double t1 = CycleTimer::currentSeconds();
+            printf("Total SCC time: %.6f seconds\n", run.scc_time);
+            printf("Total circuit time: %.6f seconds\n", run.circuit_time);
             if (print_header) printf("Sequencial Johnson\n       Time taken: %.6f seconds\n", t1 - t0);
             else printf("Time taken: %.6f seconds\n", t1 - t0);
-            printf("       Number of simple cycles found: %d\n", sol);
+            printf("       Number of simple cycles found: %s\n", cycle_count_str(sol).c_str());
+            print_query(query.get());
             printf("----------------------------------------------------------\n");
             return t1 - t0;
         }
@@ -135,7 +567,7 @@ int main(int argc, char** argv) {
     auto run_v0 = [&]() {
         if (eval_mode) {
             std::vector<double> times;
-            int sol = 0;
+            cycle_count_t sol = 0;
             printf("Parallel v0 Johnson (For main loop) - Evaluation mode: 5 runs\n");
             for (int i = 0; i < 5; i++) {
                 double t0 = CycleTimer::currentSeconds();
@@ -146,15 +578,17 @@ int main(int argc, char** argv) {
             }
             double avg_time = compute_avg_middle3(times);
             printf("       Average (middle 3): %.6f seconds\n", avg_time);
-            printf("       Number of simple cycles found: %d\n", sol);
+            printf("       Number of simple cycles found: %s\n", cycle_count_str(sol).c_str());
             if (seq_time > 0.0) printf("       Speedup: %.2f\n", seq_time / avg_time);
             printf("----------------------------------------------------------\n");
         } else {
+            auto query = begin_query();
             double t0 = CycleTimer::currentSeconds();
-            int sol = johnson_cycles_parallel_v0(g);
+            cycle_count_t sol = johnson_cycles_parallel_v0(g);
             double t1 = CycleTimer::currentSeconds();
             printf("Parallel v0 Johnson (For main loop)\n       Time taken: %.6f seconds\n", t1 - t0);
-            printf("       Number of simple cycles found: %d\n", sol);
+            printf("       Number of simple cycles found: %s\n", cycle_count_str(sol).c_str());
+            print_query(query.get());
             if (seq_time > 0.0) printf("       Speedup: %.2f\n", seq_time / (t1 - t0));
             printf("----------------------------------------------------------\n");
         }
@@ -162,7 +596,7 @@ int main(int argc, char** argv) {
     auto run_v1 = [&]() {
         if (eval_mode) {
             std::vector<double> times;
-            int sol = 0;
+            cycle_count_t sol = 0;
             printf("Parallel v1 Johnson (Tasks) - Evaluation mode: 5 runs\n");
             for (int i = 0; i < 5; i++) {
                 double t0 = CycleTimer::currentSeconds();
@@ -173,15 +607,17 @@ int main(int argc, char** argv) {
             }
             double avg_time = compute_avg_middle3(times);
             printf("       Average (middle 3): %.6f seconds\n", avg_time);
-            printf("       Number of simple cycles found: %d\n", sol);
+            printf("       Number of simple cycles found: %s\n", cycle_count_str(sol).c_str());
             if (seq_time > 0.0) printf("       Speedup: %.2f\n", seq_time / avg_time);
             printf("----------------------------------------------------------\n");
         } else {
+            auto query = begin_query();
             double t0 = CycleTimer::currentSeconds();
-            int sol = johnson_cycles_parallel_v1(g);
+            cycle_count_t sol = johnson_cycles_parallel_v1(g);
             double t1 = CycleTimer::currentSeconds();
             printf("Parallel v1 Johnson (Tasks)\n       Time taken: %.6f seconds\n", t1 - t0);
-            printf("       Number of simple cycles found: %d\n", sol);
+            printf("       Number of simple cycles found: %s\n", cycle_count_str(sol).c_str());
+            print_query(query.get());
             if (seq_time > 0.0) printf("       Speedup: %.2f\n", seq_time / (t1 - t0));
             printf("----------------------------------------------------------\n");
         }
@@ -189,7 +625,7 @@ int main(int argc, char** argv) {
     auto run_v2 = [&]() {
         if (eval_mode) {
             std::vector<double> times;
-            int sol = 0;
+            cycle_count_t sol = 0;
             printf("Parallel v2 Johnson (Taskgroup) - Evaluation mode: 5 runs\n");
             for (int i = 0; i < 5; i++) {
                 double t0 = CycleTimer::currentSeconds();
@@ -200,15 +636,17 @@ int main(int argc, char** argv) {
             }
             double avg_time = compute_avg_middle3(times);
             printf("       Average (middle 3): %.6f seconds\n", avg_time);
-            printf("       Number of simple cycles found: %d\n", sol);
+            printf("       Number of simple cycles found: %s\n", cycle_count_str(sol).c_str());
             if (seq_time > 0.0) printf("       Speedup: %.2f\n", seq_time / avg_time);
             printf("----------------------------------------------------------\n");
         } else {
+            auto query = begin_query();
             double t0 = CycleTimer::currentSeconds();
-            int sol = johnson_cycles_parallel_v2(g);
+            cycle_count_t sol = johnson_cycles_parallel_v2(g);
             double t1 = CycleTimer::currentSeconds();
             printf("Parallel v2 Johnson (Taskgroup)\n       Time taken: %.6f seconds\n", t1 - t0);
-            printf("       Number of simple cycles found: %d\n", sol);
+            printf("       Number of simple cycles found: %s\n", cycle_count_str(sol).c_str());
+            print_query(query.get());
             if (seq_time > 0.0) printf("       Speedup: %.2f\n", seq_time / (t1 - t0));
             printf("----------------------------------------------------------\n");
         }
@@ -216,7 +654,7 @@ int main(int argc, char** argv) {
     auto run_v3 = [&]() {
         if (eval_mode) {
             std::vector<double> times;
-            int sol = 0;
+            cycle_count_t sol = 0;
             printf("Parallel v3 Johnson (Hybrid) - Evaluation mode: 5 runs\n");
             for (int i = 0; i < 5; i++) {
                 double t0 = CycleTimer::currentSeconds();
@@ -227,15 +665,17 @@ int main(int argc, char** argv) {
             }
             double avg_time = compute_avg_middle3(times);
             printf("       Average (middle 3): %.6f seconds\n", avg_time);
-            printf("       Number of simple cycles found: %d\n", sol);
+            printf("       Number of simple cycles found: %s\n", cycle_count_str(sol).c_str());
             if (seq_time > 0.0) printf("       Speedup: %.2f\n", seq_time / avg_time);
             printf("----------------------------------------------------------\n");
         } else {
+            auto query = begin_query();
             double t0 = CycleTimer::currentSeconds();
-            int sol = johnson_cycles_parallel_v3(g);
+            cycle_count_t sol = johnson_cycles_parallel_v3(g);
             double t1 = CycleTimer::currentSeconds();
             printf("Parallel v3 Johnson (Hybrid)\n       Time taken: %.6f seconds\n", t1 - t0);
-            printf("       Number of simple cycles found: %d\n", sol);
+            printf("       Number of simple cycles found: %s\n", cycle_count_str(sol).c_str());
+            print_query(query.get());
             if (seq_time > 0.0) printf("       Speedup: %.2f\n", seq_time / (t1 - t0));
             printf("----------------------------------------------------------\n");
         }
@@ -243,7 +683,7 @@ int main(int argc, char** argv) {
     auto run_v4 = [&]() {
         if (eval_mode) {
             std::vector<double> times;
-            int sol = 0;
+            cycle_count_t sol = 0;
             printf("Parallel v4 Johnson (Window Spawn) - Evaluation mode: 5 runs\n");
             for (int i = 0; i < 5; i++) {
                 double t0 = CycleTimer::currentSeconds();
@@ -254,15 +694,17 @@ int main(int argc, char** argv) {
             }
             double avg_time = compute_avg_middle3(times);
             printf("       Average (middle 3): %.6f seconds\n", avg_time);
-            printf("       Number of simple cycles found: %d\n", sol);
+            printf("       Number of simple cycles found: %s\n", cycle_count_str(sol).c_str());
             if (seq_time > 0.0) printf("       Speedup: %.2f\n", seq_time / avg_time);
             printf("----------------------------------------------------------\n");
         } else {
+            auto query = begin_query();
             double t0 = CycleTimer::currentSeconds();
-            int sol = johnson_cycles_parallel_v4(g);
+            cycle_count_t sol = johnson_cycles_parallel_v4(g);
             double t1 = CycleTimer::currentSeconds();
             printf("Parallel v4 Johnson (Window Spawn)\n       Time taken: %.6f seconds\n", t1 - t0);
-            printf("       Number of simple cycles found: %d\n", sol);
+            printf("       Number of simple cycles found: %s\n", cycle_count_str(sol).c_str());
+            print_query(query.get());
             if (seq_time > 0.0) printf("       Speedup: %.2f\n", seq_time / (t1 - t0));
             printf("----------------------------------------------------------\n");
         }
@@ -270,31 +712,148 @@ int main(int argc, char** argv) {
     auto run_v5 = [&]() {
         if (eval_mode) {
             std::vector<double> times;
-            int sol = 0;
+            cycle_count_t sol = 0;
             printf("Parallel v5 Johnson (Multi-SCC Tasks) - Evaluation mode: 5 runs\n");
             for (int i = 0; i < 5; i++) {
                 double t0 = CycleTimer::currentSeconds();
-                sol = johnson_cycles_parallel_v5(g);
+                sol = johnson_cycles_parallel_v5(g, count_only);
                 double t1 = CycleTimer::currentSeconds();
                 times.push_back(t1 - t0);
                 printf("       Run %d: %.6f seconds\n", i + 1, t1 - t0);
             }
             double avg_time = compute_avg_middle3(times);
             printf("       Average (middle 3): %.6f seconds\n", avg_time);
-            printf("       Number of simple cycles found: %d\n", sol);
+            printf("       Number of simple cycles found: %s\n", cycle_count_str(sol).c_str());
             if (seq_time > 0.0) printf("       Speedup: %.2f\n", seq_time / avg_time);
             printf("----------------------------------------------------------\n");
         } else {
+            auto query = begin_query();
             double t0 = CycleTimer::currentSeconds();
-            int sol = johnson_cycles_parallel_v5(g);
+            cycle_count_t sol = johnson_cycles_parallel_v5(g, count_only);
             double t1 = CycleTimer::currentSeconds();
             printf("Parallel v5 Johnson (Multi-SCC Tasks)\n       Time taken: %.6f seconds\n", t1 - t0);
-            printf("       Number of simple cycles found: %d\n", sol);
+            printf("       Number of simple cycles found: %s\n", cycle_count_str(sol).c_str());
+            print_query(query.get());
+            if (seq_time > 0.0) printf("       Speedup: %.2f\n", seq_time / (t1 - t0));
+            printf("----------------------------------------------------------\n");
+        }
+    };
+
+    auto run_v6 = [&]() {
+        if (eval_mode) {
+            std::vector<double> times;
+            cycle_count_t sol = 0;
+            printf("Parallel v6 Johnson (SCC Jobs%s) - Evaluation mode: 5 runs\n", compressed ? ", compressed CSR" : "");
+            for (int i = 0; i < 5; i++) {
+                double t0 = CycleTimer::currentSeconds();
+                sol = compressed ? johnson_cycles_parallel_v6(&compressed_graph)
+                                 : johnson_cycles_parallel_v6(g, count_only);
+                double t1 = CycleTimer::currentSeconds();
+                times.push_back(t1 - t0);
+                printf("       Run %d: %.6f seconds\n", i + 1, t1 - t0);
+            }
+            double avg_time = compute_avg_middle3(times);
+            printf("       Average (middle 3): %.6f seconds\n", avg_time);
+            printf("       Number of simple cycles found: %s\n", cycle_count_str(sol).c_str());
+            if (seq_time > 0.0) printf("       Speedup: %.2f\n", seq_time / avg_time);
+            printf("----------------------------------------------------------\n");
+        } else {
+            auto query = begin_query();
+            double t0 = CycleTimer::currentSeconds();
+            cycle_count_t sol = compressed ? johnson_cycles_parallel_v6(&compressed_graph)
+                                           : johnson_cycles_parallel_v6(g, count_only);
+            double t1 = CycleTimer::currentSeconds();
+            printf("Parallel v6 Johnson (SCC Jobs%s)\n       Time taken: %.6f seconds\n",
+                   compressed ? ", compressed CSR" : "", t1 - t0);
+            printf("       Number of simple cycles found: %s\n", cycle_count_str(sol).c_str());
+            print_query(query.get());
             if (seq_time > 0.0) printf("       Speedup: %.2f\n", seq_time / (t1 - t0));
             printf("----------------------------------------------------------\n");
         }
     };
 
+    auto run_v7 = [&]() {
+        if (eval_mode) {
+            std::vector<double> times;
+            cycle_count_t sol = 0;
+            printf("Parallel v7 Johnson (%s scheduler) - Evaluation mode: 5 runs\n", task_scheduler_name(scheduler));
+            for (int i = 0; i < 5; i++) {
+                double t0 = CycleTimer::currentSeconds();
+                sol = johnson_cycles_parallel_v7(g, scheduler);
+                double t1 = CycleTimer::currentSeconds();
+                times.push_back(t1 - t0);
+                printf("       Run %d: %.6f seconds\n", i + 1, t1 - t0);
+            }
+            double avg_time = compute_avg_middle3(times);
+            printf("       Average (middle 3): %.6f seconds\n", avg_time);
+            printf("       Number of simple cycles found: %s\n", cycle_count_str(sol).c_str());
+            if (seq_time > 0.0) printf("       Speedup: %.2f\n", seq_time / avg_time);
+            printf("----------------------------------------------------------\n");
+        } else {
+            auto query = begin_query();
+            double t0 = CycleTimer::currentSeconds();
+            cycle_count_t sol = johnson_cycles_parallel_v7(g, scheduler);
+            double t1 = CycleTimer::currentSeconds();
+            printf("Parallel v7 Johnson (%s scheduler)\n       Time taken: %.6f seconds\n",
+                   task_scheduler_name(scheduler), t1 - t0);
+            printf("       Number of simple cycles found: %s\n", cycle_count_str(sol).c_str());
+            print_query(query.get());
+            if (seq_time > 0.0) printf("       Speedup: %.2f\n", seq_time / (t1 - t0));
+            printf("----------------------------------------------------------\n");
+        }
+    };
+
+    if (checkpoint_path) {
+        int status = eval_mode ? 1 : count_with_checkpoint(g, version, count_only, checkpoint_path, resume,
+                                                           checkpoint_interval);
+        if (eval_mode) std::cerr << "-C cannot be combined with -e.\n";
+        numa_free_replicas();
+        free_graph(g);
+        return status;
+    }
+    if (resume) {
+        std::cerr << "--resume needs -C FILE.\n";
+        numa_free_replicas();
+        free_graph(g);
+        return 1;
+    }
+
+    // Consulta dirigida: só os ciclos pelo alvo (ids do arquivo, também com -r)
+    if (through >= 0) {
+        const int n = g->num_nodes;
+        if (through >= n || through_next >= n || eval_mode) {
+            std::cerr << (eval_mode ? "--through cannot be combined with -e.\n" : "Target vertex out of range.\n");
+            numa_free_replicas();
+            free_graph(g);
+            return 1;
+        }
+        const int source = relabeling.new_id.empty() ? through : relabeling.new_id[through];
+        const int target = through_next < 0 || relabeling.new_id.empty() ? through_next : relabeling.new_id[through_next];
+        auto query = begin_query();
+        JohnsonRun run;
+        TargetNeighborhood neighborhood;
+        double t0 = CycleTimer::currentSeconds();
+        cycle_count_t sol = target >= 0 ? cycles_through_edge(g, source, target, &run, &neighborhood)
+                                        : cycles_through_vertex(g, source, &run, &neighborhood);
+        double t1 = CycleTimer::currentSeconds();
+        if (through_next >= 0) printf("Cycles through edge %d -> %d\n", through, through_next);
+        else printf("Cycles through vertex %d\n", through);
+        printf("       Time taken: %.6f seconds (local SCC %.6f, circuit %.6f)\n", t1 - t0, run.scc_time,
+               run.circuit_time);
+        printf("       Target SCC: %d vertices, %lld edges (%lld vertices visited of %d)\n", neighborhood.vertices,
+               (long long) neighborhood.edges, (long long) neighborhood.visited, n);
+        printf("       Number of simple cycles found: %s\n", cycle_count_str(sol).c_str());
+        print_query(query.get());
+        printf("----------------------------------------------------------\n");
+        numa_free_replicas();
+        free_graph(g);
+        return 0;
+    }
+
+    // Faltas na dTLB de todas as versões executadas (para comparar -H)
+    DtlbMissCounter tlb;
+    tlb.start();
+
     if (version < 0) {
         // Run all versions
         seq_time = run_seq(true);
@@ -304,6 +863,8 @@ int main(int argc, char** argv) {
         run_v3();
         run_v4();
         run_v5();
+        run_v6();
+        run_v7();
     } else {
         // Run a specific version
         switch (version) {
@@ -334,13 +895,28 @@ int main(int argc, char** argv) {
                 seq_time = run_seq(true);
                 run_v5();
                 break;
+            case 7:
+                seq_time = run_seq(true);
+                run_v6();
+                break;
+            case 8:
+                seq_time = run_seq(true);
+                run_v7();
+                break;
             default:
-                std::cerr << "Invalid -v value. Use 0 (seq), 1 (v0), 2 (v1), 3 (v2), 4 (v3), 5 (v4), 6 (v5).\n";
-                delete g;
+                std::cerr << "Invalid -v value. Use 0 (seq), 1 (v0), 2 (v1), 3 (v2), 4 (v3), 5 (v4), 6 (v5), 7 (v6), 8 (v7).\n";
+                numa_free_replicas();
+                free_graph(g);
                 return 1;
         }
     }
 
-    delete g;
+    if (tlb.stop())
+        printf("dTLB load misses (OpenMP threads): %llu\n", (unsigned long long) tlb.misses());
+    else
+        printf("dTLB load misses: unavailable (%s)\n", tlb.error().c_str());
+
+    numa_free_replicas();
+    free_graph(g);
     return 0;
 }
@@ -1,4 +1,8 @@
-
+#include "parallel_v0.hpp"
+#include "trim.hpp"
+#include "scc_multistep.hpp"
+#include "query_limits.h"
+#include "numa_placement.h"
 #include <iostream>
 #include <algorithm>
 #include <unordered_set>
@@ -8,78 +12,82 @@
 
 #define DEBUG 0
 
-std::vector<std::vector<int>> BFS_foward_backward_SCCs_v0(Graph G, const std::vector<int>& active, int min_vertex){
-    
-    std::vector<std::vector<int>> SCCs;
-    std::vector<int> removed(G->num_nodes, 0);
-    
-    for (int i = 0; i < G->num_nodes; i++) {
-        if (active[i] == 0 || i < min_vertex) {
-            removed[i] = 1;
-        }
+std::vector<std::vector<int>> BFS_foward_backward_SCCs_v0(Graph G, const std::vector<int>& active, int min_vertex,
+            SCCScratch& scratch){
+
+    if (scc_backend() == SCC_BACKEND_MULTISTEP) {
+        return multistep_SCCs(G, active, min_vertex, scratch);
     }
 
-    for (int pivot = min_vertex; pivot < G->num_nodes; pivot++) {
+    std::vector<std::vector<int>> SCCs;
+    scratch.resize(G->num_nodes);
+    EpochMarks& assigned = scratch.assigned;
+    assigned.clear();
+    auto removed = [&](int v) {
+        return active[v] == 0 || v < min_vertex || assigned.marked(v);
+    };
 
-        if (removed[pivot] == 1) continue; 
+    trim_trivial_sccs(G, active, min_vertex, scratch, SCCs);
 
-        // Forward BFS
-        std::vector<bool> visited_fwd(G->num_nodes, false);
-        std::vector<int> frontier_fwd;
-        frontier_fwd.push_back(pivot);
-        visited_fwd[pivot] = true;
+    EpochMarks& visited_fwd = scratch.visited_fwd;
+    EpochMarks& visited_bwd = scratch.visited_bwd;
+    std::vector<int>& reached_fwd = scratch.reached_fwd;
+    FrontierBuffers& frontier = scratch.frontier;
 
-        while (!frontier_fwd.empty()) {
-            std::vector<int> new_frontier;
-            for (int u : frontier_fwd) {
+    for (int pivot = min_vertex; pivot < G->num_nodes; pivot++) {
+        if (removed(pivot)) continue;
+
+        visited_fwd.clear();
+        reached_fwd.clear();
+        frontier.start(pivot);
+        visited_fwd.mark(pivot);
+        reached_fwd.push_back(pivot);
+
+        while (!frontier.current.empty()) {
+            for (int u : frontier.current) {
                 const Vertex* out_begin = outgoing_begin(G, u);
                 const Vertex* out_end = outgoing_end(G, u);
                 for (const Vertex* neighbor = out_begin; neighbor != out_end; ++neighbor) {
                     int v = *neighbor;
-                    if (removed[v] == 0 && !visited_fwd[v]) {
-                        visited_fwd[v] = true;
-                        new_frontier.push_back(v);
+                    if (!removed(v) && !visited_fwd.marked(v)) {
+                        visited_fwd.mark(v);
+                        reached_fwd.push_back(v);
+                        frontier.next.push_back(v);
                     }
                 }
             }
-            frontier_fwd = new_frontier;
+            frontier.advance();
         }
 
-        // Backward BFS
-        std::vector<bool> visited_bwd(G->num_nodes, false);
-        std::vector<int> frontier_bwd;
-        frontier_bwd.push_back(pivot);
-        visited_bwd[pivot] = true;
+        // o backward só precisa andar dentro do que o forward alcançou
+        visited_bwd.clear();
+        frontier.start(pivot);
+        visited_bwd.mark(pivot);
 
-        while (!frontier_bwd.empty()) {
-            std::vector<int> new_frontier;
-            for (int u : frontier_bwd) {
+        while (!frontier.current.empty()) {
+            for (int u : frontier.current) {
                 const Vertex* in_begin = incoming_begin(G, u);
                 const Vertex* in_end = incoming_end(G, u);
                 for (const Vertex* neighbor = in_begin; neighbor != in_end; ++neighbor) {
                     int v = *neighbor;
-                    if (removed[v] == 0 && !visited_bwd[v]) {
-                        visited_bwd[v] = true;
-                        new_frontier.push_back(v);
+                    if (visited_fwd.marked(v) && !visited_bwd.marked(v)) {
+                        visited_bwd.mark(v);
+                        frontier.next.push_back(v);
                     }
                 }
             }
-            frontier_bwd = new_frontier;
+            frontier.advance();
         }
 
-        // Intersecção = vértices alcançáveis nos dois sentidos = SCC
         std::vector<int> current_SCC;
-        for (int i = 0; i < G->num_nodes; i++) {
-            if (visited_fwd[i] && visited_bwd[i]) {
-                current_SCC.push_back(i);
-                removed[i] = 1; 
+        for (int v : reached_fwd) {
+            if (visited_bwd.marked(v)) {
+                current_SCC.push_back(v);
+                assigned.mark(v);
             }
         }
 
-        // Adiciona SCC encontrada (mesmo se tiver 1 vértice)
-        if (!current_SCC.empty()) {
-            SCCs.push_back(current_SCC);
-        }
+        SCCs.push_back(std::move(current_SCC));
     }
 
     return SCCs;
@@ -96,9 +104,13 @@ void unblock_v0(int u, std::vector<bool>& blocked, std::vector<std::unordered_se
 }
 
 
+template <bool WEIGHTED>
 bool circuit_v0(int v, int s, Graph G, const std::unordered_set<int>& scc_set,
             std::vector<bool>& blocked, std::vector<std::unordered_set<int>>& B,
-        int& cycle_count) {
+        uint64_t& cycle_count, uint64_t path_weight = 1) {
+
+    // Consulta parada (limite ou cancelamento): volta sem mexer no estado
+    if (query_step()) return false;
 
     bool found_cycle = false;
     blocked[v] = true;
@@ -115,10 +127,12 @@ bool circuit_v0(int v, int s, Graph G, const std::unordered_set<int>& scc_set,
 
         if (w == s) {
             // Ciclo encontrado
-            cycle_count++;
+            const uint64_t weight = extend_path_weight<WEIGHTED>(path_weight, edge_multiplicity(G, neighbor));
+            cycle_count = local_count_add(cycle_count, weight);
+            query_cycles(weight);
             found_cycle = true;
         } else if (!blocked[w]) {
-            if (circuit_v0(w, s, G, scc_set, blocked, B, cycle_count)) {
+            if (circuit_v0<WEIGHTED>(w, s, G, scc_set, blocked, B, cycle_count, extend_path_weight<WEIGHTED>(path_weight, edge_multiplicity(G, neighbor)))) {
                 found_cycle = true;
             }
         }
@@ -142,30 +156,34 @@ bool circuit_v0(int v, int s, Graph G, const std::unordered_set<int>& scc_set,
 }
 
 
-int johnson_cycles_parallel_v0(Graph G) {
+cycle_count_t johnson_cycles_parallel_v0(Graph G) {
     int n = G->num_nodes;
-    int cycle_count = 0;
+    const bool weighted = has_edge_multiplicity(G); // senão todo caminho vale 1
+    PerThreadCounts cycle_count;
+    query_unordered(); // progresso: as threads terminam os s fora de ordem
     std::vector<int> active(G->num_nodes, 1);
+    trim_acyclic_vertices(G, active);
     
     
     #pragma omp parallel
     {
-        int local_cycle_count = 0;
+        uint64_t local_cycle_count = 0;
+        SCCScratch scc_scratch; // um rascunho por thread, reaproveitado a cada s
+        Graph LG = numa_local_graph(G); // réplica do nó desta thread (-n replicate)
         
         // paralelização do loop principal sobre s, cada thread processa valores diferentes de s
         #pragma omp for schedule(dynamic, 1)
         for (int s = 0; s < n; s++) {
+            if (query_poll(s)) continue; // consulta parada: os s restantes só passam
+            if (!active[s]) { // não está em nenhum ciclo (trim global)
+                query_finished(s);
+                continue;
+            }
 
             double start = CycleTimer::currentSeconds();
             
-            // cópia local 
-            std::vector<int> local_active = active;
-            
-            for (int i = 0; i < s; i++) {
-                local_active[i] = 0;
-            }
-            
-            std::vector<std::vector<int>> SCCs = BFS_foward_backward_SCCs_v0(G, local_active, s);
+            // vértices < s já são ignorados via min_vertex; não precisa copiar active
+            std::vector<std::vector<int>> SCCs = BFS_foward_backward_SCCs_v0(LG, active, s, scc_scratch);
             
             std::vector<int> scc_vertices;
             for (const std::vector<int>& scc : SCCs) {
@@ -176,6 +194,7 @@ int johnson_cycles_parallel_v0(Graph G) {
             }
             
             if (scc_vertices.empty()) {
+                query_finished(s);
                 continue;
             }
             
@@ -184,19 +203,22 @@ int johnson_cycles_parallel_v0(Graph G) {
             std::vector<std::unordered_set<int>> B(n);
  
             
-            circuit_v0(s, s, G, scc_set, blocked, B, local_cycle_count);
+            if (weighted) circuit_v0<true>(s, s, LG, scc_set, blocked, B, local_cycle_count);
+            else circuit_v0<false>(s, s, LG, scc_set, blocked, B, local_cycle_count);
+            query_finished(s); // fora de ordem entre threads: o progresso conta cada s
 
             double end = CycleTimer::currentSeconds();
 
             if (DEBUG) { //debug de gargalo
-                printf("Thread %d processed s=%d in %.6f seconds, found %d cycles.\n",
-                       omp_get_thread_num(), s, end - start, local_cycle_count);
+                printf("Thread %d processed s=%d in %.6f seconds, found %llu cycles.\n",
+                       omp_get_thread_num(), s, end - start, (unsigned long long) local_cycle_count);
             }
         }
         
-        #pragma omp atomic
-        cycle_count += local_cycle_count;
+        // redução única por thread, fora do laço
+        cycle_count.add(local_count_total(local_cycle_count));
     }
     
-    return cycle_count;
+    cycle_count.add(separate_self_loops(G)); // laços separados pela normalização
+    return cycle_count.total();
 }
\ No newline at end of file
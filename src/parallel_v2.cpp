@@ -1,75 +1,88 @@
 #include "parallel_v2.hpp"
+#include "trim.hpp"
+#include "scc_multistep.hpp"
+#include "query_limits.h"
 
 #define PARALLEL_DEPTH 4
 #define PARALLEL_BRANCH 2
 #define DEBUG 0
 
-std::vector<std::vector<int>> BFS_foward_backward_SCCs_v2(Graph G, const std::vector<int>& active, int min_vertex){
+std::vector<std::vector<int>> BFS_foward_backward_SCCs_v2(Graph G, const std::vector<int>& active, int min_vertex,
+            SCCScratch& scratch){
 
-    std::vector<std::vector<int>> SCCs;
-    std::vector<int> removed(G->num_nodes, 0);
-    for (int i = 0; i < G->num_nodes; i++) {
-        if (active[i] == 0 || i < min_vertex) {
-            removed[i] = 1;
-        }
+    if (scc_backend() == SCC_BACKEND_MULTISTEP) {
+        return multistep_SCCs(G, active, min_vertex, scratch);
     }
 
+    std::vector<std::vector<int>> SCCs;
+    scratch.resize(G->num_nodes);
+    EpochMarks& assigned = scratch.assigned;
+    assigned.clear();
+    auto removed = [&](int v) {
+        return active[v] == 0 || v < min_vertex || assigned.marked(v);
+    };
+
+    trim_trivial_sccs(G, active, min_vertex, scratch, SCCs);
+
+    EpochMarks& visited_fwd = scratch.visited_fwd;
+    EpochMarks& visited_bwd = scratch.visited_bwd;
+    std::vector<int>& reached_fwd = scratch.reached_fwd;
+    FrontierBuffers& frontier = scratch.frontier;
+
     for (int pivot = min_vertex; pivot < G->num_nodes; pivot++) {
-        if (removed[pivot] == 1) continue;
+        if (removed(pivot)) continue;
 
-        std::vector<bool> visited_fwd(G->num_nodes, false);
-        std::vector<int> frontier_fwd;
-        frontier_fwd.push_back(pivot);
-        visited_fwd[pivot] = true;
+        visited_fwd.clear();
+        reached_fwd.clear();
+        frontier.start(pivot);
+        visited_fwd.mark(pivot);
+        reached_fwd.push_back(pivot);
 
-        while (!frontier_fwd.empty()) {
-            std::vector<int> new_frontier;
-            for (int u : frontier_fwd) {
+        while (!frontier.current.empty()) {
+            for (int u : frontier.current) {
                 const Vertex* out_begin = outgoing_begin(G, u);
                 const Vertex* out_end = outgoing_end(G, u);
                 for (const Vertex* neighbor = out_begin; neighbor != out_end; ++neighbor) {
                     int v = *neighbor;
-                    if (removed[v] == 0 && !visited_fwd[v]) {
-                        visited_fwd[v] = true;
-                        new_frontier.push_back(v);
+                    if (!removed(v) && !visited_fwd.marked(v)) {
+                        visited_fwd.mark(v);
+                        reached_fwd.push_back(v);
+                        frontier.next.push_back(v);
                     }
                 }
             }
-            frontier_fwd = std::move(new_frontier);
+            frontier.advance();
         }
 
-        std::vector<bool> visited_bwd(G->num_nodes, false);
-        std::vector<int> frontier_bwd;
-        frontier_bwd.push_back(pivot);
-        visited_bwd[pivot] = true;
+        // o backward só precisa andar dentro do que o forward alcançou
+        visited_bwd.clear();
+        frontier.start(pivot);
+        visited_bwd.mark(pivot);
 
-        while (!frontier_bwd.empty()) {
-            std::vector<int> new_frontier;
-            for (int u : frontier_bwd) {
+        while (!frontier.current.empty()) {
+            for (int u : frontier.current) {
                 const Vertex* in_begin = incoming_begin(G, u);
                 const Vertex* in_end = incoming_end(G, u);
                 for (const Vertex* neighbor = in_begin; neighbor != in_end; ++neighbor) {
                     int v = *neighbor;
-                    if (removed[v] == 0 && !visited_bwd[v]) {
-                        visited_bwd[v] = true;
-                        new_frontier.push_back(v);
+                    if (visited_fwd.marked(v) && !visited_bwd.marked(v)) {
+                        visited_bwd.mark(v);
+                        frontier.next.push_back(v);
                     }
                 }
             }
-            frontier_bwd = std::move(new_frontier);
+            frontier.advance();
         }
 
         std::vector<int> current_SCC;
-        for (int i = 0; i < G->num_nodes; i++) {
-            if (visited_fwd[i] && visited_bwd[i]) {
-                current_SCC.push_back(i);
-                removed[i] = 1;
+        for (int v : reached_fwd) {
+            if (visited_bwd.marked(v)) {
+                current_SCC.push_back(v);
+                assigned.mark(v);
             }
         }
 
-        if (!current_SCC.empty()) {
-            SCCs.push_back(std::move(current_SCC));
-        }
+        SCCs.push_back(std::move(current_SCC));
     }
 
     return SCCs;
@@ -87,6 +100,7 @@ void unblock_v2(int u, std::vector<bool>& blocked, std::vector<std::unordered_se
 }
 
 
+template <bool WEIGHTED>
 bool circuit_v2_parallel(
     int v, 
     int s, 
@@ -94,13 +108,17 @@ bool circuit_v2_parallel(
     const std::unordered_set<int>& scc_set,
     std::vector<bool>& blocked, 
     std::vector<std::unordered_set<int>>& B,
-    int& cycle_count, int depth = 0
+    uint64_t& cycle_count, int depth = 0,
+    uint64_t path_weight = 1 // produto das multiplicidades de s até v
 ) {
 
+    // Consulta parada (limite ou cancelamento): volta sem mexer no estado
+    if (query_step()) return false;
+
     bool found_cycle = false;
     blocked[v] = true;
 
-    std::vector<int> neighbors;
+    std::vector<const Vertex*> neighbors; // arestas v -> w que seguem na busca
     const Vertex* out_begin = outgoing_begin(G, v);
     const Vertex* out_end   = outgoing_end(G, v);
     neighbors.reserve(out_end - out_begin); // evita realocações
@@ -108,22 +126,26 @@ bool circuit_v2_parallel(
         int w = *neighbor;
         if (w < s) continue;
         if (scc_set.find(w) == scc_set.end()) continue;
-        neighbors.push_back(w);
+        neighbors.push_back(neighbor);
     }
 
     const int branching = static_cast<int>(neighbors.size());
     const bool allow_spawn = (depth < PARALLEL_DEPTH) && (branching >= PARALLEL_BRANCH);
 
     std::atomic<bool> any_child_found(false);
+    // cada task conta no seu próprio slot; o pai soma depois do taskgroup
+    std::vector<uint64_t> child_cycles(branching, 0);
 
     #pragma omp taskgroup
     {
         for (int i = 0; i < branching; ++i) {
-            int w = neighbors[i];
+            int w = *neighbors[i];
+            if (query_stopped()) break; // consulta parada: não cria mais tarefas
+            const uint64_t weight = extend_path_weight<WEIGHTED>(path_weight, edge_multiplicity(G, neighbors[i]));
 
             if (w == s) {
-                #pragma omp atomic
-                cycle_count++;
+                cycle_count = local_count_add(cycle_count, weight);
+                query_cycles(weight);
                 found_cycle = true; // local ao pai (ok)
 
             } else if (!blocked[w]) {
@@ -132,13 +154,13 @@ bool circuit_v2_parallel(
                     std::vector<bool> blocked_copy = blocked;
                     std::vector<std::unordered_set<int>> B_copy = B;
 
-                    #pragma omp task firstprivate(w, blocked_copy, B_copy, depth) shared(any_child_found, cycle_count, G, scc_set)
+                    #pragma omp task firstprivate(w, i, weight, blocked_copy, B_copy, depth) shared(any_child_found, child_cycles, G, scc_set)
                     {
-                        bool child_res = circuit_v2_parallel(w, s, G, scc_set, blocked_copy, B_copy,cycle_count, depth + 1);
+                        bool child_res = circuit_v2_parallel<WEIGHTED>(w, s, G, scc_set, blocked_copy, B_copy, child_cycles[i], depth + 1, weight);
                         if (child_res) any_child_found.store(true, std::memory_order_relaxed);
                     }
                 } else {
-                    if (circuit_v2_parallel(w, s, G, scc_set, blocked, B, cycle_count, depth + 1)) {
+                    if (circuit_v2_parallel<WEIGHTED>(w, s, G, scc_set, blocked, B, cycle_count, depth + 1, weight)) {
                         found_cycle = true;
                     }
                 }
@@ -150,12 +172,16 @@ bool circuit_v2_parallel(
     if (any_child_found.load(std::memory_order_relaxed)) {
         found_cycle = true;
     }
+    for (uint64_t c : child_cycles) {
+        cycle_count = local_count_add(cycle_count, c);
+    }
 
     if (found_cycle) {
         unblock_v2(v, blocked, B); 
     } else {
       
-        for (int w : neighbors) {
+        for (const Vertex* neighbor : neighbors) {
+            int w = *neighbor;
             B[w].insert(v);
         }
     }
@@ -165,14 +191,22 @@ bool circuit_v2_parallel(
 
 
 
-int johnson_cycles_parallel_v2(Graph G) {
+cycle_count_t johnson_cycles_parallel_v2(Graph G) {
     int n = G->num_nodes;
+    const bool weighted = has_edge_multiplicity(G); // senão todo caminho vale 1
     int s = 0;
-    int cycle_count = 0;
+    SCCScratch scc_scratch; // rascunho da decomposição, reaproveitado a cada s
+    uint64_t cycle_count = 0;
     std::vector<int> active(G->num_nodes, 1); // todos ativos inicialmente
+    trim_acyclic_vertices(G, active);
+
+    while (s < n && !query_poll(s)) {
+        if (!active[s]) { // não está em nenhum ciclo (trim global)
+            s++;
+            continue;
+        }
 
-    while (s < n) {
-        std::vector<std::vector<int>> SCCs = BFS_foward_backward_SCCs_v2(G, active, s);
+        std::vector<std::vector<int>> SCCs = BFS_foward_backward_SCCs_v2(G, active, s, scc_scratch);
 
         std::vector<int> scc_vertices;
         for (const std::vector<int>& scc : SCCs) {
@@ -199,7 +233,8 @@ int johnson_cycles_parallel_v2(Graph G) {
         {
             #pragma omp single
             {
-                circuit_v2_parallel(s, s, G, scc_set, blocked, B, cycle_count, 0);
+                if (weighted) circuit_v2_parallel<true>(s, s, G, scc_set, blocked, B, cycle_count, 0);
+                else circuit_v2_parallel<false>(s, s, G, scc_set, blocked, B, cycle_count, 0);
             }
         
         }
@@ -208,5 +243,6 @@ int johnson_cycles_parallel_v2(Graph G) {
         ++s;
     }
 
-    return cycle_count;
+    // laços separados pela normalização
+    return cycle_count_add(local_count_total(cycle_count), separate_self_loops(G));
 }
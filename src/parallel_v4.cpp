@@ -1,74 +1,87 @@
 #include "parallel_v4.hpp"
+#include "trim.hpp"
+#include "scc_multistep.hpp"
+#include "query_limits.h"
 
 #define PARALLEL_MIN_BRANCH 4
 #define SCC_SEQUENTIAL_RATIO 0.8
 
-std::vector<std::vector<int>> BFS_foward_backward_SCCs_v4(Graph G, const std::vector<int>& active, int min_vertex){
+std::vector<std::vector<int>> BFS_foward_backward_SCCs_v4(Graph G, const std::vector<int>& active, int min_vertex,
+            SCCScratch& scratch){
 
-    std::vector<std::vector<int>> SCCs;
-    std::vector<int> removed(G->num_nodes, 0);
-    for (int i = 0; i < G->num_nodes; i++) {
-        if (active[i] == 0 || i < min_vertex) {
-            removed[i] = 1;
-        }
+    if (scc_backend() == SCC_BACKEND_MULTISTEP) {
+        return multistep_SCCs(G, active, min_vertex, scratch);
     }
 
+    std::vector<std::vector<int>> SCCs;
+    scratch.resize(G->num_nodes);
+    EpochMarks& assigned = scratch.assigned;
+    assigned.clear();
+    auto removed = [&](int v) {
+        return active[v] == 0 || v < min_vertex || assigned.marked(v);
+    };
+
+    trim_trivial_sccs(G, active, min_vertex, scratch, SCCs);
+
+    EpochMarks& visited_fwd = scratch.visited_fwd;
+    EpochMarks& visited_bwd = scratch.visited_bwd;
+    std::vector<int>& reached_fwd = scratch.reached_fwd;
+    FrontierBuffers& frontier = scratch.frontier;
+
     for (int pivot = min_vertex; pivot < G->num_nodes; pivot++) {
-        if (removed[pivot] == 1) continue;
+        if (removed(pivot)) continue;
 
-        std::vector<bool> visited_fwd(G->num_nodes, false);
-        std::vector<int> frontier_fwd;
-        frontier_fwd.push_back(pivot);
-        visited_fwd[pivot] = true;
+        visited_fwd.clear();
+        reached_fwd.clear();
+        frontier.start(pivot);
+        visited_fwd.mark(pivot);
+        reached_fwd.push_back(pivot);
 
-        while (!frontier_fwd.empty()) {
-            std::vector<int> new_frontier;
-            for (int u : frontier_fwd) {
+        while (!frontier.current.empty()) {
+            for (int u : frontier.current) {
                 const Vertex* out_begin = outgoing_begin(G, u);
                 const Vertex* out_end = outgoing_end(G, u);
                 for (const Vertex* neighbor = out_begin; neighbor != out_end; ++neighbor) {
                     int v = *neighbor;
-                    if (removed[v] == 0 && !visited_fwd[v]) {
-                        visited_fwd[v] = true;
-                        new_frontier.push_back(v);
+                    if (!removed(v) && !visited_fwd.marked(v)) {
+                        visited_fwd.mark(v);
+                        reached_fwd.push_back(v);
+                        frontier.next.push_back(v);
                     }
                 }
             }
-            frontier_fwd = std::move(new_frontier);
+            frontier.advance();
         }
 
-        std::vector<bool> visited_bwd(G->num_nodes, false);
-        std::vector<int> frontier_bwd;
-        frontier_bwd.push_back(pivot);
-        visited_bwd[pivot] = true;
+        // o backward só precisa andar dentro do que o forward alcançou
+        visited_bwd.clear();
+        frontier.start(pivot);
+        visited_bwd.mark(pivot);
 
-        while (!frontier_bwd.empty()) {
-            std::vector<int> new_frontier;
-            for (int u : frontier_bwd) {
+        while (!frontier.current.empty()) {
+            for (int u : frontier.current) {
                 const Vertex* in_begin = incoming_begin(G, u);
                 const Vertex* in_end = incoming_end(G, u);
                 for (const Vertex* neighbor = in_begin; neighbor != in_end; ++neighbor) {
                     int v = *neighbor;
-                    if (removed[v] == 0 && !visited_bwd[v]) {
-                        visited_bwd[v] = true;
-                        new_frontier.push_back(v);
+                    if (visited_fwd.marked(v) && !visited_bwd.marked(v)) {
+                        visited_bwd.mark(v);
+                        frontier.next.push_back(v);
                     }
                 }
             }
-            frontier_bwd = std::move(new_frontier);
+            frontier.advance();
         }
 
         std::vector<int> current_SCC;
-        for (int i = 0; i < G->num_nodes; i++) {
-            if (visited_fwd[i] && visited_bwd[i]) {
-                current_SCC.push_back(i);
-                removed[i] = 1;
+        for (int v : reached_fwd) {
+            if (visited_bwd.marked(v)) {
+                current_SCC.push_back(v);
+                assigned.mark(v);
             }
         }
 
-        if (!current_SCC.empty()) {
-            SCCs.push_back(std::move(current_SCC));
-        }
+        SCCs.push_back(std::move(current_SCC));
     }
 
     return SCCs;
@@ -85,9 +98,13 @@ void unblock_v4(int u, std::vector<bool>& blocked, std::vector<std::vector<int>>
     B[u].clear();
 }
 
+template <bool WEIGHTED>
 bool circuit_v4_sequential(int v, int s, Graph G, const std::vector<char>& scc_mask,
             std::vector<bool>& blocked, std::vector<std::vector<int>>& B,
-            int& cycle_count) {
+            uint64_t& cycle_count, uint64_t path_weight = 1) {
+
+    // Consulta parada (limite ou cancelamento): volta sem mexer no estado
+    if (query_step()) return false;
 
     bool found_cycle = false;
     blocked[v] = true;
@@ -101,10 +118,12 @@ bool circuit_v4_sequential(int v, int s, Graph G, const std::vector<char>& scc_m
         if (!scc_mask[w]) continue;
 
         if (w == s) {
-            ++cycle_count;
+            const uint64_t weight = extend_path_weight<WEIGHTED>(path_weight, edge_multiplicity(G, neighbor));
+            cycle_count = local_count_add(cycle_count, weight);
+            query_cycles(weight);
             found_cycle = true;
         } else if (!blocked[w]) {
-            if (circuit_v4_sequential(w, s, G, scc_mask, blocked, B, cycle_count)) {
+            if (circuit_v4_sequential<WEIGHTED>(w, s, G, scc_mask, blocked, B, cycle_count, extend_path_weight<WEIGHTED>(path_weight, edge_multiplicity(G, neighbor)))) {
                 found_cycle = true;
             }
         }
@@ -129,6 +148,7 @@ bool circuit_v4_sequential(int v, int s, Graph G, const std::vector<char>& scc_m
 
 
 
+template <bool WEIGHTED>
 bool circuit_v4_parallel(
     int v, 
     int s, 
@@ -136,15 +156,19 @@ bool circuit_v4_parallel(
     const std::vector<char>& scc_mask,
     std::vector<bool>& blocked, 
     std::vector<std::vector<int>>& B,
-    int& cycle_count, 
-    int depth = 0
+    uint64_t& cycle_count, 
+    int depth = 0,
+    uint64_t path_weight = 1 // produto das multiplicidades de s até v
 ) {
 
+    // Consulta parada (limite ou cancelamento): volta sem mexer no estado
+    if (query_step()) return false;
+
     bool found_cycle = false;
     blocked[v] = true;
 
 
-    std::vector<int> neighbors;
+    std::vector<const Vertex*> neighbors; // arestas v -> w que seguem na busca
     const Vertex* out_begin = outgoing_begin(G, v);
     const Vertex* out_end   = outgoing_end(G, v);
     neighbors.reserve(out_end - out_begin); // evita realocações
@@ -153,7 +177,7 @@ bool circuit_v4_parallel(
         int w = *neighbor;
         if (w < s) continue;
         if (!scc_mask[w]) continue;
-        neighbors.push_back(w);
+        neighbors.push_back(neighbor);
     }
 
     const int branching = static_cast<int>(neighbors.size());
@@ -166,17 +190,19 @@ bool circuit_v4_parallel(
 
     // taskgroup para sincronizar as tarefas geradas neste nível
     std::atomic<bool> any_child_found(false);
-
-    int local_cycles_parent = 0; // acumula ciclos locais e aplica 1 atomic no fim
+    // cada task conta no seu próprio slot; o pai soma depois do taskgroup
+    std::vector<uint64_t> child_cycles(branching, 0);
 
     #pragma omp taskgroup
     {
         for (int i = 0; i < branching; ++i) {
-            int w = neighbors[i];
+            int w = *neighbors[i];
+            if (query_stopped()) break; // consulta parada: não cria mais tarefas
+            const uint64_t weight = extend_path_weight<WEIGHTED>(path_weight, edge_multiplicity(G, neighbors[i]));
 
             if (w == s) {
-                // Contabiliza localmente; atomic só no final
-                local_cycles_parent++;
+                cycle_count = local_count_add(cycle_count, weight);
+                query_cycles(weight);
                 found_cycle = true; // local ao pai (ok)
             } else if (!blocked[w]) {
                 if (allow_spawn) {
@@ -185,19 +211,14 @@ bool circuit_v4_parallel(
                     std::vector<bool> blocked_copy = blocked;
                     std::vector<std::vector<int>> B_copy = B;
 
-                    #pragma omp task firstprivate(w, blocked_copy, B_copy, depth) shared(any_child_found, cycle_count, G, scc_mask)
+                    #pragma omp task firstprivate(w, i, weight, blocked_copy, B_copy, depth) shared(any_child_found, child_cycles, G, scc_mask)
                     {
-                        int local_count = 0;
-                        bool child_res = circuit_v4_sequential(w, s, G, scc_mask, blocked_copy, B_copy, local_count);
-                        if (local_count > 0) {
-                            #pragma omp atomic
-                            cycle_count += local_count;
-                        }
+                        bool child_res = circuit_v4_sequential<WEIGHTED>(w, s, G, scc_mask, blocked_copy, B_copy, child_cycles[i], weight);
                         if (child_res) any_child_found.store(true, std::memory_order_relaxed);
                     }
                 } else {
 
-                    if (circuit_v4_parallel(w, s, G, scc_mask, blocked, B, cycle_count, depth + 1)) {
+                    if (circuit_v4_parallel<WEIGHTED>(w, s, G, scc_mask, blocked, B, cycle_count, depth + 1, weight)) {
                         found_cycle = true;
                     }
                 }
@@ -206,22 +227,20 @@ bool circuit_v4_parallel(
         
     }
 
-    // Aplica a soma local (reduz contenção de atomics) se necessário
-    if (local_cycles_parent > 0) {
-        #pragma omp atomic
-        cycle_count += local_cycles_parent;
-    }
-
     if (any_child_found.load(std::memory_order_relaxed)) {
         found_cycle = true;
     }
+    for (uint64_t c : child_cycles) {
+        cycle_count = local_count_add(cycle_count, c);
+    }
 
     if (found_cycle) {
         unblock_v4(v, blocked, B);
 
     } else {
         
-        for (int w : neighbors) {
+        for (const Vertex* neighbor : neighbors) {
+            int w = *neighbor;
             auto& bucket = B[w];
             if (std::find(bucket.begin(), bucket.end(), v) == bucket.end()) {
                 bucket.push_back(v);
@@ -235,17 +254,24 @@ bool circuit_v4_parallel(
 
 
 
-int johnson_cycles_parallel_v4(
+cycle_count_t johnson_cycles_parallel_v4(
     Graph G
 ) {
     int n = G->num_nodes;
+    const bool weighted = has_edge_multiplicity(G); // senão todo caminho vale 1
     int s = 0;
-    int cycle_count = 0;
+    SCCScratch scc_scratch; // rascunho da decomposição, reaproveitado a cada s
+    uint64_t cycle_count = 0;
     std::vector<int> active(G->num_nodes, 1); // todos ativos inicialmente
+    trim_acyclic_vertices(G, active);
 
-    while (s < n) {
+    while (s < n && !query_poll(s)) {
+        if (!active[s]) { // não está em nenhum ciclo (trim global)
+            s++;
+            continue;
+        }
 
-        std::vector<std::vector<int>> SCCs = BFS_foward_backward_SCCs_v4(G, active, s);
+        std::vector<std::vector<int>> SCCs = BFS_foward_backward_SCCs_v4(G, active, s, scc_scratch);
 
         std::vector<int> scc_vertices;
         for (const std::vector<int>& scc : SCCs) {
@@ -271,13 +297,15 @@ int johnson_cycles_parallel_v4(
 
         const bool use_sequential = s > n * SCC_SEQUENTIAL_RATIO;
         if (use_sequential) {
-            circuit_v4_sequential(s, s, G, scc_mask, blocked, B, cycle_count);
+            if (weighted) circuit_v4_sequential<true>(s, s, G, scc_mask, blocked, B, cycle_count);
+            else circuit_v4_sequential<false>(s, s, G, scc_mask, blocked, B, cycle_count);
         } else {
             #pragma omp parallel
             {
                 #pragma omp single
                 {
-                    circuit_v4_parallel(s, s, G, scc_mask, blocked, B, cycle_count, 0);
+                    if (weighted) circuit_v4_parallel<true>(s, s, G, scc_mask, blocked, B, cycle_count, 0);
+                    else circuit_v4_parallel<false>(s, s, G, scc_mask, blocked, B, cycle_count, 0);
                 }
                 
             }
@@ -289,5 +317,6 @@ int johnson_cycles_parallel_v4(
     
     }
 
-    return cycle_count;
+    // laços separados pela normalização
+    return cycle_count_add(local_count_total(cycle_count), separate_self_loops(G));
 }
@@ -1,96 +1,269 @@
 #include "parallel_v5.hpp"
+#include "trim.hpp"
+#include "scc_multistep.hpp"
+#include "query_limits.h"
+#include "numa_placement.h"
+#include "dense_scc.hpp"
 
 #define PARALLEL_MIN_BRANCH 4
 #define SCC_SEQUENTIAL_RATIO 0.8
 
-std::vector<std::vector<int>> BFS_foward_backward_SCCs_v5(Graph G, const std::vector<int>& active, int min_vertex){
+// BFS paralela da decomposição: só para pivôs que alcançam pelo menos
+// BFS_PARALLEL_MIN_VERTICES vértices; fronteiras menores que
+// BFS_PARALLEL_MIN_FRONTIER rodam o nível inteiro numa thread só
+#define BFS_PARALLEL_MIN_VERTICES 4096
+#define BFS_PARALLEL_MIN_FRONTIER 1024
+#define BFS_TASK_GRAIN 256
+// Heurística de Beamer: top-down -> bottom-up quando as arestas da fronteira
+// passam de 1/ALPHA das não exploradas; volta quando a fronteira tem menos
+// de 1/BETA dos vértices candidatos
+#define BFS_BOTTOM_UP_ALPHA 14
+#define BFS_TOP_DOWN_BETA 24
+
+// Rascunho da decomposição da v5: caminho serial mais uma BFS paralela por sentido
+struct SCCScratchV5 {
+    SCCScratch serial;
+    ParallelFrontier fwd;
+    ParallelFrontier bwd;
+};
 
-    std::vector<std::vector<int>> SCCs;
-    std::vector<int> removed(G->num_nodes, 0);
-    for (int i = 0; i < G->num_nodes; i++) {
-        if (active[i] == 0 || i < min_vertex) {
-            removed[i] = 1;
+static inline const Vertex* bfs_begin(Graph G, int u, bool forward) {
+    return forward ? outgoing_begin(G, u) : incoming_begin(G, u);
+}
+
+static inline const Vertex* bfs_end(Graph G, int u, bool forward) {
+    return forward ? outgoing_end(G, u) : incoming_end(G, u);
+}
+
+// Roda body(i, tid) para i em [0, count): serial em fronteiras pequenas,
+// senão em chunks de taskloop (estamos dentro do single da v5)
+template <typename Body>
+static void bfs_for(int count, Body body) {
+    if (count < BFS_PARALLEL_MIN_FRONTIER) {
+        const int tid = omp_get_thread_num();
+        for (int i = 0; i < count; i++) body(i, tid);
+        return;
+    }
+    #pragma omp taskloop grainsize(BFS_TASK_GRAIN)
+    for (int i = 0; i < count; i++) {
+        body(i, omp_get_thread_num());
+    }
+}
+
+// BFS nível a nível a partir de pivot no sentido forward (arestas de saída)
+// ou backward (de entrada), com escolha de direção por nível. No passo
+// bottom-up cada candidato ainda não visitado procura um vizinho na
+// fronteira pelo CSR do sentido oposto, e só o dono do vértice o marca.
+template <typename Removed>
+static void parallel_bfs_v5(Graph G, int pivot, bool forward, int min_vertex,
+            const Removed& removed, ParallelFrontier& d) {
+
+    const int n = G->num_nodes;
+    const int candidates = n - min_vertex;
+    const int* starts = forward ? G->outgoing_starts : G->incoming_starts;
+    int64_t unexplored_edges = (int64_t) G->num_edges - starts[min_vertex];
+
+    // Dentro da região, omp_get_max_threads() é o tamanho do próximo nível
+    // de aninhamento e pode ser menor que o time atual (local_next é por tid)
+    d.resize(n, std::max(omp_get_max_threads(), omp_get_num_threads()));
+    d.visited.clear();
+    d.reached.clear();
+    d.frontier.start(pivot);
+    d.visited.mark(pivot);
+    d.reached.push_back(pivot);
+
+    int64_t frontier_edges = bfs_end(G, pivot, forward) - bfs_begin(G, pivot, forward);
+    bool bottom_up = false;
+
+    while (!d.frontier.current.empty()) {
+        const std::vector<int>& frontier = d.frontier.current;
+        unexplored_edges -= frontier_edges;
+
+        // a fronteira também precisa ser grande, senão o próximo nível já
+        // voltaria para top-down depois de varrer todos os candidatos
+        if (!bottom_up && frontier_edges > unexplored_edges / BFS_BOTTOM_UP_ALPHA &&
+            (int64_t) frontier.size() >= candidates / BFS_TOP_DOWN_BETA) {
+            bottom_up = true;
+        } else if (bottom_up && (int64_t) frontier.size() < candidates / BFS_TOP_DOWN_BETA) {
+            bottom_up = false;
+        }
+
+        if (bottom_up) {
+            d.in_frontier.clear();
+            for (int u : frontier) d.in_frontier.mark(u);
+
+            bfs_for(candidates, [&](int i, int tid) {
+                const int v = min_vertex + i;
+                if (removed(v) || d.visited.marked(v)) return;
+                for (const Vertex* u = bfs_begin(G, v, !forward); u != bfs_end(G, v, !forward); ++u) {
+                    if (d.in_frontier.marked(*u)) {
+                        d.visited.mark(v);
+                        d.local_next[tid].push_back(v);
+                        return;
+                    }
+                }
+            });
+        } else {
+            bfs_for((int) frontier.size(), [&](int i, int tid) {
+                const int u = frontier[i];
+                for (const Vertex* w = bfs_begin(G, u, forward); w != bfs_end(G, u, forward); ++w) {
+                    const int v = *w;
+                    if (!removed(v) && d.visited.try_mark(v)) {
+                        d.local_next[tid].push_back(v);
+                    }
+                }
+            });
         }
+
+        // junta as fronteiras locais; a ordem entre threads não importa
+        frontier_edges = 0;
+        for (std::vector<int>& local : d.local_next) {
+            for (int v : local) {
+                d.frontier.next.push_back(v);
+                d.reached.push_back(v);
+                frontier_edges += bfs_end(G, v, forward) - bfs_begin(G, v, forward);
+            }
+            local.clear();
+        }
+        d.frontier.advance();
+    }
+}
+
+std::vector<std::vector<int>> BFS_foward_backward_SCCs_v5(Graph G, const std::vector<int>& active, int min_vertex,
+            SCCScratchV5& scratch_v5){
+
+    SCCScratch& scratch = scratch_v5.serial;
+
+    if (scc_backend() == SCC_BACKEND_MULTISTEP) {
+        return multistep_SCCs(G, active, min_vertex, scratch);
     }
 
+    std::vector<std::vector<int>> SCCs;
+    scratch.resize(G->num_nodes);
+    EpochMarks& assigned = scratch.assigned;
+    assigned.clear();
+    auto removed = [&](int v) {
+        return active[v] == 0 || v < min_vertex || assigned.marked(v);
+    };
+
+    trim_trivial_sccs(G, active, min_vertex, scratch, SCCs);
+
+    EpochMarks& visited_fwd = scratch.visited_fwd;
+    EpochMarks& visited_bwd = scratch.visited_bwd;
+    std::vector<int>& reached_fwd = scratch.reached_fwd;
+    FrontierBuffers& frontier = scratch.frontier;
+
+    // Com o resto do time ocioso esperando o produtor, pivôs cujo forward
+    // passa de BFS_PARALLEL_MIN_VERTICES vértices recomeçam com forward e
+    // backward juntos, cada um nível a nível em paralelo. O backward então
+    // não se restringe ao que o forward alcançou, mas a intersecção continua
+    // percorrendo só reached do forward. Pivôs de SCCs pequenas (a maioria
+    // em grafos com muitas SCCs) ficam no caminho serial, sem overhead de task.
+    const bool parallel_bfs = omp_in_parallel() && omp_get_num_threads() > 1 &&
+                              G->num_nodes - min_vertex >= BFS_PARALLEL_MIN_VERTICES;
+
     for (int pivot = min_vertex; pivot < G->num_nodes; pivot++) {
-        if (removed[pivot] == 1) continue;
+        if (removed(pivot)) continue;
 
-        std::vector<bool> visited_fwd(G->num_nodes, false);
-        std::vector<int> frontier_fwd;
-        frontier_fwd.push_back(pivot);
-        visited_fwd[pivot] = true;
+        visited_fwd.clear();
+        reached_fwd.clear();
+        frontier.start(pivot);
+        visited_fwd.mark(pivot);
+        reached_fwd.push_back(pivot);
 
-        while (!frontier_fwd.empty()) {
-            std::vector<int> new_frontier;
-            for (int u : frontier_fwd) {
+        bool escalate = false;
+        while (!frontier.current.empty() && !escalate) {
+            for (int u : frontier.current) {
                 const Vertex* out_begin = outgoing_begin(G, u);
                 const Vertex* out_end = outgoing_end(G, u);
                 for (const Vertex* neighbor = out_begin; neighbor != out_end; ++neighbor) {
                     int v = *neighbor;
-                    if (removed[v] == 0 && !visited_fwd[v]) {
-                        visited_fwd[v] = true;
-                        new_frontier.push_back(v);
+                    if (!removed(v) && !visited_fwd.marked(v)) {
+                        visited_fwd.mark(v);
+                        reached_fwd.push_back(v);
+                        frontier.next.push_back(v);
                     }
                 }
             }
-            frontier_fwd = std::move(new_frontier);
+            frontier.advance();
+            escalate = parallel_bfs && reached_fwd.size() >= BFS_PARALLEL_MIN_VERTICES;
+        }
+
+        if (escalate) {
+            #pragma omp taskgroup
+            {
+                #pragma omp task shared(G, removed, scratch_v5)
+                parallel_bfs_v5(G, pivot, true, min_vertex, removed, scratch_v5.fwd);
+                #pragma omp task shared(G, removed, scratch_v5)
+                parallel_bfs_v5(G, pivot, false, min_vertex, removed, scratch_v5.bwd);
+            }
+
+            std::vector<int> current_SCC;
+            for (int v : scratch_v5.fwd.reached) {
+                if (scratch_v5.bwd.visited.marked(v)) {
+                    current_SCC.push_back(v);
+                    assigned.mark(v);
+                }
+            }
+            SCCs.push_back(std::move(current_SCC));
+            continue;
         }
 
-        std::vector<bool> visited_bwd(G->num_nodes, false);
-        std::vector<int> frontier_bwd;
-        frontier_bwd.push_back(pivot);
-        visited_bwd[pivot] = true;
+        // o backward só precisa andar dentro do que o forward alcançou
+        visited_bwd.clear();
+        frontier.start(pivot);
+        visited_bwd.mark(pivot);
 
-        while (!frontier_bwd.empty()) {
-            std::vector<int> new_frontier;
-            for (int u : frontier_bwd) {
+        while (!frontier.current.empty()) {
+            for (int u : frontier.current) {
                 const Vertex* in_begin = incoming_begin(G, u);
                 const Vertex* in_end = incoming_end(G, u);
                 for (const Vertex* neighbor = in_begin; neighbor != in_end; ++neighbor) {
                     int v = *neighbor;
-                    if (removed[v] == 0 && !visited_bwd[v]) {
-                        visited_bwd[v] = true;
-                        new_frontier.push_back(v);
+                    if (visited_fwd.marked(v) && !visited_bwd.marked(v)) {
+                        visited_bwd.mark(v);
+                        frontier.next.push_back(v);
                     }
                 }
             }
-            frontier_bwd = std::move(new_frontier);
+            frontier.advance();
         }
 
         std::vector<int> current_SCC;
-        for (int i = 0; i < G->num_nodes; i++) {
-            if (visited_fwd[i] && visited_bwd[i]) {
-                current_SCC.push_back(i);
-                removed[i] = 1;
+        for (int v : reached_fwd) {
+            if (visited_bwd.marked(v)) {
+                current_SCC.push_back(v);
+                assigned.mark(v);
             }
         }
 
-        if (!current_SCC.empty()) {
-            SCCs.push_back(std::move(current_SCC));
-        }
+        SCCs.push_back(std::move(current_SCC));
     }
 
     return SCCs;
 }
 
-void unblock_v5(int u, std::vector<bool>& blocked, std::vector<std::vector<int>>& B) {
+void unblock_v5(int u, CircuitScratch& state) {
 
-    blocked[u] = false;
-    for (int w : B[u]) {
-        if (blocked[w]) {
-            unblock_v5(w, blocked, B);
+    state.blocked.unmark(u);
+    for (int i = state.B.first(u); i >= 0; i = state.B.next(i)) {
+        int w = state.B.value(i);
+        if (state.blocked.marked(w)) {
+            unblock_v5(w, state);
         }
     }
-    B[u].clear();
+    state.B.clear(u);
 }
 
-bool circuit_v5_sequential(int v, int s, Graph G, const std::vector<char>& scc_mask,
-            std::vector<bool>& blocked, std::vector<std::vector<int>>& B,
-            int& cycle_count) {
+template <bool WEIGHTED>
+bool circuit_v5_sequential(int v, int s, Graph G, const EpochMarks& scc_mask,
+            CircuitScratch& state, uint64_t& cycle_count, uint64_t path_weight = 1) {
+
+    // Consulta parada (limite ou cancelamento): volta sem mexer no estado
+    if (query_step()) return false;
 
     bool found_cycle = false;
-    blocked[v] = true;
+    state.block(v);
 
     const Vertex* out_begin = outgoing_begin(G, v);
     const Vertex* out_end = outgoing_end(G, v);
@@ -98,29 +271,29 @@ bool circuit_v5_sequential(int v, int s, Graph G, const std::vector<char>& scc_m
     for (const Vertex* neighbor = out_begin; neighbor != out_end; ++neighbor) {
         int w = *neighbor;
         if (w < s) continue;
-        if (!scc_mask[w]) continue;
+        if (!scc_mask.marked(w)) continue;
 
         if (w == s) {
-            ++cycle_count;
+            const uint64_t weight = extend_path_weight<WEIGHTED>(path_weight, edge_multiplicity(G, neighbor));
+            cycle_count = local_count_add(cycle_count, weight);
+            query_cycles(weight);
             found_cycle = true;
-        } else if (!blocked[w]) {
-            if (circuit_v5_sequential(w, s, G, scc_mask, blocked, B, cycle_count)) {
+        } else if (!state.blocked.marked(w)) {
+            if (circuit_v5_sequential<WEIGHTED>(w, s, G, scc_mask, state, cycle_count,
+                                                extend_path_weight<WEIGHTED>(path_weight, edge_multiplicity(G, neighbor)))) {
                 found_cycle = true;
             }
         }
     }
 
     if (found_cycle) {
-        unblock_v5(v, blocked, B);
+        unblock_v5(v, state);
     } else {
         for (const Vertex* neighbor = out_begin; neighbor != out_end; ++neighbor) {
             int w = *neighbor;
             if (w < s) continue;
-            if (!scc_mask[w]) continue;
-            auto& bucket = B[w];
-            if (std::find(bucket.begin(), bucket.end(), v) == bucket.end()) {
-                bucket.push_back(v);
-            }
+            if (!scc_mask.marked(w)) continue;
+            state.add_dependency(w, v);
         }
     }
 
@@ -128,23 +301,37 @@ bool circuit_v5_sequential(int v, int s, Graph G, const std::vector<char>& scc_m
 }
 
 
+// Estado de cada task de SCC e de cada ramo clonado: reaproveitado entre
+// iterações de s (e entre chamadas) em vez de alocar O(n) a cada s
+struct SCCTaskScratch {
+    EpochMarks scc_mask;
+    CircuitScratch circuit;
+};
+
+static ScratchPool<SCCTaskScratch> scc_task_pool;
+static ScratchPool<CircuitScratch> branch_pool;
+
 
+template <bool WEIGHTED>
 bool circuit_v5_parallel(
     int v, 
     int s, 
     Graph G, 
-    const std::vector<char>& scc_mask,
-    std::vector<bool>& blocked, 
-    std::vector<std::vector<int>>& B,
-    int& cycle_count, 
-    int depth = 0
+    const EpochMarks& scc_mask,
+    CircuitScratch& state,
+    uint64_t& cycle_count, 
+    int depth = 0,
+    uint64_t path_weight = 1 // produto das multiplicidades de s até v
 ) {
 
+    // Consulta parada (limite ou cancelamento): volta sem mexer no estado
+    if (query_step()) return false;
+
     bool found_cycle = false;
-    blocked[v] = true;
+    state.block(v);
 
 
-    std::vector<int> neighbors;
+    std::vector<const Vertex*> neighbors; // arestas v -> w que seguem na busca
     const Vertex* out_begin = outgoing_begin(G, v);
     const Vertex* out_end   = outgoing_end(G, v);
     neighbors.reserve(out_end - out_begin);
@@ -152,8 +339,8 @@ bool circuit_v5_parallel(
     for (const Vertex* neighbor = out_begin; neighbor != out_end; ++neighbor) {
         int w = *neighbor;
         if (w < s) continue;
-        if (!scc_mask[w]) continue;
-        neighbors.push_back(w);
+        if (!scc_mask.marked(w)) continue;
+        neighbors.push_back(neighbor);
     }
 
     const int branching = static_cast<int>(neighbors.size());
@@ -165,36 +352,41 @@ bool circuit_v5_parallel(
         (branching >= PARALLEL_MIN_BRANCH);
 
     std::atomic<bool> any_child_found(false);
-
-    int local_cycles_parent = 0;
+    // cada task conta no seu próprio slot; o pai soma depois do taskgroup
+    std::vector<uint64_t> child_cycles(branching, 0);
 
     #pragma omp taskgroup
     {
         for (int i = 0; i < branching; ++i) {
-            int w = neighbors[i];
+            int w = *neighbors[i];
+            if (query_stopped()) break; // consulta parada: não cria mais tarefas
+            const uint64_t weight = extend_path_weight<WEIGHTED>(path_weight, edge_multiplicity(G, neighbors[i]));
 
             if (w == s) {
-                local_cycles_parent++;
+                cycle_count = local_count_add(cycle_count, weight);
+                query_cycles(weight);
                 found_cycle = true;
-            } else if (!blocked[w]) {
+            } else if (!state.blocked.marked(w)) {
                 if (allow_spawn) {
-                    // Cada tarefa usa seu próprio estado para preservar o pruning do Johnson
-                    std::vector<bool> blocked_copy = blocked;
-                    std::vector<std::vector<int>> B_copy = B;
-
-                    #pragma omp task firstprivate(w, blocked_copy, B_copy, depth) shared(any_child_found, cycle_count, G, scc_mask)
+                    // Cada tarefa usa seu próprio estado para preservar o pruning do Johnson;
+                    // a cópia custa O(vértices tocados), não O(n)
+                    // (volta para a lista do nó de quem a preencheu)
+                    const int branch_node = numa_current_node();
+                    CircuitScratch* branch_state = branch_pool.acquire(branch_node).release();
+                    branch_state->copy_from(state);
+
+                    #pragma omp task firstprivate(w, i, weight, branch_state, branch_node, depth) shared(any_child_found, child_cycles, G, scc_mask)
                     {
-                        int local_count = 0;
-                        bool child_res = circuit_v5_sequential(w, s, G, scc_mask, blocked_copy, B_copy, local_count);
-                        if (local_count > 0) {
-                            #pragma omp atomic
-                            cycle_count += local_count;
-                        }
+                        bool child_res = circuit_v5_sequential<WEIGHTED>(w, s, G, scc_mask, *branch_state, child_cycles[i], weight);
                         if (child_res) any_child_found.store(true, std::memory_order_relaxed);
+                        branch_pool.release(std::unique_ptr<CircuitScratch>(branch_state), branch_node);
+                        // publica os ciclos do ramo: o query_finished do s
+                        // roda em outra thread e só publica os dela
+                        query_poll();
                     }
                 } else {
 
-                    if (circuit_v5_parallel(w, s, G, scc_mask, blocked, B, cycle_count, depth + 1)) {
+                    if (circuit_v5_parallel<WEIGHTED>(w, s, G, scc_mask, state, cycle_count, depth + 1, weight)) {
                         found_cycle = true;
                     }
                 }
@@ -203,25 +395,21 @@ bool circuit_v5_parallel(
         
     }
 
-    if (local_cycles_parent > 0) {
-        #pragma omp atomic
-        cycle_count += local_cycles_parent;
-    }
-
     if (any_child_found.load(std::memory_order_relaxed)) {
         found_cycle = true;
     }
+    for (uint64_t c : child_cycles) {
+        cycle_count = local_count_add(cycle_count, c);
+    }
 
     if (found_cycle) {
-        unblock_v5(v, blocked, B);
+        unblock_v5(v, state);
 
     } else {
         
-        for (int w : neighbors) {
-            auto& bucket = B[w];
-            if (std::find(bucket.begin(), bucket.end(), v) == bucket.end()) {
-                bucket.push_back(v);
-            }
+        for (const Vertex* neighbor : neighbors) {
+            int w = *neighbor;
+            state.add_dependency(w, v);
         }
     }
 
@@ -238,10 +426,20 @@ struct SCCJob {
 };
 
 
-int johnson_cycles_parallel_v5(Graph G) {
+cycle_count_t johnson_cycles_parallel_v5(Graph G, bool count_only, Checkpoint* checkpoint) {
     int n = G->num_nodes;
-    std::atomic<int> cycle_count(0);
+    const bool weighted = has_edge_multiplicity(G); // senão todo caminho vale 1
+    PerThreadCounts cycle_count;
+    // A DP não conhece multiplicidades; os laços próprios separados entram direto
+    count_only = count_only && !G->outgoing_multiplicity;
+    cycle_count.add(separate_self_loops(G));
     std::vector<int> active(G->num_nodes, 1); // todos ativos inicialmente
+    query_unordered(); // progresso: as tasks terminam os s fora de ordem
+    trim_acyclic_vertices(G, active);
+    // Rascunho do produtor (a decomposição roda sempre na thread do single)
+    SCCScratchV5 scc_scratch;
+    EpochMarks producer_scc_mask;
+    producer_scc_mask.resize(n);
     
     // Mutex para proteger a lista de active e o índice s
     std::mutex active_mutex;
@@ -251,9 +449,21 @@ int johnson_cycles_parallel_v5(Graph G) {
         #pragma omp single
         {
             int s = 0;
-            while (s < n) {
+            while (s < n && !query_poll(s)) {
+                if (!active[s]) { // não está em nenhum ciclo (trim global)
+                    query_finished(s);
+                    s++;
+                    continue;
+                }
+                if (checkpoint && checkpoint->done(s)) { // concluído antes da retomada
+                    query_finished(s);
+                    active[s] = 0;
+                    s++;
+                    continue;
+                }
+
                 // Encontra SCCs de forma sequencial (mas permite tasks de SCCs anteriores rodarem)
-                std::vector<std::vector<int>> SCCs = BFS_foward_backward_SCCs_v5(G, active, s);
+                std::vector<std::vector<int>> SCCs = BFS_foward_backward_SCCs_v5(G, active, s, scc_scratch);
 
                 std::vector<int> scc_vertices;
                 for (const std::vector<int>& scc : SCCs) {
@@ -264,42 +474,73 @@ int johnson_cycles_parallel_v5(Graph G) {
                 }
 
                 if (scc_vertices.empty()) {
+                    query_finished(s);
                     active[s] = 0;
                     s++;
                     continue;
                 }
 
-                // Cria a máscara da SCC
-                std::vector<char> scc_mask(n, 0);
+                // Máscara da SCC no produtor (só para contar arestas internas);
+                // cada task monta a sua no próprio rascunho
+                producer_scc_mask.clear();
                 for (int v : scc_vertices) {
-                    scc_mask[v] = 1;
+                    producer_scc_mask.mark(v);
                 }
 
                 const int current_s = s;
                 const bool use_sequential = s > n * SCC_SEQUENTIAL_RATIO;
 
+                // Só contagem: SCCs pequenas e densas vão para a DP por
+                // subconjuntos em vez do circuit
+                bool use_dp = false;
+                const int scc_size = (int) scc_vertices.size();
+                if (count_only && scc_size >= DENSE_DP_MIN_VERTICES && scc_size <= DENSE_DP_MAX_VERTICES) {
+                    int64_t internal_edges = 0;
+                    for (int v : scc_vertices) {
+                        for (const Vertex* w = outgoing_begin(G, v); w != outgoing_end(G, v); ++w) {
+                            if (*w != v && producer_scc_mask.marked(*w)) internal_edges++;
+                        }
+                    }
+                    use_dp = dense_dp_preferred(scc_size, internal_edges);
+                }
+
                 // Cria uma task para processar esta SCC
                 // Isso permite que múltiplas SCCs sejam processadas em paralelo
-                #pragma omp task firstprivate(current_s, scc_mask, use_sequential) shared(G, cycle_count)
+                #pragma omp task firstprivate(current_s, scc_vertices, use_sequential, use_dp) shared(G, cycle_count)
                 {
-                    std::vector<bool> blocked(n, false);
-                    std::vector<std::vector<int>> B(n);
-
-                    int local_cycle_count = 0;
+                    uint64_t local_cycle_count = 0;
+                    Graph LG = numa_local_graph(G); // réplica do nó desta thread (-n replicate)
 
-                    if (use_sequential) {
-                        circuit_v5_sequential(current_s, current_s, G, scc_mask, blocked, B, local_cycle_count);
+                    if (use_dp) {
+                        dense_cycles_from_min(LG, scc_vertices, local_cycle_count);
                     } else {
-                        // Cria uma região paralela aninhada para explorar os ramos da SCC
-                        #pragma omp taskgroup
-                        {
-                            circuit_v5_parallel(current_s, current_s, G, scc_mask, blocked, B, local_cycle_count, 0);
+                        ScratchPool<SCCTaskScratch>::Lease scratch(scc_task_pool);
+                        EpochMarks& scc_mask = scratch->scc_mask;
+                        scc_mask.resize(n);
+                        scc_mask.clear();
+                        for (int v : scc_vertices) {
+                            scc_mask.mark(v);
+                        }
+                        CircuitScratch& state = scratch->circuit;
+                        state.reset(n);
+
+                        if (use_sequential) {
+                            if (weighted) circuit_v5_sequential<true>(current_s, current_s, LG, scc_mask, state, local_cycle_count);
+                            else circuit_v5_sequential<false>(current_s, current_s, LG, scc_mask, state, local_cycle_count);
+                        } else {
+                            // Cria uma região paralela aninhada para explorar os ramos da SCC
+                            #pragma omp taskgroup
+                            {
+                                if (weighted) circuit_v5_parallel<true>(current_s, current_s, LG, scc_mask, state, local_cycle_count, 0);
+                                else circuit_v5_parallel<false>(current_s, current_s, LG, scc_mask, state, local_cycle_count, 0);
+                            }
                         }
                     }
 
-                    if (local_cycle_count > 0) {
-                        cycle_count.fetch_add(local_cycle_count, std::memory_order_relaxed);
-                    }
+                    cycle_count.add(local_count_total(local_cycle_count));
+                    // parada no meio deixa o s incompleto: a retomada refaz
+                    if (checkpoint && !query_stopped()) checkpoint->complete(current_s, local_count_total(local_cycle_count));
+                    query_finished(current_s); // as tasks terminam fora de ordem
                 }
 
                 active[s] = 0;
@@ -308,5 +549,6 @@ int johnson_cycles_parallel_v5(Graph G) {
         }
     }
 
-    return cycle_count.load();
+    if (checkpoint) cycle_count.add(checkpoint->resumed_cycles());
+    return cycle_count.total();
 }
@@ -0,0 +1,392 @@
+#include "parallel_v6.hpp"
+#include "trim.hpp"
+#include "scc_multistep.hpp"
+#include "query_limits.h"
+#include "dense_scc.hpp"
+#include <type_traits>
+
+// Sub-SCCs com pelo menos isso de vértices rodam o circuit de cada s numa
+// task própria; as menores rodam dentro da task do job
+#define V6_SPAWN_MIN_VERTICES 32
+// Limite de pares (predecessor, sucessor) de s testados por stays_connected_v6
+#define STAYS_CONNECTED_MAX_PAIRS 256
+// Só o CSR comum tem trim, Multistep e a DP das SCCs densas
+#define IS_PLAIN_GRAPH(GraphT) (std::is_same<GraphT, Graph>::value)
+
+// Estado compartilhado entre os jobs. Cada vértice pertence a um único job
+// (job_of, só leitura depois da decomposição) e só a task do seu job escreve
+// active[v] e piece[v], então os jobs não precisam de sincronização.
+struct JobLabels {
+    std::vector<int> job_of;  // job da SCC de v (-1 se não está em nenhum)
+    std::vector<int> piece;   // sub-SCC atual de v dentro do job
+    std::vector<int> active;
+};
+
+// Rascunho de um job ou de uma task de s, reaproveitado via pool
+struct V6Scratch {
+    EpochMarks scc_mask;
+    CircuitScratch circuit;
+    SCCScratch decomposition;
+};
+
+static ScratchPool<V6Scratch> v6_pool;
+
+
+// Laço de pivôs com BFS forward/backward sobre os vértices de members para
+// os quais inside(v) vale. Quem chama limpa scratch.assigned.
+template <typename GraphT, typename Inside>
+static void BFS_foward_backward_SCCs_v6(GraphT G, const std::vector<int>& members, const Inside& inside,
+            SCCScratch& scratch, std::vector<std::vector<int>>& SCCs){
+
+    scratch.resize(G->num_nodes);
+    EpochMarks& assigned = scratch.assigned;
+    EpochMarks& visited_fwd = scratch.visited_fwd;
+    EpochMarks& visited_bwd = scratch.visited_bwd;
+    std::vector<int>& reached_fwd = scratch.reached_fwd;
+    FrontierBuffers& frontier = scratch.frontier;
+
+    auto alive = [&](int v) { return inside(v) && !assigned.marked(v); };
+
+    for (int pivot : members) {
+        if (!alive(pivot)) continue;
+
+        visited_fwd.clear();
+        reached_fwd.clear();
+        frontier.start(pivot);
+        visited_fwd.mark(pivot);
+        reached_fwd.push_back(pivot);
+
+        while (!frontier.current.empty()) {
+            for (int u : frontier.current) {
+                for (Vertex w : outgoing(G, u)) {
+                    if (alive(w) && !visited_fwd.marked(w)) {
+                        visited_fwd.mark(w);
+                        reached_fwd.push_back(w);
+                        frontier.next.push_back(w);
+                    }
+                }
+            }
+            frontier.advance();
+        }
+
+        visited_bwd.clear();
+        frontier.start(pivot);
+        visited_bwd.mark(pivot);
+
+        while (!frontier.current.empty()) {
+            for (int u : frontier.current) {
+                for (Vertex w : incoming(G, u)) {
+                    if (visited_fwd.marked(w) && !visited_bwd.marked(w)) {
+                        visited_bwd.mark(w);
+                        frontier.next.push_back(w);
+                    }
+                }
+            }
+            frontier.advance();
+        }
+
+        std::vector<int> current_SCC;
+        for (int v : reached_fwd) {
+            if (visited_bwd.marked(v)) {
+                current_SCC.push_back(v);
+                assigned.mark(v);
+            }
+        }
+
+        SCCs.push_back(std::move(current_SCC));
+    }
+}
+
+void unblock_v6(int u, CircuitScratch& state) {
+
+    state.blocked.unmark(u);
+    for (int i = state.B.first(u); i >= 0; i = state.B.next(i)) {
+        int w = state.B.value(i);
+        if (state.blocked.marked(w)) {
+            unblock_v6(w, state);
+        }
+    }
+    state.B.clear(u);
+}
+
+template <bool WEIGHTED, typename GraphT>
+bool circuit_v6(int v, int s, GraphT G, const EpochMarks& scc_mask,
+            CircuitScratch& state, uint64_t& cycle_count, uint64_t path_weight = 1) {
+
+    // Consulta parada (limite ou cancelamento): volta sem mexer no estado
+    if (query_step()) return false;
+
+    bool found_cycle = false;
+    state.block(v);
+
+    const auto neighbors = outgoing(G, v);
+
+    for (auto neighbor = neighbors.begin(); neighbor != neighbors.end(); ++neighbor) {
+        int w = *neighbor;
+        if (w < s) continue;
+        if (!scc_mask.marked(w)) continue;
+
+        if (w == s) {
+            const uint64_t weight = extend_path_weight<WEIGHTED>(path_weight, neighbor.multiplicity());
+            cycle_count = local_count_add(cycle_count, weight);
+            query_cycles(weight);
+            found_cycle = true;
+        } else if (!state.blocked.marked(w)) {
+            if (circuit_v6<WEIGHTED>(w, s, G, scc_mask, state, cycle_count, extend_path_weight<WEIGHTED>(path_weight, neighbor.multiplicity()))) {
+                found_cycle = true;
+            }
+        }
+    }
+
+    if (found_cycle) {
+        unblock_v6(v, state);
+    } else {
+        for (Vertex w : neighbors) {
+            if (w < s) continue;
+            if (!scc_mask.marked(w)) continue;
+            state.add_dependency(w, v);
+        }
+    }
+
+    return found_cycle;
+}
+
+// Ciclos do s com a menor vértice da sub-SCC scc_vertices (circuit ou DP)
+template <typename GraphT>
+static uint64_t cycles_from_v6(GraphT G, int s, const std::vector<int>& scc_vertices,
+            bool count_only, V6Scratch& scratch) {
+
+    const int n = G->num_nodes;
+    EpochMarks& scc_mask = scratch.scc_mask;
+    scc_mask.resize(n);
+    scc_mask.clear();
+    for (int v : scc_vertices) {
+        scc_mask.mark(v);
+    }
+
+    uint64_t local_cycle_count = 0;
+    const int scc_size = (int) scc_vertices.size();
+    if constexpr (IS_PLAIN_GRAPH(GraphT)) {
+        if (count_only && scc_size >= DENSE_DP_MIN_VERTICES && scc_size <= DENSE_DP_MAX_VERTICES) {
+            int64_t internal_edges = 0;
+            for (int v : scc_vertices) {
+                for (Vertex w : outgoing(G, v)) {
+                    if (w != v && scc_mask.marked(w)) internal_edges++;
+                }
+            }
+            if (dense_dp_preferred(scc_size, internal_edges)) {
+                dense_cycles_from_min(G, scc_vertices, local_cycle_count);
+                return local_cycle_count;
+            }
+        }
+    }
+
+    scratch.circuit.reset(n);
+    if (has_edge_multiplicity(G)) circuit_v6<true>(s, s, G, scc_mask, scratch.circuit, local_cycle_count);
+    else circuit_v6<false>(s, s, G, scc_mask, scratch.circuit, local_cycle_count);
+    return local_cycle_count;
+}
+
+// Mesmo teste da sequencial: a sub-SCC continua fortemente conexa sem s se
+// todo par (predecessor u, sucessor w) de s tem u == w ou a aresta u -> w
+template <typename GraphT, typename Inside>
+static bool stays_connected_v6(GraphT G, int s, const Inside& inside, SCCScratch& scratch) {
+
+    std::vector<int> preds, succs;
+    for (Vertex u : incoming(G, s)) {
+        if (u != s && inside(u)) preds.push_back(u);
+    }
+    for (Vertex w : outgoing(G, s)) {
+        if (w != s && inside(w)) succs.push_back(w);
+    }
+    if (preds.size() * succs.size() > STAYS_CONNECTED_MAX_PAIRS) return false;
+
+    scratch.resize(G->num_nodes);
+    EpochMarks& out_of_u = scratch.visited_fwd;
+    for (int u : preds) {
+        out_of_u.clear();
+        for (Vertex w : outgoing(G, u)) {
+            out_of_u.mark(w);
+        }
+        for (int w : succs) {
+            if (w != u && !out_of_u.marked(w)) return false;
+        }
+    }
+    return true;
+}
+
+// Sub-Johnson de uma SCC (members em ordem crescente): para cada s, acha a
+// sub-SCC de s entre os vértices ainda ativos do job, redecompondo só a
+// sub-SCC que perdeu o s anterior e só se ela pode ter se partido
+template <typename GraphT>
+static void run_scc_job_v6(GraphT G, int job, const std::vector<int>& members, JobLabels& L,
+            bool count_only, PerThreadCounts& cycle_count) {
+
+    ScratchPool<V6Scratch>::Lease scratch(v6_pool);
+
+    // Caminho rápido: SCC completa, quase completa ou pequena inteira de uma vez
+    if constexpr (IS_PLAIN_GRAPH(GraphT)) {
+        cycle_count_t scc_count;
+        const DenseCountResult dense = count_only ? dense_scc_count(G, members, scc_count)
+                                                  : DENSE_COUNT_UNSUPPORTED;
+        if (dense != DENSE_COUNT_UNSUPPORTED) {
+            // Parada no meio da DP: a parcial entra, os s não terminaram
+            cycle_count.add(scc_count);
+            if (dense == DENSE_COUNT_DONE) {
+                for (int s : members) query_finished(s);
+            }
+            return;
+        }
+    }
+
+    std::vector<std::vector<int>> pieces;
+    std::vector<char> dirty;
+    auto add_piece = [&](std::vector<int>&& vertices) {
+        const int id = (int) pieces.size();
+        for (int v : vertices) L.piece[v] = id;
+        pieces.push_back(std::move(vertices));
+        dirty.push_back(0);
+    };
+    add_piece(std::vector<int>(members));
+
+    uint64_t local_cycle_count = 0;
+
+    for (int s : members) {
+        if (query_poll(s)) break; // consulta parada: o resto do job fica de fora
+        int id = L.piece[s];
+        if (dirty[id]) {
+            std::vector<int> old_piece;
+            old_piece.swap(pieces[id]);
+            auto inside = [&](int v) {
+                return L.job_of[v] == job && L.active[v] != 0 && L.piece[v] == id;
+            };
+            std::vector<std::vector<int>> split;
+            scratch->decomposition.resize(G->num_nodes);
+            scratch->decomposition.assigned.clear();
+            BFS_foward_backward_SCCs_v6(G, old_piece, inside, scratch->decomposition, split);
+            for (std::vector<int>& scc : split) add_piece(std::move(scc));
+            id = L.piece[s];
+        }
+
+        const std::vector<int>& scc_vertices = pieces[id];
+        if ((int) scc_vertices.size() >= V6_SPAWN_MIN_VERTICES) {
+            std::vector<int> task_vertices(scc_vertices);
+            #pragma omp task firstprivate(s, task_vertices) shared(G, cycle_count)
+            {
+                ScratchPool<V6Scratch>::Lease task_scratch(v6_pool);
+                cycle_count.add(local_count_total(cycles_from_v6(G, s, task_vertices, count_only, *task_scratch)));
+                query_finished(s); // progresso: os s terminam fora de ordem
+            }
+        } else {
+            local_cycle_count = local_count_add(local_cycle_count, cycles_from_v6(G, s, scc_vertices, count_only, *scratch));
+            query_finished(s);
+        }
+
+        L.active[s] = 0;
+        std::vector<int>& rest = pieces[id];
+        rest.erase(std::find(rest.begin(), rest.end(), s));
+        auto inside = [&](int v) {
+            return L.job_of[v] == job && L.active[v] != 0 && L.piece[v] == id;
+        };
+        dirty[id] = rest.size() > 1 && !stays_connected_v6(G, s, inside, scratch->decomposition);
+    }
+
+    cycle_count.add(local_count_total(local_cycle_count));
+}
+
+
+// Corpo comum às duas representações. Trim, Multistep e a DP só existem
+// para o CSR comum; no comprimido a decomposição é o laço de pivôs.
+template <typename GraphT>
+static cycle_count_t johnson_cycles_v6(GraphT G, bool count_only) {
+    int n = G->num_nodes;
+    PerThreadCounts cycle_count;
+    // Laços próprios separados pela normalização entram direto
+    cycle_count.add(separate_self_loops(G));
+
+    JobLabels L;
+    L.active.assign(n, 1);
+    query_unordered(); // progresso: os jobs terminam os s fora de ordem
+    L.job_of.assign(n, -1);
+    L.piece.assign(n, 0);
+    if constexpr (IS_PLAIN_GRAPH(GraphT)) {
+        trim_acyclic_vertices(G, L.active);
+    }
+
+    #pragma omp parallel
+    {
+        #pragma omp single
+        {
+            // Decomposição única do grafo inteiro (com trim)
+            std::vector<std::vector<int>> SCCs;
+            {
+                ScratchPool<V6Scratch>::Lease scratch(v6_pool);
+                SCCScratch& decomposition = scratch->decomposition;
+                decomposition.resize(n);
+                decomposition.assigned.clear();
+                bool multistep = false;
+                if constexpr (IS_PLAIN_GRAPH(GraphT)) {
+                    multistep = scc_backend() == SCC_BACKEND_MULTISTEP;
+                    if (multistep) {
+                        SCCs = multistep_SCCs(G, L.active, 0, decomposition);
+                    } else {
+                        trim_trivial_sccs(G, L.active, 0, decomposition, SCCs);
+                    }
+                }
+                if (!multistep) {
+                    std::vector<int> all;
+                    for (int v = 0; v < n; v++) {
+                        if (L.active[v]) all.push_back(v);
+                    }
+                    auto inside = [&](int v) { return L.active[v] != 0; };
+                    BFS_foward_backward_SCCs_v6(G, all, inside, decomposition, SCCs);
+                }
+            }
+
+            // SCCs de 1 vértice só têm os laços próprios; as outras viram jobs,
+            // as maiores primeiro para equilibrar a carga
+            uint64_t self_loops = 0;
+            std::vector<int> jobs;
+            for (int i = 0; i < (int) SCCs.size(); i++) {
+                if (SCCs[i].size() == 1) {
+                    const int v = SCCs[i][0];
+                    for (Vertex w : outgoing(G, v)) {
+                        if (w == v) self_loops++;
+                    }
+                    continue;
+                }
+                std::sort(SCCs[i].begin(), SCCs[i].end());
+                for (int v : SCCs[i]) L.job_of[v] = i;
+                jobs.push_back(i);
+            }
+            cycle_count.add(self_loops);
+            for (int v = 0; v < n; v++) {
+                if (L.job_of[v] < 0) query_finished(v); // fora de qualquer job: nada a fazer
+            }
+            std::sort(jobs.begin(), jobs.end(), [&](int a, int b) {
+                return SCCs[a].size() > SCCs[b].size();
+            });
+
+            // SCCs é local ao single: espera os jobs antes de sair do escopo
+            #pragma omp taskgroup
+            {
+                for (int job : jobs) {
+                    if (query_poll()) break;
+                    #pragma omp task firstprivate(job) shared(G, SCCs, L, cycle_count)
+                    run_scc_job_v6(G, job, SCCs[job], L, count_only, cycle_count);
+                }
+            }
+        }
+    }
+
+    return cycle_count.total();
+}
+
+cycle_count_t johnson_cycles_parallel_v6(Graph G, bool count_only) {
+    // A DP e as fórmulas não conhecem multiplicidades
+    return johnson_cycles_v6(G, count_only && !G->outgoing_multiplicity);
+}
+
+cycle_count_t johnson_cycles_parallel_v6(const CompressedGraph* G) {
+    return johnson_cycles_v6(G, false);
+}
@@ -0,0 +1,324 @@
+#include "parallel_v7.hpp"
+#include "trim.hpp"
+#include "scc_multistep.hpp"
+#include "query_limits.h"
+#include "task_scheduler.h"
+#include "numa_placement.h"
+
+
+#define PARALLEL_DEPTH 4
+#define PARALLEL_BRANCH 2
+#define DEBUG 0
+#define SCC_SEQUENTIAL_RATIO 0.8
+
+std::vector<std::vector<int>> BFS_foward_backward_SCCs_v7(Graph G, const std::vector<int>& active, int min_vertex,
+            SCCScratch& scratch){
+
+    if (scc_backend() == SCC_BACKEND_MULTISTEP) {
+        return multistep_SCCs(G, active, min_vertex, scratch);
+    }
+
+    std::vector<std::vector<int>> SCCs;
+    scratch.resize(G->num_nodes);
+    EpochMarks& assigned = scratch.assigned;
+    assigned.clear();
+    auto removed = [&](int v) {
+        return active[v] == 0 || v < min_vertex || assigned.marked(v);
+    };
+
+    trim_trivial_sccs(G, active, min_vertex, scratch, SCCs);
+
+    EpochMarks& visited_fwd = scratch.visited_fwd;
+    EpochMarks& visited_bwd = scratch.visited_bwd;
+    std::vector<int>& reached_fwd = scratch.reached_fwd;
+    FrontierBuffers& frontier = scratch.frontier;
+
+    for (int pivot = min_vertex; pivot < G->num_nodes; pivot++) {
+        if (removed(pivot)) continue;
+
+        visited_fwd.clear();
+        reached_fwd.clear();
+        frontier.start(pivot);
+        visited_fwd.mark(pivot);
+        reached_fwd.push_back(pivot);
+
+        while (!frontier.current.empty()) {
+            for (int u : frontier.current) {
+                const Vertex* out_begin = outgoing_begin(G, u);
+                const Vertex* out_end = outgoing_end(G, u);
+                for (const Vertex* neighbor = out_begin; neighbor != out_end; ++neighbor) {
+                    int v = *neighbor;
+                    if (!removed(v) && !visited_fwd.marked(v)) {
+                        visited_fwd.mark(v);
+                        reached_fwd.push_back(v);
+                        frontier.next.push_back(v);
+                    }
+                }
+            }
+            frontier.advance();
+        }
+
+        // o backward só precisa andar dentro do que o forward alcançou
+        visited_bwd.clear();
+        frontier.start(pivot);
+        visited_bwd.mark(pivot);
+
+        while (!frontier.current.empty()) {
+            for (int u : frontier.current) {
+                const Vertex* in_begin = incoming_begin(G, u);
+                const Vertex* in_end = incoming_end(G, u);
+                for (const Vertex* neighbor = in_begin; neighbor != in_end; ++neighbor) {
+                    int v = *neighbor;
+                    if (visited_fwd.marked(v) && !visited_bwd.marked(v)) {
+                        visited_bwd.mark(v);
+                        frontier.next.push_back(v);
+                    }
+                }
+            }
+            frontier.advance();
+        }
+
+        std::vector<int> current_SCC;
+        for (int v : reached_fwd) {
+            if (visited_bwd.marked(v)) {
+                current_SCC.push_back(v);
+                assigned.mark(v);
+            }
+        }
+
+        SCCs.push_back(std::move(current_SCC));
+    }
+
+    return SCCs;
+}
+
+void unblock_v7(int u, CircuitScratch& state) {
+
+    state.blocked.unmark(u);
+    for (int i = state.B.first(u); i >= 0; i = state.B.next(i)) {
+        int w = state.B.value(i);
+        if (state.blocked.marked(w)) {
+            unblock_v7(w, state);
+        }
+    }
+    state.B.clear(u);
+}
+
+template <bool WEIGHTED>
+bool circuit_v7_sequential(int v, int s, Graph G, const EpochMarks& scc_mask,
+            CircuitScratch& state, uint64_t& cycle_count, uint64_t path_weight = 1) {
+
+    // Consulta parada (limite ou cancelamento): volta sem mexer no estado
+    if (query_step()) return false;
+
+    bool found_cycle = false;
+    state.block(v);
+
+    const Vertex* out_begin = outgoing_begin(G, v);
+    const Vertex* out_end = outgoing_end(G, v);
+
+    for (const Vertex* neighbor = out_begin; neighbor != out_end; ++neighbor) {
+        int w = *neighbor;
+        if (w < s) continue;
+        if (!scc_mask.marked(w)) continue;
+
+        if (w == s) {
+            const uint64_t weight = extend_path_weight<WEIGHTED>(path_weight, edge_multiplicity(G, neighbor));
+            cycle_count = local_count_add(cycle_count, weight);
+            query_cycles(weight);
+            found_cycle = true;
+        } else if (!state.blocked.marked(w)) {
+            if (circuit_v7_sequential<WEIGHTED>(w, s, G, scc_mask, state, cycle_count, extend_path_weight<WEIGHTED>(path_weight, edge_multiplicity(G, neighbor)))) {
+                found_cycle = true;
+            }
+        }
+    }
+
+    if (found_cycle) {
+        unblock_v7(v, state);
+    } else {
+        for (const Vertex* neighbor = out_begin; neighbor != out_end; ++neighbor) {
+            int w = *neighbor;
+            if (w < s) continue;
+            if (!scc_mask.marked(w)) continue;
+            state.add_dependency(w, v);
+        }
+    }
+
+    return found_cycle;
+}
+
+
+// Estado de cada ramo clonado, reaproveitado entre tarefas, s e chamadas
+static ScratchPool<CircuitScratch> branch_pool;
+
+// Mesmo kernel para os três escalonadores (task_scheduler.h)
+template <bool WEIGHTED, typename Scheduler>
+bool circuit_v7_parallel(
+    Scheduler& sched,
+    int v, 
+    int s, 
+    Graph G, 
+    const EpochMarks& scc_mask,
+    CircuitScratch& state,
+    uint64_t& cycle_count, 
+    int depth = 0,
+    uint64_t path_weight = 1 // produto das multiplicidades de s até v
+) {
+
+    // Consulta parada (limite ou cancelamento): volta sem mexer no estado
+    if (query_step()) return false;
+
+    bool found_cycle = false;
+    state.block(v);
+
+
+    std::vector<const Vertex*> neighbors; // arestas v -> w que seguem na busca
+    const Vertex* out_begin = outgoing_begin(G, v);
+    const Vertex* out_end   = outgoing_end(G, v);
+    neighbors.reserve(out_end - out_begin); // evita realocações
+
+    for (const Vertex* neighbor = out_begin; neighbor != out_end; ++neighbor) {
+        int w = *neighbor;
+        if (w < s) continue;
+        if (!scc_mask.marked(w)) continue;
+        neighbors.push_back(neighbor);
+    }
+
+    const int branching = static_cast<int>(neighbors.size());
+    const bool allow_spawn = (depth < PARALLEL_DEPTH) && (branching >= PARALLEL_BRANCH);
+
+    // grupo das tarefas geradas neste nível, esperado antes de somar
+    typename Scheduler::Group group;
+    std::atomic<bool> any_child_found(false);
+    // cada tarefa conta no seu próprio slot; o pai soma depois do wait
+    std::vector<uint64_t> child_cycles(branching, 0);
+
+    for (int i = 0; i < branching; ++i) {
+        int w = *neighbors[i];
+        if (query_stopped()) break; // consulta parada: não cria mais tarefas
+        const uint64_t weight = extend_path_weight<WEIGHTED>(path_weight, edge_multiplicity(G, neighbors[i]));
+
+        if (w == s) {
+            cycle_count = local_count_add(cycle_count, weight);
+            query_cycles(weight);
+            found_cycle = true; // local ao pai (ok)
+        } else if (!state.blocked.marked(w)) {
+            if (allow_spawn) {
+                // a tarefa leva uma cópia do estado, em O(vértices tocados) e
+                // não O(n); G, scc_mask e os slots vivem até o wait
+                const int branch_node = numa_current_node();
+                CircuitScratch* branch_state = branch_pool.acquire(branch_node).release();
+                branch_state->copy_from(state);
+                sched.spawn(group, [&sched, w, s, G, &scc_mask, branch_state, branch_node,
+                                    &child_cycles, i, depth, weight, &any_child_found]() {
+                    bool child_res = circuit_v7_parallel<WEIGHTED>(sched, w, s, G, scc_mask, *branch_state, child_cycles[i], depth + 1, weight);
+                    if (child_res) any_child_found.store(true, std::memory_order_relaxed);
+                    branch_pool.release(std::unique_ptr<CircuitScratch>(branch_state), branch_node);
+                });
+            } else {
+                if (circuit_v7_parallel<WEIGHTED>(sched, w, s, G, scc_mask, state, cycle_count, depth + 1, weight)) {
+                    found_cycle = true;
+                }
+            }
+        }
+    }
+    sched.wait(group);
+
+    if (any_child_found.load(std::memory_order_relaxed)) {
+        found_cycle = true;
+    }
+    for (uint64_t c : child_cycles) {
+        cycle_count = local_count_add(cycle_count, c);
+    }
+
+    if (found_cycle) {
+        unblock_v7(v, state); 
+
+    } else {
+        
+        for (const Vertex* neighbor : neighbors) {
+            int w = *neighbor;
+            state.add_dependency(w, v);
+        }
+    }
+
+
+    return found_cycle;
+}
+
+
+
+template <typename Scheduler>
+static cycle_count_t johnson_cycles_v7(Graph G) {
+    Scheduler sched;
+    int n = G->num_nodes;
+    const bool weighted = has_edge_multiplicity(G); // senão todo caminho vale 1
+    int s = 0;
+    SCCScratch scc_scratch; // rascunho da decomposição, reaproveitado a cada s
+    // Máscara da SCC e estado da raiz: alocados uma vez, limpos em O(1) por s
+    EpochMarks scc_mask;
+    scc_mask.resize(n);
+    CircuitScratch state;
+    uint64_t cycle_count = 0;
+    std::vector<int> active(G->num_nodes, 1); // todos ativos inicialmente
+    trim_acyclic_vertices(G, active);
+
+    while (s < n && !query_poll(s)) {
+        if (!active[s]) { // não está em nenhum ciclo (trim global)
+            s++;
+            continue;
+        }
+
+        std::vector<std::vector<int>> SCCs = BFS_foward_backward_SCCs_v7(G, active, s, scc_scratch);
+
+        std::vector<int> scc_vertices;
+        for (const std::vector<int>& scc : SCCs) {
+            if (std::find(scc.begin(), scc.end(), s) != scc.end()) {
+                scc_vertices = scc;
+                break;
+            }
+        }
+
+        if (scc_vertices.empty()) {
+            active[s] = 0;
+            s++;
+            continue;
+        }
+
+        scc_mask.clear();
+        for (int v : scc_vertices) {
+            scc_mask.mark(v);
+        }
+        state.reset(n);
+
+        const bool use_sequential = s > n * SCC_SEQUENTIAL_RATIO;
+        if (use_sequential) {
+            if (weighted) circuit_v7_sequential<true>(s, s, G, scc_mask, state, cycle_count);
+            else circuit_v7_sequential<false>(s, s, G, scc_mask, state, cycle_count);
+        } else {
+            // com os pools não há região paralela: a raiz roda nesta thread e
+            // as tarefas vão para os workers, que continuam vivos para o próximo s
+            sched.run([&] {
+                if (weighted) circuit_v7_parallel<true>(sched, s, s, G, scc_mask, state, cycle_count, 0);
+                else circuit_v7_parallel<false>(sched, s, s, G, scc_mask, state, cycle_count, 0);
+            });
+        }
+
+        active[s] = 0;
+        ++s;
+    }
+
+    // laços separados pela normalização
+    return cycle_count_add(local_count_total(cycle_count), separate_self_loops(G));
+}
+
+cycle_count_t johnson_cycles_parallel_v7(Graph G, TaskScheduler scheduler)
+{
+    switch (scheduler) {
+        case TASK_SCHEDULER_OMP: return johnson_cycles_v7<OmpTaskScheduler>(G);
+        case TASK_SCHEDULER_STEALING: return johnson_cycles_v7<StealingTaskScheduler>(G);
+        case TASK_SCHEDULER_POOL: break;
+    }
+    return johnson_cycles_v7<PoolTaskScheduler>(G);
+}
@@ -0,0 +1,434 @@
+#include "partition.hpp"
+#include "scc_multistep.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+// Ints lidos do arquivo por fread; dois leitores (inícios e arestas) por passada
+#define PARTITION_READ_BUFFER (1 << 18)
+// Arquivos de parte abertos ao mesmo tempo (cada um com um buffer de
+// PARTITION_WRITE_BUFFER bytes); mais partes custam mais passadas
+#define PARTITION_MAX_OPEN_FILES 64
+#define PARTITION_WRITE_BUFFER (1 << 18)
+
+#define GRAPH_HEADER_TOKEN ((int) 0xDEADBEEF)
+
+#define FLAG_FWD 1
+#define FLAG_BWD 2
+#define FLAG_LOOP 4
+#define FLAG_CYCLIC 8
+
+class IntReader {
+public:
+    IntReader() : buffer(PARTITION_READ_BUFFER) {}
+
+    void start(FILE* f, long offset)
+    {
+        file = f;
+        pos = len = 0;
+        if (fseek(file, offset, SEEK_SET) != 0) {
+            fprintf(stderr, "Error seeking graph file.\n");
+            exit(1);
+        }
+    }
+
+    inline int next()
+    {
+        if (pos == len) {
+            len = fread(buffer.data(), sizeof(int), buffer.size(), file);
+            pos = 0;
+            if (len == 0) {
+                fprintf(stderr, "Unexpected end of graph file.\n");
+                exit(1);
+            }
+        }
+        return buffer[pos++];
+    }
+
+private:
+    FILE* file = NULL;
+    std::vector<int> buffer;
+    size_t pos = 0, len = 0;
+};
+
+// Arestas do arquivo binário em ordem de origem, sem carregá-las: os inícios
+// e os destinos são lidos em paralelo de duas posições do arquivo
+class EdgeFileStream {
+public:
+    explicit EdgeFileStream(const char* filename)
+    {
+        starts_file = fopen(filename, "rb");
+        edges_file = fopen(filename, "rb");
+        if (!starts_file || !edges_file) {
+            fprintf(stderr, "Could not open: %s\n", filename);
+            exit(1);
+        }
+        int header[3];
+        if (fread(header, sizeof(int), 3, starts_file) != 3) {
+            fprintf(stderr, "Error reading header.\n");
+            exit(1);
+        }
+        if (header[0] != GRAPH_HEADER_TOKEN) {
+            fprintf(stderr, "Invalid graph file header. File may be corrupt.\n");
+            exit(1);
+        }
+        num_nodes = header[1];
+        num_edges = header[2];
+    }
+
+    ~EdgeFileStream()
+    {
+        fclose(starts_file);
+        fclose(edges_file);
+    }
+
+    // body(u, v) para cada aresta u -> v
+    template <typename Body>
+    void for_each_edge(Body body)
+    {
+        passes++;
+        starts.start(starts_file, 3 * sizeof(int));
+        edges.start(edges_file, (3 + (long) num_nodes) * sizeof(int));
+        if (num_nodes == 0) return;
+        int begin = starts.next();
+        for (int u = 0; u < num_nodes; u++) {
+            const int end = u + 1 < num_nodes ? starts.next() : num_edges;
+            for (int i = begin; i < end; i++) body(u, edges.next());
+            begin = end;
+        }
+    }
+
+    int num_nodes = 0;
+    int num_edges = 0;
+    int passes = 0;
+
+private:
+    FILE* starts_file;
+    FILE* edges_file;
+    IntReader starts;
+    IntReader edges;
+};
+
+// Passadas até que body não mude mais nada (body devolve true se mudou)
+template <typename Body>
+static void propagate(EdgeFileStream& stream, Body body)
+{
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        stream.for_each_edge([&](int u, int v) {
+            if (body(u, v)) changed = true;
+        });
+    }
+}
+
+static void write_ints(FILE* file, const int* values, size_t count)
+{
+    if (fwrite(values, sizeof(int), count, file) != count) {
+        fprintf(stderr, "Error writing partition file.\n");
+        exit(1);
+    }
+}
+
+// Carrega o subgrafo induzido pelos vértices vivos (laços de fora) e
+// termina a decomposição com o Multistep em memória
+template <typename Alive>
+static void finish_in_memory(EdgeFileStream& stream, Alive alive, std::vector<int>& scc,
+                             std::vector<int>& local)
+{
+    const int n = stream.num_nodes;
+    std::vector<int> global;
+    for (int v = 0; v < n; v++) {
+        if (!alive(v)) continue;
+        local[v] = (int) global.size();
+        global.push_back(v);
+    }
+    std::vector<Vertex> sources, targets;
+    stream.for_each_edge([&](int u, int v) {
+        if (u != v && alive(u) && alive(v)) {
+            sources.push_back(local[u]);
+            targets.push_back(local[v]);
+        }
+    });
+
+    Graph sub = build_graph((int) global.size(), (int) sources.size(), sources.data(), targets.data());
+    std::vector<int>().swap(sources);
+    std::vector<int>().swap(targets);
+    std::vector<int> active(global.size(), 1);
+    SCCScratch scratch;
+    for (const std::vector<int>& members : multistep_SCCs(sub, active, 0, scratch)) {
+        for (int v : members) scc[global[v]] = global[members[0]];
+    }
+    free_graph(sub);
+}
+
+PartitionStats partition_graph_file(const char* filename, const char* dir, int part_edges, int64_t memory_edges)
+{
+    EdgeFileStream stream(filename);
+    const int n = stream.num_nodes;
+
+    PartitionStats stats;
+    stats.num_nodes = n;
+    stats.num_edges = stream.num_edges;
+
+    // scc[v]: raiz da SCC de v (-1 enquanto ativo). color e degree servem a
+    // mais de um passo (graus do trim, cores, parte de v, grau interno)
+    std::vector<int> scc(n, -1);
+    std::vector<int> color(n, 0);
+    std::vector<int> degree(n, 0);
+    std::vector<int> local(n, 0);
+    std::vector<unsigned char> flags(n, 0);
+    stats.vertex_bytes = 4 * (size_t) n * sizeof(int) + (size_t) n;
+    auto alive = [&](int v) { return scc[v] < 0; };
+
+    // 1) Trim-1: sem vizinho de entrada ou de saída ativo => SCC trivial.
+    //    Para quando uma passada remove menos de 1% dos ativos; o resto fica
+    //    para a coloração.
+    int remaining = n;
+    for (;;) {
+        std::fill(color.begin(), color.end(), 0);  // grau de entrada
+        std::fill(degree.begin(), degree.end(), 0); // grau de saída
+        stream.for_each_edge([&](int u, int v) {
+            if (u == v) {
+                flags[u] |= FLAG_LOOP;
+            } else if (alive(u) && alive(v)) {
+                degree[u]++;
+                color[v]++;
+            }
+        });
+        int removed = 0;
+        for (int v = 0; v < n; v++) {
+            if (alive(v) && (color[v] == 0 || degree[v] == 0)) {
+                scc[v] = v;
+                removed++;
+            }
+        }
+        remaining -= removed;
+        if (removed == 0 || removed * 100 < remaining) break;
+    }
+
+    // Arestas entre vivos, sem laços (uma passada)
+    auto alive_edges = [&]() {
+        int64_t edges = 0;
+        stream.for_each_edge([&](int u, int v) {
+            if (u != v && alive(u) && alive(v)) edges++;
+        });
+        return edges;
+    };
+    // Depois do trim, os graus de saída da última passada já dão um limite superior
+    int64_t trimmed_edges = 0;
+    for (int v = 0; v < n; v++) {
+        if (alive(v)) trimmed_edges += degree[v];
+    }
+    if (trimmed_edges <= memory_edges) {
+        finish_in_memory(stream, alive, scc, local);
+        stats.in_memory_finish = true;
+    }
+
+    // 2) FW-BW a partir do vértice de maior grau_entrada * grau_saída (graus
+    //    da última passada do trim, válidos para os que sobraram)
+    int pivot = -1;
+    int64_t best = -1;
+    for (int v = 0; v < n; v++) {
+        if (!alive(v)) continue;
+        int64_t score = (int64_t) color[v] * degree[v];
+        if (score > best) {
+            best = score;
+            pivot = v;
+        }
+    }
+    if (pivot >= 0) {
+        flags[pivot] |= FLAG_FWD | FLAG_BWD;
+        propagate(stream, [&](int u, int v) {
+            if ((flags[u] & FLAG_FWD) && !(flags[v] & FLAG_FWD) && alive(v)) {
+                flags[v] |= FLAG_FWD;
+                return true;
+            }
+            return false;
+        });
+        propagate(stream, [&](int u, int v) {
+            if ((flags[v] & FLAG_BWD) && (flags[u] & FLAG_FWD) && !(flags[u] & FLAG_BWD)) {
+                flags[u] |= FLAG_BWD;
+                return true;
+            }
+            return false;
+        });
+        for (int v = 0; v < n; v++) {
+            if ((flags[v] & (FLAG_FWD | FLAG_BWD)) == (FLAG_FWD | FLAG_BWD)) scc[v] = pivot;
+            flags[v] &= ~(FLAG_FWD | FLAG_BWD);
+        }
+    }
+
+    // 3) Coloração: color[v] = maior vértice que alcança v no que sobrou;
+    //    a SCC de cada raiz (color[r] == r) são os vértices da sua cor que
+    //    alcançam r. Cada rodada remove pelo menos a SCC do maior vértice,
+    //    mas SCCs pequenas atrás de um caminho longo custam muitas rodadas:
+    //    quando o que sobrou cabe em memory_edges, termina em memória.
+    for (;;) {
+        bool any = false;
+        for (int v = 0; v < n; v++) {
+            if (alive(v)) {
+                color[v] = v;
+                any = true;
+            }
+        }
+        if (!any) break;
+        if (alive_edges() <= memory_edges) {
+            finish_in_memory(stream, alive, scc, local);
+            stats.in_memory_finish = true;
+            break;
+        }
+
+        propagate(stream, [&](int u, int v) {
+            if (alive(u) && alive(v) && color[u] > color[v]) {
+                color[v] = color[u];
+                return true;
+            }
+            return false;
+        });
+        for (int v = 0; v < n; v++) {
+            if (alive(v) && color[v] == v) flags[v] |= FLAG_BWD;
+        }
+        propagate(stream, [&](int u, int v) {
+            if ((flags[v] & FLAG_BWD) && !(flags[u] & FLAG_BWD) && alive(u) && alive(v) &&
+                color[u] == color[v]) {
+                flags[u] |= FLAG_BWD;
+                return true;
+            }
+            return false;
+        });
+        for (int v = 0; v < n; v++) {
+            if (flags[v] & FLAG_BWD) {
+                scc[v] = color[v];
+                flags[v] &= ~FLAG_BWD;
+            }
+        }
+    }
+
+    // Tamanho das SCCs (em color, por raiz) e arestas internas de cada
+    // vértice, laços inclusive (em degree)
+    std::fill(color.begin(), color.end(), 0);
+    for (int v = 0; v < n; v++) color[scc[v]]++;
+    std::fill(degree.begin(), degree.end(), 0);
+    stream.for_each_edge([&](int u, int v) {
+        if (scc[u] == scc[v]) degree[u]++;
+    });
+    for (int v = 0; v < n; v++) {
+        if (color[scc[v]] >= 2 || (flags[v] & FLAG_LOOP)) flags[v] |= FLAG_CYCLIC;
+    }
+
+    // Arestas por SCC cíclica (em color, por raiz)
+    std::fill(color.begin(), color.end(), 0);
+    for (int v = 0; v < n; v++) {
+        if (flags[v] & FLAG_CYCLIC) color[scc[v]] += degree[v];
+    }
+
+    // SCCs em ordem da raiz; uma grande fica sozinha, as pequenas enchem a
+    // parte aberta até part_edges. color[r] passa a ser a parte da raiz r.
+    std::vector<PartitionPart>& parts = stats.parts;
+    int open_part = -1;
+    for (int r = 0; r < n; r++) {
+        if (scc[r] != r || !(flags[r] & FLAG_CYCLIC)) continue;
+        const int edges = color[r];
+        int p;
+        if (edges >= part_edges) {
+            p = (int) parts.size();
+            parts.emplace_back();
+        } else {
+            if (open_part < 0 || parts[open_part].edges + edges > part_edges) {
+                open_part = (int) parts.size();
+                parts.emplace_back();
+            }
+            p = open_part;
+        }
+        parts[p].edges += edges;
+        parts[p].sccs++;
+        color[r] = p;
+        stats.cyclic_sccs++;
+        stats.part_edges += edges;
+    }
+    for (size_t p = 0; p < parts.size(); p++) {
+        char name[32];
+        snprintf(name, sizeof(name), "part_%05zu.bin", p);
+        parts[p].file = name;
+    }
+
+    // IDs locais em ordem crescente do ID original: as arestas chegam do
+    // arquivo já na ordem do CSR de cada parte
+    for (int v = 0; v < n; v++) {
+        if (flags[v] & FLAG_CYCLIC) local[v] = parts[color[scc[v]]].nodes++;
+    }
+    auto part_of = [&](int v) { return (flags[v] & FLAG_CYCLIC) ? color[scc[v]] : -1; };
+
+    // Grava até PARTITION_MAX_OPEN_FILES partes por passada
+    std::vector<FILE*> files;
+    std::vector<int> offsets;
+    for (size_t first = 0; first < parts.size(); first += PARTITION_MAX_OPEN_FILES) {
+        const size_t last = std::min(parts.size(), first + PARTITION_MAX_OPEN_FILES);
+        files.assign(last - first, NULL);
+        offsets.assign(last - first, 0);
+        for (size_t p = first; p < last; p++) {
+            const std::string path = std::string(dir) + "/" + parts[p].file;
+            FILE* file = fopen(path.c_str(), "wb");
+            if (!file) {
+                fprintf(stderr, "Could not open: %s\n", path.c_str());
+                exit(1);
+            }
+            setvbuf(file, NULL, _IOFBF, PARTITION_WRITE_BUFFER);
+            const int header[3] = {GRAPH_HEADER_TOKEN, parts[p].nodes, parts[p].edges};
+            write_ints(file, header, 3);
+            files[p - first] = file;
+        }
+
+        for (int v = 0; v < n; v++) {
+            const int p = part_of(v);
+            if (p < (int) first || p >= (int) last) continue;
+            write_ints(files[p - first], &offsets[p - first], 1);
+            offsets[p - first] += degree[v];
+        }
+
+        stream.for_each_edge([&](int u, int v) {
+            const int p = part_of(u);
+            if (p < (int) first || p >= (int) last || scc[u] != scc[v]) return;
+            write_ints(files[p - first], &local[v], 1);
+        });
+
+        for (FILE* file : files) fclose(file);
+    }
+
+    const std::string index_path = std::string(dir) + "/" + PARTITION_INDEX_FILE;
+    FILE* index = fopen(index_path.c_str(), "w");
+    if (!index) {
+        fprintf(stderr, "Could not open: %s\n", index_path.c_str());
+        exit(1);
+    }
+    fprintf(index, "# Source: %s\n", filename);
+    fprintf(index, "# Nodes: %d Edges: %d\n", n, stream.num_edges);
+    fprintf(index, "# file nodes edges sccs\n");
+    for (const PartitionPart& part : parts) {
+        fprintf(index, "%s %d %d %d\n", part.file.c_str(), part.nodes, part.edges, part.sccs);
+    }
+    fclose(index);
+
+    stats.edge_passes = stream.passes;
+    return stats;
+}
+
+bool load_partition_index(const char* dir, std::vector<PartitionPart>& parts)
+{
+    std::ifstream index(std::string(dir) + "/" + PARTITION_INDEX_FILE);
+    if (!index) return false;
+
+    parts.clear();
+    std::string line;
+    while (std::getline(index, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::stringstream ss(line);
+        PartitionPart part;
+        if (ss >> part.file >> part.nodes >> part.edges >> part.sccs) parts.push_back(part);
+    }
+    return true;
+}
@@ -0,0 +1,216 @@
+#include "reorder.hpp"
+#include "scc_multistep.hpp"
+#include <string.h>
+#include <algorithm>
+#include <queue>
+
+// Janela do Gorder: o score de v é a soma, sobre os últimos
+// GORDER_WINDOW vértices colocados u, de arestas entre u e v mais
+// predecessores em comum
+#define GORDER_WINDOW 5
+// Predecessores com mais sucessores que isso não contam como "em comum"
+// (um hub tornaria cada passo O(grau do hub))
+#define GORDER_MAX_SIBLING_DEGREE 256
+
+static const struct {
+    VertexOrder order;
+    const char* name;
+} order_names[] = {
+    {ORDER_ORIGINAL, "original"},
+    {ORDER_DEGREE_ASC, "degree-asc"},
+    {ORDER_DEGREE_DESC, "degree-desc"},
+    {ORDER_SCC, "scc"},
+    {ORDER_RCM, "rcm"},
+    {ORDER_GORDER, "gorder"},
+};
+
+bool parse_vertex_order(const char* name, VertexOrder& order)
+{
+    for (const auto& entry : order_names) {
+        if (strcmp(name, entry.name) == 0) {
+            order = entry.order;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* vertex_order_name(VertexOrder order)
+{
+    for (const auto& entry : order_names) {
+        if (entry.order == order) return entry.name;
+    }
+    return "?";
+}
+
+static int total_degree(Graph G, int v)
+{
+    return outgoing_size(G, v) + incoming_size(G, v);
+}
+
+// Vértices ordenados por grau total (estável: empates pelo ID original)
+static std::vector<int> by_degree(Graph G, bool descending)
+{
+    std::vector<int> order(G->num_nodes);
+    for (int v = 0; v < G->num_nodes; v++) order[v] = v;
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return descending ? total_degree(G, a) > total_degree(G, b)
+                          : total_degree(G, a) < total_degree(G, b);
+    });
+    return order;
+}
+
+// SCCs contíguas, na ordem do menor vértice de cada uma; dentro da SCC, a
+// ordem original
+static std::vector<int> by_scc(Graph G)
+{
+    std::vector<int> active(G->num_nodes, 1);
+    SCCScratch scratch;
+    std::vector<std::vector<int>> SCCs = multistep_SCCs(G, active, 0, scratch);
+    canonicalize_sccs(SCCs);
+
+    std::vector<int> order;
+    order.reserve(G->num_nodes);
+    for (const std::vector<int>& scc : SCCs) {
+        order.insert(order.end(), scc.begin(), scc.end());
+    }
+    return order;
+}
+
+// Cuthill-McKee sobre o grafo não direcionado (arestas de entrada e de
+// saída), cada componente a partir do vértice de menor grau, vizinhos em
+// ordem crescente de grau; a ordem final é invertida
+static std::vector<int> reverse_cuthill_mckee(Graph G)
+{
+    const int n = G->num_nodes;
+    std::vector<int> order;
+    order.reserve(n);
+    std::vector<char> visited(n, 0);
+    std::vector<int> neighbors;
+
+    for (int root : by_degree(G, false)) {
+        if (visited[root]) continue;
+        visited[root] = 1;
+        size_t head = order.size();
+        order.push_back(root);
+
+        for (; head < order.size(); head++) {
+            const int u = order[head];
+            neighbors.clear();
+            for (const Vertex* w = outgoing_begin(G, u); w != outgoing_end(G, u); ++w) {
+                if (!visited[*w]) { visited[*w] = 1; neighbors.push_back(*w); }
+            }
+            for (const Vertex* w = incoming_begin(G, u); w != incoming_end(G, u); ++w) {
+                if (!visited[*w]) { visited[*w] = 1; neighbors.push_back(*w); }
+            }
+            std::sort(neighbors.begin(), neighbors.end(), [&](int a, int b) {
+                const int da = total_degree(G, a), db = total_degree(G, b);
+                return da != db ? da < db : a < b;
+            });
+            order.insert(order.end(), neighbors.begin(), neighbors.end());
+        }
+    }
+
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+// Gorder guloso: o próximo vértice é o de maior score em relação à janela
+// dos últimos GORDER_WINDOW colocados. Scores mudam por +-1 quando um vértice
+// entra ou sai da janela; o heap é preguiçoso (entradas com score velho são
+// descartadas no pop). Sem candidato com score > 0, segue a ordem original.
+static std::vector<int> greedy_gorder(Graph G)
+{
+    const int n = G->num_nodes;
+    std::vector<int> order;
+    order.reserve(n);
+    std::vector<int> score(n, 0);
+    std::vector<char> placed(n, 0);
+    std::priority_queue<std::pair<int, int>> heap; // (score, -v)
+
+    auto update = [&](int u, int delta) {
+        auto bump = [&](int w) {
+            if (placed[w]) return;
+            score[w] += delta;
+            if (score[w] > 0) heap.push({score[w], -w});
+        };
+        for (const Vertex* w = outgoing_begin(G, u); w != outgoing_end(G, u); ++w) bump(*w);
+        for (const Vertex* x = incoming_begin(G, u); x != incoming_end(G, u); ++x) {
+            bump(*x);
+            if (outgoing_size(G, *x) > GORDER_MAX_SIBLING_DEGREE) continue;
+            for (const Vertex* w = outgoing_begin(G, *x); w != outgoing_end(G, *x); ++w) {
+                if (*w != u) bump(*w);
+            }
+        }
+    };
+
+    int next_unplaced = 0;
+    while ((int) order.size() < n) {
+        int v = -1;
+        while (!heap.empty()) {
+            std::pair<int, int> top = heap.top();
+            heap.pop();
+            if (!placed[-top.second] && score[-top.second] == top.first) {
+                v = -top.second;
+                break;
+            }
+        }
+        if (v < 0) {
+            while (placed[next_unplaced]) next_unplaced++;
+            v = next_unplaced;
+        }
+
+        placed[v] = 1;
+        order.push_back(v);
+        update(v, +1);
+        if ((int) order.size() > GORDER_WINDOW) {
+            update(order[order.size() - 1 - GORDER_WINDOW], -1);
+        }
+    }
+    return order;
+}
+
+VertexRelabeling compute_vertex_order(Graph G, VertexOrder order)
+{
+    const int n = G->num_nodes;
+    VertexRelabeling relabeling;
+
+    switch (order) {
+        case ORDER_DEGREE_ASC:  relabeling.old_id = by_degree(G, false); break;
+        case ORDER_DEGREE_DESC: relabeling.old_id = by_degree(G, true); break;
+        case ORDER_SCC:         relabeling.old_id = by_scc(G); break;
+        case ORDER_RCM:         relabeling.old_id = reverse_cuthill_mckee(G); break;
+        case ORDER_GORDER:      relabeling.old_id = greedy_gorder(G); break;
+        default:
+            relabeling.old_id.resize(n);
+            for (int v = 0; v < n; v++) relabeling.old_id[v] = v;
+    }
+
+    relabeling.new_id.resize(n);
+    for (int i = 0; i < n; i++) relabeling.new_id[relabeling.old_id[i]] = i;
+    return relabeling;
+}
+
+Graph relabel_graph(Graph G, const VertexRelabeling& relabeling)
+{
+    const std::vector<int>& new_id = relabeling.new_id;
+    std::vector<Vertex> sources, targets;
+    sources.reserve(G->num_edges);
+    targets.reserve(G->num_edges);
+
+    // Um grafo normalizado volta a ter as arestas repetidas e os laços
+    // próprios nas listas (normalize_graph pode ser aplicado de novo depois)
+    for (int old_v : relabeling.old_id) {
+        for (const Vertex* w = outgoing_begin(G, old_v); w != outgoing_end(G, old_v); ++w) {
+            for (int copy = edge_multiplicity(G, w); copy > 0; copy--) {
+                sources.push_back(new_id[old_v]);
+                targets.push_back(new_id[*w]);
+            }
+        }
+        for (int loop = G->self_loops ? G->self_loops[old_v] : 0; loop > 0; loop--) {
+            sources.push_back(new_id[old_v]);
+            targets.push_back(new_id[old_v]);
+        }
+    }
+    return build_graph(G->num_nodes, (int) sources.size(), sources.data(), targets.data());
+}
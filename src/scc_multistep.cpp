@@ -0,0 +1,225 @@
+#include "scc_multistep.hpp"
+#include "trim.hpp"
+#include <omp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+// Abaixo disso cada passo da coloração roda numa thread só
+#define MULTISTEP_PARALLEL_MIN 4096
+#define MULTISTEP_TASK_GRAIN 1024
+
+static SCCBackend& backend_setting()
+{
+    static SCCBackend backend = [] {
+        const char* env = getenv("SCC_BACKEND");
+        return (env && strcmp(env, "multistep") == 0) ? SCC_BACKEND_MULTISTEP : SCC_BACKEND_PIVOT;
+    }();
+    return backend;
+}
+
+SCCBackend scc_backend()
+{
+    return backend_setting();
+}
+
+void set_scc_backend(SCCBackend backend)
+{
+    backend_setting() = backend;
+}
+
+const char* scc_backend_name()
+{
+    return scc_backend() == SCC_BACKEND_MULTISTEP ? "multistep" : "pivot";
+}
+
+// Mesmo esquema do trim: serial, taskloop dentro de região paralela ou parallel for
+template <typename Body>
+static void multistep_for(int count, Body body)
+{
+    if (count < MULTISTEP_PARALLEL_MIN) {
+        for (int i = 0; i < count; i++) body(i, 0);
+    } else if (omp_in_parallel()) {
+        #pragma omp taskloop grainsize(MULTISTEP_TASK_GRAIN)
+        for (int i = 0; i < count; i++) body(i, omp_get_thread_num());
+    } else {
+        #pragma omp parallel for schedule(dynamic, MULTISTEP_TASK_GRAIN)
+        for (int i = 0; i < count; i++) body(i, omp_get_thread_num());
+    }
+}
+
+// *p = max(*p, value); true se aumentou
+static inline bool atomic_max(int* p, int value)
+{
+    int old = __atomic_load_n(p, __ATOMIC_RELAXED);
+    while (old < value) {
+        if (__atomic_compare_exchange_n(p, &old, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            return true;
+    }
+    return false;
+}
+
+std::vector<std::vector<int>> multistep_SCCs(Graph G, const std::vector<int>& active, int min_vertex,
+                                             SCCScratch& scratch)
+{
+    const int n = G->num_nodes;
+    std::vector<std::vector<int>> SCCs;
+    if (min_vertex >= n) return SCCs;
+
+    scratch.resize(n);
+    EpochMarks& assigned = scratch.assigned;
+    assigned.clear();
+    auto alive = [&](int v) {
+        return active[v] != 0 && v >= min_vertex && !assigned.marked(v);
+    };
+
+    const int threads = std::max(omp_get_max_threads(), omp_get_num_threads());
+    std::vector<std::vector<int>>& local_next = scratch.local_next;
+    if ((int) local_next.size() < threads) local_next.resize(threads);
+
+    // 1) Trim-1/Trim-2
+    trim_trivial_sccs(G, active, min_vertex, scratch, SCCs);
+
+    // 2) Um FW-BW a partir do vértice de maior grau_entrada * grau_saída, que
+    //    quase sempre está na SCC gigante (graus do trim, válidos para os vivos)
+    int pivot = -1;
+    int64_t best = -1;
+    for (int v = min_vertex; v < n; v++) {
+        if (!alive(v)) continue;
+        int64_t score = (int64_t) scratch.in_degree[v] * scratch.out_degree[v];
+        if (score > best) {
+            best = score;
+            pivot = v;
+        }
+    }
+    if (pivot < 0) return SCCs;
+
+    EpochMarks& visited_fwd = scratch.visited_fwd;
+    EpochMarks& visited_bwd = scratch.visited_bwd;
+    std::vector<int>& reached_fwd = scratch.reached_fwd;
+    FrontierBuffers& frontier = scratch.frontier;
+
+    visited_fwd.clear();
+    reached_fwd.clear();
+    frontier.start(pivot);
+    visited_fwd.mark(pivot);
+    reached_fwd.push_back(pivot);
+    while (!frontier.current.empty()) {
+        for (int u : frontier.current) {
+            for (const Vertex* w = outgoing_begin(G, u); w != outgoing_end(G, u); ++w) {
+                if (alive(*w) && !visited_fwd.marked(*w)) {
+                    visited_fwd.mark(*w);
+                    reached_fwd.push_back(*w);
+                    frontier.next.push_back(*w);
+                }
+            }
+        }
+        frontier.advance();
+    }
+
+    visited_bwd.clear();
+    frontier.start(pivot);
+    visited_bwd.mark(pivot);
+    while (!frontier.current.empty()) {
+        for (int u : frontier.current) {
+            for (const Vertex* w = incoming_begin(G, u); w != incoming_end(G, u); ++w) {
+                if (visited_fwd.marked(*w) && !visited_bwd.marked(*w)) {
+                    visited_bwd.mark(*w);
+                    frontier.next.push_back(*w);
+                }
+            }
+        }
+        frontier.advance();
+    }
+
+    std::vector<int> giant;
+    for (int v : reached_fwd) {
+        if (visited_bwd.marked(v)) giant.push_back(v);
+    }
+    for (int v : giant) assigned.mark(v);
+    SCCs.push_back(std::move(giant));
+
+    // 3) Coloração: color[v] = maior vértice que alcança v no que sobrou.
+    //    Cada raiz (color[r] == r) tem como SCC os vértices da sua cor que
+    //    alcançam r, achados por uma busca para trás restrita à cor. Raízes
+    //    diferentes têm cores disjuntas, então as buscas rodam em paralelo.
+    //    Cada rodada remove pelo menos a SCC do maior vértice restante.
+    std::vector<int>& color = scratch.color;
+    std::vector<int> remaining;
+    for (int v = min_vertex; v < n; v++) {
+        if (alive(v)) remaining.push_back(v);
+    }
+
+    std::vector<int> roots;
+    std::vector<std::vector<std::vector<int>>> local_sccs(threads);
+
+    while (!remaining.empty()) {
+        multistep_for((int) remaining.size(), [&](int i, int) { color[remaining[i]] = remaining[i]; });
+
+        // Propagação do máximo pelas arestas de saída até estabilizar
+        frontier.current = remaining;
+        while (!frontier.current.empty()) {
+            const std::vector<int>& current = frontier.current;
+            visited_fwd.clear(); // já está na próxima fronteira
+            multistep_for((int) current.size(), [&](int i, int tid) {
+                const int v = current[i];
+                const int c = __atomic_load_n(&color[v], __ATOMIC_RELAXED);
+                for (const Vertex* w = outgoing_begin(G, v); w != outgoing_end(G, v); ++w) {
+                    if (alive(*w) && atomic_max(&color[*w], c) && visited_fwd.try_mark(*w)) {
+                        local_next[tid].push_back(*w);
+                    }
+                }
+            });
+            frontier.next.clear();
+            for (std::vector<int>& local : local_next) {
+                frontier.next.insert(frontier.next.end(), local.begin(), local.end());
+                local.clear();
+            }
+            frontier.advance();
+        }
+
+        roots.clear();
+        for (int v : remaining) {
+            if (color[v] == v) roots.push_back(v);
+        }
+
+        // Busca para trás de cada raiz dentro da sua cor; a própria SCC serve de fila
+        visited_bwd.clear();
+        multistep_for((int) roots.size(), [&](int i, int tid) {
+            const int r = roots[i];
+            std::vector<int> scc;
+            scc.push_back(r);
+            visited_bwd.mark(r);
+            for (size_t head = 0; head < scc.size(); head++) {
+                const int u = scc[head];
+                for (const Vertex* w = incoming_begin(G, u); w != incoming_end(G, u); ++w) {
+                    if (alive(*w) && color[*w] == r && !visited_bwd.marked(*w)) {
+                        visited_bwd.mark(*w);
+                        scc.push_back(*w);
+                    }
+                }
+            }
+            local_sccs[tid].push_back(std::move(scc));
+        });
+
+        for (std::vector<std::vector<int>>& local : local_sccs) {
+            for (std::vector<int>& scc : local) {
+                for (int v : scc) assigned.mark(v);
+                SCCs.push_back(std::move(scc));
+            }
+            local.clear();
+        }
+
+        remaining.erase(std::remove_if(remaining.begin(), remaining.end(),
+                                       [&](int v) { return assigned.marked(v); }),
+                        remaining.end());
+    }
+
+    return SCCs;
+}
+
+void canonicalize_sccs(std::vector<std::vector<int>>& SCCs)
+{
+    for (std::vector<int>& scc : SCCs) std::sort(scc.begin(), scc.end());
+    std::sort(SCCs.begin(), SCCs.end());
+}
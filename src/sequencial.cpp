@@ -1,4 +1,8 @@
 #include "sequencial.hpp"
+#include "dense_scc.hpp"
+#include "trim.hpp"
+#include "scc_multistep.hpp"
+#include "query_limits.h"
 
 
 #define DEBUG 0
@@ -6,82 +10,96 @@
 std::vector<std::vector<int>> BFS_foward_backward_SCCs(
     Graph G, // grafo
     const std::vector<int>& active, // vetor indicando se vértice está ativo (1) ou inativo (0) (ao invés de remover do grafo, marca como inativo)
-    int min_vertex // menor vértice a considerar (todos < min_vertex são inativos)
+    int min_vertex, // menor vértice a considerar (todos < min_vertex são inativos)
+    SCCScratch& scratch // arrays com carimbo de época reaproveitados entre chamadas
 ){
     
+    // Backend alternativo (Multistep); mesmo conjunto de SCCs em outra ordem
+    if (scc_backend() == SCC_BACKEND_MULTISTEP) {
+        return multistep_SCCs(G, active, min_vertex, scratch);
+    }
+
     std::vector<std::vector<int>> SCCs;
+    scratch.resize(G->num_nodes);
 
-    // removed[i] = 1 significa que já foi processado (já está em alguma SCC)
-    std::vector<int> removed(G->num_nodes, 0);
-    
-    // Marca vértices inativos como já removidos, e também vértices < min_vertex
-    for (int i = 0; i < G->num_nodes; i++) {
-        if (active[i] == 0 || i < min_vertex) {
-            removed[i] = 1;
-        }
-    }
+    // assigned marca quem já está em alguma SCC; inativos e < min_vertex são
+    // testados direto, sem varrer os n vértices para inicializar nada
+    EpochMarks& assigned = scratch.assigned;
+    assigned.clear();
+    auto removed = [&](int v) {
+        return active[v] == 0 || v < min_vertex || assigned.marked(v);
+    };
+
+    // Trim-1/Trim-2: vértices sem entrada/saída ativa e pares isolados viram
+    // SCCs direto, em O(grau), sem BFS
+    trim_trivial_sccs(G, active, min_vertex, scratch, SCCs);
+
+    EpochMarks& visited_fwd = scratch.visited_fwd;
+    EpochMarks& visited_bwd = scratch.visited_bwd;
+    std::vector<int>& reached_fwd = scratch.reached_fwd; // lista do que o forward visitou
+    FrontierBuffers& frontier = scratch.frontier;
 
     for (int pivot = min_vertex; pivot < G->num_nodes; pivot++) {
 
-        if (removed[pivot] == 1) continue; // já removido ou inativo
+        if (removed(pivot)) continue; // já removido ou inativo
 
         // BFS forward (seguindo arestas de saída)
-        std::vector<bool> visited_fwd(G->num_nodes, false);
-        std::vector<int> frontier_fwd;
-        frontier_fwd.push_back(pivot);
-        visited_fwd[pivot] = true;
-
-        while (!frontier_fwd.empty()) {
-            std::vector<int> new_frontier;
-            for (int u : frontier_fwd) {
+        visited_fwd.clear();
+        reached_fwd.clear();
+        frontier.start(pivot);
+        visited_fwd.mark(pivot);
+        reached_fwd.push_back(pivot);
+
+        while (!frontier.current.empty()) {
+            for (int u : frontier.current) {
                 const Vertex* out_begin = outgoing_begin(G, u);
                 const Vertex* out_end = outgoing_end(G, u);
                 for (const Vertex* neighbor = out_begin; neighbor != out_end; ++neighbor) {
                     int v = *neighbor;
-                    if (removed[v] == 0 && !visited_fwd[v]) {
-                        visited_fwd[v] = true;
-                        new_frontier.push_back(v);
+                    if (!removed(v) && !visited_fwd.marked(v)) {
+                        visited_fwd.mark(v);
+                        reached_fwd.push_back(v);
+                        frontier.next.push_back(v);
                     }
                 }
             }
-            frontier_fwd = new_frontier;
+            frontier.advance();
         }
 
-        // BFS backward (seguindo arestas de entrada)
-        std::vector<bool> visited_bwd(G->num_nodes, false);
-        std::vector<int> frontier_bwd;
-        frontier_bwd.push_back(pivot);
-        visited_bwd[pivot] = true;
+        // BFS backward (seguindo arestas de entrada). Todo caminho u -> pivot
+        // de um u da SCC fica dentro da SCC, então basta andar dentro do que
+        // o forward alcançou
+        visited_bwd.clear();
+        frontier.start(pivot);
+        visited_bwd.mark(pivot);
 
-        while (!frontier_bwd.empty()) {
-            std::vector<int> new_frontier;
-            for (int u : frontier_bwd) {
+        while (!frontier.current.empty()) {
+            for (int u : frontier.current) {
                 const Vertex* in_begin = incoming_begin(G, u);
                 const Vertex* in_end = incoming_end(G, u);
                 for (const Vertex* neighbor = in_begin; neighbor != in_end; ++neighbor) {
                     int v = *neighbor;
-                    if (removed[v] == 0 && !visited_bwd[v]) {
-                        visited_bwd[v] = true;
-                        new_frontier.push_back(v);
+                    if (visited_fwd.marked(v) && !visited_bwd.marked(v)) {
+                        visited_bwd.mark(v);
+                        frontier.next.push_back(v);
                     }
                 }
             }
-            frontier_bwd = new_frontier;
+            frontier.advance();
         }
 
-        // Intersecção = vértices alcançáveis nos dois sentidos = SCC
+        // Intersecção = vértices alcançáveis nos dois sentidos = SCC.
+        // Percorre só a lista do forward: O(alcançados), não O(n)
         std::vector<int> current_SCC;
-        for (int i = 0; i < G->num_nodes; i++) {
-            if (visited_fwd[i] && visited_bwd[i]) {
-                current_SCC.push_back(i);
-                removed[i] = 1; // marca como processado
+        for (int v : reached_fwd) {
+            if (visited_bwd.marked(v)) {
+                current_SCC.push_back(v);
+                assigned.mark(v); // marca como processado
             }
         }
 
-        // Adiciona SCC encontrada (mesmo se tiver 1 vértice)
-        if (!current_SCC.empty()) {
-            SCCs.push_back(current_SCC);
-        }
+        // Adiciona SCC encontrada (mesmo se tiver 1 vértice; o pivô sempre está nela)
+        SCCs.push_back(std::move(current_SCC));
     }
 
     return SCCs;
@@ -102,6 +120,16 @@ void unblock(
 }
 
 
+// Estado da enumeração ciclo a ciclo (JohnsonRun com sink, max_cycles ou max_length)
+struct CycleListing {
+    JohnsonRun* run;
+    std::vector<int> path; // s ... v
+    uint64_t delivered = 0; // ciclos entregues ao sink (offset da saída para o checkpoint)
+};
+
+// LISTING => mantém o caminho, entrega cada ciclo ao sink e para cedo;
+// WEIGHTED => o grafo tem multiplicidades e path_weight é o produto delas
+template <bool LISTING, bool WEIGHTED>
 bool circuit(
     int v, // vértice atual da recursão (onde está)
     int s, // vértice de origem (onde começou a busca e deve terminar o ciclo)
@@ -109,11 +137,20 @@ bool circuit(
     const std::unordered_set<int>& scc_set, // conjunto de vértices da SCC atual; qualquer vértice fora desse conjunto é ignorado.
     std::vector<bool>& blocked, // vetor de vértices bloqueados (dependência)
     std::vector<std::unordered_set<int>>& B, // vetor de conjuntos; B[w] armazena vértices que devem ser desbloqueados se w for desbloqueado. (dependência)
-    int& cycle_count // contador de ciclos encontrados (dependência)
+    uint64_t& cycle_count, // contador de ciclos encontrados (dependência)
+    uint64_t path_weight = 1, // produto das multiplicidades das arestas de s até v (grafo normalizado)
+    CycleListing* listing = nullptr
 ) {
 
+    // Consulta parada (limite ou cancelamento): volta sem mexer no estado
+    if (query_step()) return false;
+
     bool found_cycle = false;
     blocked[v] = true;
+    if (LISTING) listing->path.push_back(v);
+    // No limite de comprimento só a aresta de volta para s ainda serve
+    const bool at_max_length = LISTING && listing->run->max_length &&
+                               (int) listing->path.size() >= listing->run->max_length;
 
     const Vertex* out_begin = outgoing_begin(G, v);
     const Vertex* out_end = outgoing_end(G, v);
@@ -126,15 +163,32 @@ bool circuit(
         }
 
         if (w == s) {
-            // Ciclo encontrado
-            cycle_count++;
+            // Ciclo encontrado (vale pelo produto das multiplicidades)
+            const uint64_t weight = extend_path_weight<WEIGHTED>(path_weight, edge_multiplicity(G, neighbor));
+            cycle_count = local_count_add(cycle_count, weight);
+            query_cycles(weight);
             found_cycle = true;
+            if (LISTING) {
+                JohnsonRun* run = listing->run;
+                if (run->sink) listing->delivered++;
+                if ((run->sink && !(*run->sink)(listing->path, weight)) ||
+                    (run->max_cycles && cycle_count >= run->max_cycles)) {
+                    run->stopped = true;
+                }
+            }
+        } else if (at_max_length) {
+            if (!blocked[w]) found_cycle = true; // ramo cortado: v não pode ficar bloqueado
         } else if (!blocked[w]) {
-            if (circuit(w, s, G, scc_set, blocked, B, cycle_count)) {
+            if (circuit<LISTING, WEIGHTED>(w, s, G, scc_set, blocked, B, cycle_count,
+                                           extend_path_weight<WEIGHTED>(path_weight, edge_multiplicity(G, neighbor)),
+                                           listing)) {
                 found_cycle = true;
             }
         }
+        // Parada pedida: o estado de bloqueio não importa mais
+        if (LISTING && listing->run->stopped) return found_cycle;
     }
+    if (LISTING) listing->path.pop_back();
 
     if (found_cycle) {
         unblock(v, blocked, B);
@@ -153,48 +207,226 @@ bool circuit(
 
 }
 
-int johnson_cycles(
-    Graph G // grafo
+// Rótulos de componente mantidos entre iterações de s: a decomposição do
+// grafo inteiro é feita uma vez e depois só a componente que perdeu o seu s
+// é redecomposta, quando (e se) um vértice dela vira o próximo s.
+struct ComponentLabels {
+    std::vector<int> label;                 // label[v] = componente de v (vale para v ativo)
+    std::vector<std::vector<int>> vertices; // vértices de cada componente
+    std::vector<char> dirty;                // perdeu um vértice desde que foi calculada
+
+    int add(std::vector<int>&& scc) {
+        const int id = (int) vertices.size();
+        for (int v : scc) label[v] = id;
+        vertices.push_back(std::move(scc));
+        dirty.push_back(0);
+        return id;
+    }
+};
+
+// Limite de pares (predecessor, sucessor) de s testados por stays_connected
+#define STAYS_CONNECTED_MAX_PAIRS 256
+
+// Teste barato e suficiente de que a componente id continua fortemente
+// conexa sem s: todo caminho que passava por u -> s -> w pode ser desviado se
+// u == w ou se existe a aresta u -> w. Cobre cliques, caminhos bidirecionais
+// etc.; quando não decide (ou há pares demais), devolve false e a componente
+// é redecomposta.
+static bool stays_connected(
+    Graph G,
+    const std::vector<int>& active,
+    int s,
+    int id,
+    const ComponentLabels& comps,
+    SCCScratch& scratch
+) {
+    auto inside = [&](int v) { return v != s && active[v] != 0 && comps.label[v] == id; };
+
+    std::vector<int> preds, succs;
+    for (const Vertex* u = incoming_begin(G, s); u != incoming_end(G, s); ++u) {
+        if (inside(*u)) preds.push_back(*u);
+    }
+    for (const Vertex* w = outgoing_begin(G, s); w != outgoing_end(G, s); ++w) {
+        if (inside(*w)) succs.push_back(*w);
+    }
+    if (preds.size() * succs.size() > STAYS_CONNECTED_MAX_PAIRS) return false;
+
+    EpochMarks& out_of_u = scratch.visited_fwd;
+    for (int u : preds) {
+        out_of_u.clear();
+        for (const Vertex* w = outgoing_begin(G, u); w != outgoing_end(G, u); ++w) {
+            out_of_u.mark(*w);
+        }
+        for (int w : succs) {
+            if (w != u && !out_of_u.marked(w)) return false;
+        }
+    }
+    return true;
+}
+
+// Redecompõe a componente id, que perdeu vértices (já inativos), com o laço
+// de pivôs restrito aos seus vértices ativos: custa O(componente), não O(n).
+// Cada pedaço ganha um rótulo novo.
+static void split_component(
+    Graph G,
+    const std::vector<int>& active,
+    int id,
+    ComponentLabels& comps,
+    SCCScratch& scratch
+) {
+    std::vector<int> members;
+    members.swap(comps.vertices[id]);
+
+    scratch.resize(G->num_nodes);
+    EpochMarks& assigned = scratch.assigned;
+    EpochMarks& visited_fwd = scratch.visited_fwd;
+    EpochMarks& visited_bwd = scratch.visited_bwd;
+    std::vector<int>& reached_fwd = scratch.reached_fwd;
+    FrontierBuffers& frontier = scratch.frontier;
+    assigned.clear();
+
+    auto inside = [&](int v) {
+        return active[v] != 0 && comps.label[v] == id && !assigned.marked(v);
+    };
+
+    for (int pivot : members) {
+        if (!inside(pivot)) continue;
+
+        visited_fwd.clear();
+        reached_fwd.clear();
+        frontier.start(pivot);
+        visited_fwd.mark(pivot);
+        reached_fwd.push_back(pivot);
+        while (!frontier.current.empty()) {
+            for (int u : frontier.current) {
+                for (const Vertex* w = outgoing_begin(G, u); w != outgoing_end(G, u); ++w) {
+                    if (inside(*w) && !visited_fwd.marked(*w)) {
+                        visited_fwd.mark(*w);
+                        reached_fwd.push_back(*w);
+                        frontier.next.push_back(*w);
+                    }
+                }
+            }
+            frontier.advance();
+        }
+
+        visited_bwd.clear();
+        frontier.start(pivot);
+        visited_bwd.mark(pivot);
+        while (!frontier.current.empty()) {
+            for (int u : frontier.current) {
+                for (const Vertex* w = incoming_begin(G, u); w != incoming_end(G, u); ++w) {
+                    if (visited_fwd.marked(*w) && !visited_bwd.marked(*w)) {
+                        visited_bwd.mark(*w);
+                        frontier.next.push_back(*w);
+                    }
+                }
+            }
+            frontier.advance();
+        }
+
+        std::vector<int> piece;
+        for (int v : reached_fwd) {
+            if (visited_bwd.marked(v)) {
+                piece.push_back(v);
+                assigned.mark(v);
+            }
+        }
+        // rótulo só depois de marcar: inside() ainda precisa ver os
+        // vértices restantes com o rótulo antigo
+        comps.add(std::move(piece));
+    }
+}
+
+static bool any_done(const Checkpoint* checkpoint, const std::vector<int>& vertices)
+{
+    for (int v : vertices) {
+        if (checkpoint->done(v)) return true;
+    }
+    return false;
+}
+
+cycle_count_t johnson_cycles(
+    Graph G, // grafo
+    bool count_only, // só contagem: permite o caminho rápido das SCCs densas
+    JohnsonRun* run // sink, limite e tempos (opcional)
 ) {
 
     int n = G->num_nodes;
     int s = 0; 
-    int cycle_count = 0;
+    uint64_t cycle_count = 0;
+    cycle_count_t dense_count = 0; // ciclos contados sem enumeração
     std::vector<int> active(G->num_nodes, 1); // todos ativos inicialmente
+    // Filtro global: vértices que não estão em nenhum ciclo nunca viram s
+    trim_acyclic_vertices(G, active);
+    SCCScratch scc_scratch; // rascunho da decomposição, reaproveitado a cada s
+
+    JohnsonRun local_run;
+    if (!run) run = &local_run;
+    const bool listing_mode = run->sink || run->max_cycles || run->max_length;
+    run->stopped = false;
+    CycleListing listing = {run, {}};
+    if (listing_mode) count_only = false;
+    const bool weighted = has_edge_multiplicity(G); // senão todo caminho vale 1
+    Checkpoint* checkpoint = run->checkpoint;
 
     double SCC_time = 0.0;
     double circuit_time = 0.0;
-    
 
-    while (s < n)
+    // Decomposição inicial, uma vez só: rótulo de componente de cada vértice
+    // ativo, sem std::find por s
+    ComponentLabels comps;
+    comps.label.assign(n, -1);
     {
-
         double startSCC = CycleTimer::currentSeconds();
+        std::vector<std::vector<int>> SCCs = BFS_foward_backward_SCCs(G, active, 0, scc_scratch);
+        for (std::vector<int>& scc : SCCs) {
+            comps.add(std::move(scc));
+        }
+        SCC_time += CycleTimer::currentSeconds() - startSCC;
 
-        std::vector<std::vector<int>> SCCs = BFS_foward_backward_SCCs(G, active, s);
+        if (DEBUG){
+            std::cout << "Number of SCCs: " << comps.vertices.size() << std::endl;
+        }
+    }
+    
 
-        double endSCC = CycleTimer::currentSeconds();
-        SCC_time += (endSCC - startSCC);
+    while (s < n && !run->stopped)
+    {
+        if (query_poll(s)) { // limite da consulta ou cancelamento
+            run->stopped = true;
+            break;
+        }
 
-        if (DEBUG){
-            std::cout << "Number of SCCs: " << SCCs.size() << std::endl;
-        }
-        
-        
-        std::vector<int> scc_vertices;
-        for (const std::vector<int>& scc : SCCs) {
-            if (std::find(scc.begin(), scc.end(), s) != scc.end()) {
-                scc_vertices = scc;
-                break;
-            }
+        if (!active[s]) {
+            s++;
+            continue; // removido pelo trim global: não está em nenhum ciclo
         }
 
-        if (scc_vertices.empty()) {
+        // Concluído numa execução anterior: sai da componente como se
+        // tivesse acabado de rodar
+        if (checkpoint && checkpoint->done(s)) {
             active[s] = 0;
-            s++;
-            continue; // nenhuma SCC contém s, passa para o próximo s
+            std::vector<int>& rest = comps.vertices[comps.label[s]];
+            rest.erase(std::find(rest.begin(), rest.end(), s));
+            comps.dirty[comps.label[s]] = rest.size() > 1;
+            ++s;
+            continue;
         }
 
+        double startSCC = CycleTimer::currentSeconds();
+
+        // Só a componente de s é redecomposta, e só se perdeu vértices
+        int id = comps.label[s];
+        if (comps.dirty[id]) {
+            split_component(G, active, id, comps, scc_scratch);
+            id = comps.label[s];
+        }
+        const std::vector<int>& scc_vertices = comps.vertices[id];
+
+        double endSCC = CycleTimer::currentSeconds();
+        SCC_time += (endSCC - startSCC);
+
         if (DEBUG){
             std::cout << "SCC containing " << s << ": ";
             for (int v : scc_vertices) {
@@ -203,25 +435,91 @@ int johnson_cycles(
             std::cout << std::endl;
         }
 
+        // Caminho rápido: conta todos os ciclos da SCC de uma vez e desativa
+        // a SCC inteira (nenhum ciclo restante passa por ela)
+        // Com checkpoint, só se nenhum vértice da SCC já foi concluído fora
+        // de ordem (os ciclos de menor vértice nele já estão no total)
+        if (count_only && !G->outgoing_multiplicity && !(checkpoint && any_done(checkpoint, scc_vertices))) {
+            cycle_count_t scc_count;
+            const DenseCountResult dense = dense_scc_count(G, scc_vertices, scc_count);
+            if (dense == DENSE_COUNT_STOPPED) {
+                // Parcial da DP: entra no total como os ciclos que o
+                // QueryGuard já contou, e a SCC não fica concluída
+                dense_count = cycle_count_add(dense_count, scc_count);
+                run->stopped = true;
+                break;
+            }
+            if (dense == DENSE_COUNT_DONE) {
+                dense_count = cycle_count_add(dense_count, scc_count);
+                for (int v : scc_vertices) {
+                    active[v] = 0;
+                }
+                if (checkpoint) checkpoint->complete_all(scc_vertices, scc_count);
+                ++s;
+                continue;
+            }
+        }
+
         // unordered_set para busca O(1)
         std::unordered_set<int> scc_set(scc_vertices.begin(), scc_vertices.end());
 
         std::vector<bool> blocked(n, false);
         std::vector<std::unordered_set<int>> B(n);
 
+        const uint64_t cycles_before = cycle_count;
+        const uint64_t delivered_before = listing.delivered;
         double startCircuit = CycleTimer::currentSeconds();
-        circuit(s, s, G, scc_set, blocked, B, cycle_count);
+        if (listing_mode) {
+            listing.path.clear();
+            if (weighted) circuit<true, true>(s, s, G, scc_set, blocked, B, cycle_count, 1, &listing);
+            else circuit<true, false>(s, s, G, scc_set, blocked, B, cycle_count, 1, &listing);
+        } else if (weighted) {
+            circuit<false, true>(s, s, G, scc_set, blocked, B, cycle_count);
+        } else {
+            circuit<false, false>(s, s, G, scc_set, blocked, B, cycle_count);
+        }
         double endCircuit = CycleTimer::currentSeconds();
         circuit_time += (endCircuit - startCircuit);
+        if (query_stopped()) run->stopped = true;
+        // s interrompido não conta como concluído: a retomada refaz ele inteiro
+        if (checkpoint && !run->stopped) {
+            // contador saturado: o s entra como overflow
+            const uint64_t s_cycles = cycle_count == UINT64_MAX ? UINT64_MAX : cycle_count - cycles_before;
+            checkpoint->complete(s, local_count_total(s_cycles), listing.delivered - delivered_before);
+        }
 
         active[s] = 0; 
+
+        // Sem s a componente pode se partir. Com 1 vértice restante, ou se o
+        // teste local garante que continua conexa, segue sendo uma SCC; senão
+        // fica para redecompor quando o próximo s cair nela
+        std::vector<int>& rest = comps.vertices[id];
+        rest.erase(std::find(rest.begin(), rest.end(), s));
+        comps.dirty[id] = rest.size() > 1 &&
+                          !stays_connected(G, active, s, id, comps, scc_scratch);
         ++s;
     }
 
-    printf("Total SCC time: %.6f seconds\n", SCC_time);
-    printf("Total circuit time: %.6f seconds\n", circuit_time);
-
-
-    return cycle_count;
+    run->scc_time = SCC_time;
+    run->circuit_time = circuit_time;
+
+    // Laços próprios separados pela normalização (não estão nas listas)
+    if (listing_mode && G->self_loops) {
+        std::vector<int> loop(1);
+        for (int v = 0; v < n && !run->stopped; v++) {
+            if (G->self_loops[v] == 0) continue;
+            loop[0] = v;
+            cycle_count = local_count_add(cycle_count, G->self_loops[v]);
+            if ((run->sink && !(*run->sink)(loop, G->self_loops[v])) ||
+                (run->max_cycles && cycle_count >= run->max_cycles)) {
+                run->stopped = true;
+            }
+        }
+        return checkpoint ? cycle_count_add(local_count_total(cycle_count), checkpoint->resumed_cycles())
+                          : local_count_total(cycle_count);
+    }
+    cycle_count_t total = cycle_count_add(cycle_count_add(local_count_total(cycle_count), dense_count),
+                                          separate_self_loops(G));
+    return checkpoint ? cycle_count_add(total, checkpoint->resumed_cycles()) : total;
     
 }
\ No newline at end of file
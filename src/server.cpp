@@ -0,0 +1,383 @@
+#include "server.hpp"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <sstream>
+#include <omp.h>
+#include "CycleTimer.h"
+
+// Maior linha aceita (listas de vértices longas cabem)
+#define SERVER_MAX_LINE (1 << 26)
+
+struct CycleServer::Connection {
+    int fd;
+    std::string in;
+    size_t in_pos = 0;
+    std::string out;
+    bool ok = true;   // false depois de um erro de escrita (cliente foi embora)
+
+    explicit Connection(int fd) : fd(fd) {}
+
+    bool read_line(std::string& line)
+    {
+        for (;;) {
+            const size_t end = in.find('\n', in_pos);
+            if (end != std::string::npos) {
+                line.assign(in, in_pos, end - in_pos);
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                in_pos = end + 1;
+                return true;
+            }
+            in.erase(0, in_pos);
+            in_pos = 0;
+            if (in.size() > SERVER_MAX_LINE) return false;
+            char chunk[4096];
+            const ssize_t got = recv(fd, chunk, sizeof(chunk), 0);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) return false;
+            in.append(chunk, got);
+        }
+    }
+
+    bool write(const std::string& text)
+    {
+        out += text;
+        return out.size() < SERVER_WRITE_BUFFER || flush();
+    }
+
+    bool flush()
+    {
+        size_t sent = 0;
+        while (ok && sent < out.size()) {
+            const ssize_t n = send(fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            // EAGAIN: SO_SNDTIMEO venceu, o cliente parou de ler
+            if (n <= 0) ok = false;
+            else sent += n;
+        }
+        out.clear();
+        return ok;
+    }
+};
+
+static bool parse_engine(const std::string& name, CycleEngine& engine)
+{
+    if (name == "seq" || name == "sequential") {
+        engine = CYCLE_ENGINE_SEQUENTIAL;
+        return true;
+    }
+    if (name.size() == 2 && name[0] == 'v' && name[1] >= '0' && name[1] <= '7') {
+        engine = (CycleEngine) (CYCLE_ENGINE_V0 + (name[1] - '0'));
+        return true;
+    }
+    return false;
+}
+
+// "3,7,10-20" => vértices ordenados e sem repetição, todos < n
+static bool parse_vertices(const std::string& text, int n, std::vector<int>& vertices)
+{
+    std::stringstream list(text);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        char* end;
+        const long first = strtol(item.c_str(), &end, 10);
+        long last = first;
+        if (*end == '-') last = strtol(end + 1, &end, 10);
+        if (end == item.c_str() || *end || first < 0 || last < first || last >= n) return false;
+        for (long v = first; v <= last; v++) vertices.push_back((int) v);
+    }
+    std::sort(vertices.begin(), vertices.end());
+    vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+    return !vertices.empty();
+}
+
+static std::string stop_word(QueryStop reason)
+{
+    std::string word = query_stop_name(reason);
+    std::replace(word.begin(), word.end(), ' ', '-');
+    return word;
+}
+
+CycleServer::CycleServer(const std::string& socket_path, double send_timeout)
+    : socket_path(socket_path), send_timeout(send_timeout)
+{
+}
+
+CycleServer::~CycleServer()
+{
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        unlink(socket_path.c_str());
+    }
+}
+
+void CycleServer::add_graph(const std::string& name, Graph G)
+{
+    graphs[name] = G;
+}
+
+bool CycleServer::listen(std::string& error)
+{
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        error = "socket path too long: " + socket_path;
+        return false;
+    }
+    strcpy(addr.sun_path, socket_path.c_str());
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        error = std::string("socket: ") + strerror(errno);
+        return false;
+    }
+    unlink(socket_path.c_str());
+    if (bind(listen_fd, (sockaddr*) &addr, sizeof(addr)) != 0 || ::listen(listen_fd, 64) != 0) {
+        error = socket_path + ": " + strerror(errno);
+        close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+    return true;
+}
+
+void CycleServer::serve()
+{
+    std::vector<std::thread::id> finished;
+    std::mutex finished_mutex;
+    while (!stopping.load()) {
+        const int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break; // stop() fechou o socket de escuta
+        }
+        if (stopping.load()) {
+            close(fd);
+            break;
+        }
+        // O sink de list escreve com run_mutex tomado: um cliente que não lê
+        // não pode segurar a fila mais que send_timeout
+        if (send_timeout > 0) {
+            timeval timeout;
+            timeout.tv_sec = (time_t) send_timeout;
+            timeout.tv_usec = (suseconds_t) ((send_timeout - timeout.tv_sec) * 1e6);
+            setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        }
+
+        // Junta as threads de conexões que já terminaram
+        {
+            std::lock_guard<std::mutex> lock(finished_mutex);
+            for (std::thread::id id : finished) {
+                auto it = std::find_if(clients.begin(), clients.end(),
+                                       [id](const std::thread& t) { return t.get_id() == id; });
+                if (it != clients.end()) {
+                    it->join();
+                    clients.erase(it);
+                }
+            }
+            finished.clear();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            client_fds.insert(fd);
+        }
+        clients.emplace_back([this, fd, &finished, &finished_mutex] {
+            handle(fd);
+            {
+                std::lock_guard<std::mutex> lock(state_mutex);
+                client_fds.erase(fd);
+            }
+            close(fd);
+            std::lock_guard<std::mutex> lock(finished_mutex);
+            finished.push_back(std::this_thread::get_id());
+        });
+    }
+
+    stop();
+    for (std::thread& t : clients) t.join();
+    clients.clear();
+    close(listen_fd);
+    listen_fd = -1;
+    unlink(socket_path.c_str());
+}
+
+void CycleServer::stop()
+{
+    stopping.store(true);
+    if (listen_fd >= 0) shutdown(listen_fd, SHUT_RDWR);
+    // A contagem em andamento (e as que esperam run_mutex) param no próximo
+    // query_step; conexões paradas na leitura acordam
+    cancel_runs.cancel();
+    std::lock_guard<std::mutex> lock(state_mutex);
+    for (int fd : client_fds) shutdown(fd, SHUT_RD);
+}
+
+void CycleServer::handle(int fd)
+{
+    Connection conn(fd);
+    std::string line;
+    while (conn.ok && conn.read_line(line)) {
+        std::vector<std::string> words;
+        std::stringstream tokens(line);
+        for (std::string word; tokens >> word;) words.push_back(word);
+        if (words.empty()) continue;
+
+        const std::string& command = words[0];
+        if (command == "quit") break;
+        if (command == "shutdown") {
+            conn.write("ok\n");
+            conn.flush();
+            stop();
+            break;
+        }
+        if (command == "graphs") {
+            for (const auto& entry : graphs) {
+                conn.write("graph " + entry.first + " nodes=" + std::to_string(entry.second->num_nodes) +
+                           " edges=" + std::to_string(entry.second->num_edges) + "\n");
+            }
+            conn.write("ok graphs=" + std::to_string(graphs.size()) + "\n");
+        } else if (command == "stats") {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            conn.write("ok queries=" + std::to_string(queries) + " cache_hits=" + std::to_string(cache_hits) +
+                       " cached=" + std::to_string(cache.size()) + "\n");
+        } else if (command == "count" || command == "list") {
+            if (!query(conn, words, command == "list")) continue;
+        } else {
+            conn.write("error unknown command " + command + "\n");
+        }
+        conn.flush();
+    }
+}
+
+// false => a conexão caiu no meio da resposta
+bool CycleServer::query(Connection& conn, const std::vector<std::string>& words, bool list)
+{
+    auto fail = [&conn](const std::string& message) {
+        conn.write("error " + message + "\n");
+        return true;
+    };
+    if (words.size() < 2) return fail("missing graph name");
+    auto found = graphs.find(words[1]);
+    if (found == graphs.end()) return fail("unknown graph " + words[1]);
+    Graph G = found->second;
+
+    CycleEnumeratorOptions options;
+    std::vector<int> vertices;
+    std::string vertex_text;
+    uint64_t max_cycles = 0;
+    for (size_t i = 2; i < words.size(); i++) {
+        const size_t eq = words[i].find('=');
+        const std::string key = words[i].substr(0, eq);
+        const std::string value = eq == std::string::npos ? "" : words[i].substr(eq + 1);
+        if (key == "engine") {
+            if (!parse_engine(value, options.engine)) return fail("invalid engine " + value);
+        } else if (key == "threads") {
+            // Limitado aos processadores: o pool do processo é um só
+            options.threads = atoi(value.c_str());
+            if (options.threads < 0) return fail("invalid threads");
+            options.threads = std::min(options.threads, omp_get_num_procs());
+        } else if (key == "vertices") {
+            if (!parse_vertices(value, G->num_nodes, vertices)) return fail("invalid vertex list");
+        } else if (key == "max-length") {
+            options.max_length = atoi(value.c_str());
+            if (options.max_length < 0) return fail("invalid max-length");
+        } else if (key == "through") {
+            options.through = atoi(value.c_str());
+            if (options.through < 0 || options.through >= G->num_nodes) return fail("invalid through vertex");
+        } else if (key == "through-edge") {
+            if (sscanf(value.c_str(), "%d,%d", &options.through, &options.through_next) != 2 ||
+                options.through < 0 || options.through >= G->num_nodes ||
+                options.through_next < 0 || options.through_next >= G->num_nodes)
+                return fail("invalid through-edge (use U,V)");
+        } else if (key == "count-only") {
+            options.count_only = true;
+        } else if (key == "max-seconds") {
+            options.limits.max_seconds = atof(value.c_str());
+        } else if (key == "max-cycles") {
+            max_cycles = strtoull(value.c_str(), NULL, 10);
+        } else if (key == "max-search-nodes") {
+            options.limits.max_search_nodes = strtoull(value.c_str(), NULL, 10);
+        } else {
+            return fail("unknown option " + key);
+        }
+    }
+    options.limits.cancel = &cancel_runs;
+    // list já roda ciclo a ciclo: o limite de ciclos pode ser exato
+    if (list) options.max_cycles = max_cycles;
+    else options.limits.max_cycles = max_cycles;
+
+    // Alvo de through com os ids do subgrafo induzido
+    std::vector<int> target = {options.through, options.through_next};
+    for (int& v : target) {
+        if (v < 0 || vertices.empty()) continue;
+        auto it = std::lower_bound(vertices.begin(), vertices.end(), v);
+        if (it == vertices.end() || *it != v) return fail("through target outside the vertex list");
+        v = (int) (it - vertices.begin());
+    }
+
+    // Chave do cache: a contagem exata não depende da versão nem das threads
+    std::string key = words[1] + " " + std::to_string(options.max_length) + " " +
+                      std::to_string(options.through) + " " + std::to_string(options.through_next) + " ";
+    for (int v : vertices) key += std::to_string(v) + ",";
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        queries++;
+        auto hit = cache.find(key);
+        if (!list && hit != cache.end()) {
+            cache_hits++;
+            conn.write("ok cycles=" + cycle_count_str(hit->second.cycles) + " exact=1 stop=none engine=" +
+                       cycle_engine_name(hit->second.engine) + " seconds=0 queued=0 cached=1\n");
+            return true;
+        }
+    }
+
+    options.through = target[0];
+    options.through_next = target[1];
+
+    // Subgrafo induzido (fora da fila); os ids voltam pelo vetor vertices
+    Graph subgraph = NULL;
+    if (!vertices.empty()) subgraph = induced_subgraph(G, vertices.data(), (int) vertices.size());
+
+    if (list) {
+        options.sink = [&conn, &vertices](const std::vector<int>& cycle, uint64_t multiplicity) {
+            std::string text = "cycle " + std::to_string(multiplicity);
+            for (int v : cycle) text += " " + std::to_string(vertices.empty() ? v : vertices[v]);
+            text += "\n";
+            return conn.write(text);
+        };
+    }
+
+    const double t0 = CycleTimer::currentSeconds();
+    CycleEnumeratorStats stats;
+    double queued;
+    {
+        std::lock_guard<std::mutex> lock(run_mutex);
+        queued = CycleTimer::currentSeconds() - t0;
+        CycleEnumerator enumerator(subgraph ? subgraph : G, options);
+        stats = enumerator.run();
+    }
+    if (subgraph) free_graph(subgraph);
+    if (!conn.ok) return false;
+
+    if (stats.exact) {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        if (cache.size() >= SERVER_CACHE_ENTRIES) cache.clear();
+        cache[key] = CachedCount{stats.cycles, stats.engine};
+    }
+    const std::string stop = !stats.complete && stats.stop_reason == QUERY_STOP_NONE
+                                 ? "max-cycles" : stop_word(stats.stop_reason);
+    char timing[96];
+    snprintf(timing, sizeof(timing), " seconds=%.6f queued=%.6f cached=0\n", stats.seconds, queued);
+    conn.write("ok cycles=" + cycle_count_str(stats.cycles) + " exact=" + (stats.exact ? "1" : "0") +
+               " stop=" + stop + " engine=" + cycle_engine_name(stats.engine) +
+               " threads=" + std::to_string(stats.threads) + timing);
+    return true;
+}
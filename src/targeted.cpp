@@ -0,0 +1,224 @@
+#include "targeted.hpp"
+#include "query_limits.h"
+#include "CycleTimer.h"
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// SCC do alvo t (scc[0] == t). Nada de tamanho n: conjuntos com hash, do
+// tamanho do que as BFS tocam
+static std::vector<int> target_scc(Graph G, int t, int64_t& visited)
+{
+    std::unordered_set<int> seen[2] = {{t}, {t}};    // 0: para frente, 1: para trás
+    std::vector<int> queue[2] = {{t}, {t}};
+    size_t head[2] = {0, 0};
+    int closed = -1;
+    while (closed < 0) {
+        for (int dir = 0; dir < 2; dir++) {
+            if (head[dir] == queue[dir].size()) {
+                closed = dir; // fecho completo nesta direção
+                break;
+            }
+            const int v = queue[dir][head[dir]++];
+            const Vertex* begin = dir == 0 ? outgoing_begin(G, v) : incoming_begin(G, v);
+            const Vertex* end = dir == 0 ? outgoing_end(G, v) : incoming_end(G, v);
+            for (const Vertex* w = begin; w != end; ++w) {
+                if (seen[dir].insert(*w).second) queue[dir].push_back(*w);
+            }
+        }
+    }
+
+    // SCC = fecho na outra direção restrito ao fecho completo
+    const std::unordered_set<int>& bound = seen[closed];
+    std::unordered_set<int> in_scc = {t};
+    std::vector<int> scc = {t};
+    for (size_t i = 0; i < scc.size(); i++) {
+        const int v = scc[i];
+        const Vertex* begin = closed == 1 ? outgoing_begin(G, v) : incoming_begin(G, v);
+        const Vertex* end = closed == 1 ? outgoing_end(G, v) : incoming_end(G, v);
+        for (const Vertex* w = begin; w != end; ++w) {
+            if (bound.count(*w) && in_scc.insert(*w).second) scc.push_back(*w);
+        }
+    }
+    visited = (int64_t) seen[0].size();
+    for (int v : seen[1]) visited += !seen[0].count(v);
+    return scc;
+}
+
+// CSR da SCC com ids locais (global[0] é o alvo) e, se G tem
+// multiplicidades, a de cada aresta
+struct LocalGraph {
+    std::vector<int> global;
+    std::unordered_map<int, int> local;
+    std::vector<int> starts;
+    std::vector<int> edges;
+    std::vector<int> weight;    // vazio se !weighted
+    const bool weighted;
+
+    LocalGraph(Graph G, std::vector<int>&& scc) : global(std::move(scc)), weighted(has_edge_multiplicity(G))
+    {
+        const int k = (int) global.size();
+        local.reserve(k);
+        for (int i = 0; i < k; i++) local[global[i]] = i;
+        starts.reserve(k + 1);
+        for (int i = 0; i < k; i++) {
+            starts.push_back((int) edges.size());
+            for (const Vertex* w = outgoing_begin(G, global[i]); w != outgoing_end(G, global[i]); ++w) {
+                auto it = local.find(*w);
+                if (it == local.end()) continue;
+                edges.push_back(it->second);
+                if (weighted) weight.push_back(edge_multiplicity(G, w));
+            }
+        }
+        starts.push_back((int) edges.size());
+    }
+};
+
+struct TargetSearch {
+    const LocalGraph& L;
+    JohnsonRun* run;
+    std::vector<char> blocked;
+    std::vector<std::vector<int>> B;
+    std::vector<int> path;      // ids de G, a partir do alvo
+    uint64_t cycle_count = 0;
+
+    TargetSearch(const LocalGraph& L, JohnsonRun* run)
+        : L(L), run(run), blocked(L.global.size(), 0), B(L.global.size())
+    {
+    }
+
+    // Ciclo fechado pelo caminho atual; false => parar
+    bool deliver(uint64_t multiplicity)
+    {
+        cycle_count = local_count_add(cycle_count, multiplicity);
+        query_cycles(multiplicity);
+        return !((run->sink && !(*run->sink)(path, multiplicity)) ||
+                 (run->max_cycles && cycle_count >= run->max_cycles));
+    }
+
+    void unblock(int u)
+    {
+        blocked[u] = 0;
+        for (int w : B[u]) {
+            if (blocked[w]) unblock(w);
+        }
+        B[u].clear();
+    }
+
+    // Johnson a partir do vértice local 0, sem corte por id: os ciclos que
+    // voltam a 0 são exatamente os que passam pelo alvo. WEIGHTED = L.weighted
+    template <bool WEIGHTED>
+    bool circuit(int v, uint64_t path_weight)
+    {
+        if (query_step()) return false;
+
+        bool found_cycle = false;
+        blocked[v] = 1;
+        path.push_back(L.global[v]);
+        const bool at_max_length = run->max_length && (int) path.size() >= run->max_length;
+
+        for (int e = L.starts[v]; e < L.starts[v + 1]; e++) {
+            const int w = L.edges[e];
+            if (w == 0) {
+                found_cycle = true;
+                if (!deliver(extend_path_weight<WEIGHTED>(path_weight, WEIGHTED ? L.weight[e] : 1))) run->stopped = true;
+            } else if (at_max_length) {
+                if (!blocked[w]) found_cycle = true; // ramo cortado: v não pode ficar bloqueado
+            } else if (!blocked[w]) {
+                if (circuit<WEIGHTED>(w, extend_path_weight<WEIGHTED>(path_weight, WEIGHTED ? L.weight[e] : 1))) found_cycle = true;
+            }
+            if (run->stopped) return found_cycle;
+        }
+        path.pop_back();
+
+        if (found_cycle) {
+            unblock(v);
+        } else {
+            for (int e = L.starts[v]; e < L.starts[v + 1]; e++) {
+                std::vector<int>& waiting = B[L.edges[e]];
+                if (std::find(waiting.begin(), waiting.end(), v) == waiting.end()) waiting.push_back(v);
+            }
+        }
+        return found_cycle;
+    }
+};
+
+cycle_count_t cycles_through_vertex(Graph G, int vertex, JohnsonRun* run, TargetNeighborhood* neighborhood)
+{
+    JohnsonRun local_run;
+    if (!run) run = &local_run;
+    run->stopped = false;
+    if (query_poll(vertex)) {
+        run->stopped = true;
+        return 0;
+    }
+
+    double t0 = CycleTimer::currentSeconds();
+    TargetNeighborhood info;
+    LocalGraph L(G, target_scc(G, vertex, info.visited));
+    info.vertices = (int) L.global.size();
+    info.edges = (int64_t) L.edges.size();
+    if (neighborhood) *neighborhood = info;
+    double t1 = CycleTimer::currentSeconds();
+
+    TargetSearch search(L, run);
+    if (L.weighted) search.circuit<true>(0, 1);
+    else search.circuit<false>(0, 1);
+    if (query_stopped()) run->stopped = true;
+
+    // Laços próprios separados pela normalização (não estão no CSR local)
+    if (!run->stopped && G->self_loops && G->self_loops[vertex]) {
+        search.path.assign(1, vertex);
+        if (!search.deliver(G->self_loops[vertex])) run->stopped = true;
+    }
+    run->scc_time = t1 - t0;
+    run->circuit_time = CycleTimer::currentSeconds() - t1;
+    return local_count_total(search.cycle_count);
+}
+
+cycle_count_t cycles_through_edge(Graph G, int source, int target, JohnsonRun* run,
+                                  TargetNeighborhood* neighborhood)
+{
+    JohnsonRun local_run;
+    if (!run) run = &local_run;
+    run->stopped = false;
+    if (neighborhood) *neighborhood = TargetNeighborhood();
+    if (query_poll(source)) {
+        run->stopped = true;
+        return 0;
+    }
+
+    // Multiplicidade da aresta (entradas repetidas sem normalização)
+    uint64_t multiplicity = source == target && G->self_loops ? G->self_loops[source] : 0;
+    for (const Vertex* w = outgoing_begin(G, source); w != outgoing_end(G, source); ++w) {
+        if (*w == target) multiplicity += edge_multiplicity(G, w);
+    }
+    if (multiplicity == 0) return 0;
+
+    double t0 = CycleTimer::currentSeconds();
+    TargetNeighborhood info;
+    LocalGraph L(G, target_scc(G, source, info.visited));
+    info.vertices = (int) L.global.size();
+    info.edges = (int64_t) L.edges.size();
+    if (neighborhood) *neighborhood = info;
+    double t1 = CycleTimer::currentSeconds();
+
+    TargetSearch search(L, run);
+    auto next = L.local.find(target);
+    if (source == target) {
+        // Laço próprio: o único ciclo pela aresta é ela mesma
+        search.path.assign(1, source);
+        if (!search.deliver(multiplicity)) run->stopped = true;
+    } else if (next != L.local.end() && run->max_length != 1) {
+        // Fora da SCC de source nenhum ciclo usa a aresta
+        search.blocked[0] = 1;
+        search.path.push_back(source);
+        if (L.weighted) search.circuit<true>(next->second, multiplicity);
+        else search.circuit<false>(next->second, multiplicity);
+        if (query_stopped()) run->stopped = true;
+    }
+    run->scc_time = t1 - t0;
+    run->circuit_time = CycleTimer::currentSeconds() - t1;
+    return local_count_total(search.cycle_count);
+}
@@ -0,0 +1,167 @@
+#include "trim.hpp"
+#include <omp.h>
+#include <algorithm>
+
+// Abaixo disso o trim roda numa thread só
+#define TRIM_PARALLEL_MIN_VERTICES 4096
+#define TRIM_TASK_GRAIN 1024
+
+// Roda body(i, tid) para i em [0, count): serial em listas pequenas, taskloop
+// dentro de uma região paralela (single da v5, laço da v0), parallel for fora
+template <typename Body>
+static void trim_for(int count, Body body)
+{
+    if (count < TRIM_PARALLEL_MIN_VERTICES) {
+        for (int i = 0; i < count; i++) body(i, 0);
+    } else if (omp_in_parallel()) {
+        #pragma omp taskloop grainsize(TRIM_TASK_GRAIN)
+        for (int i = 0; i < count; i++) body(i, omp_get_thread_num());
+    } else {
+        #pragma omp parallel for schedule(dynamic, TRIM_TASK_GRAIN)
+        for (int i = 0; i < count; i++) body(i, omp_get_thread_num());
+    }
+}
+
+// Trim-1 até o ponto fixo e, se trim2, um passo de Trim-2 seguido de mais
+// Trim-1. Cada vértice removido vira uma SCC em SCCs (e é marcado em
+// scratch.assigned). Graus contam arestas (multiarestas e laços próprios
+// inclusive), então um vértice com laço próprio nunca chega a grau 0.
+static int trim_pass(Graph G, const std::vector<int>& active, int min_vertex,
+                     SCCScratch& scratch, std::vector<std::vector<int>>& SCCs, bool trim2)
+{
+    const int n = G->num_nodes;
+    const int candidates = n - min_vertex;
+    if (candidates <= 0) return 0;
+
+    scratch.resize(n);
+    EpochMarks& assigned = scratch.assigned;
+    std::vector<int>& in_degree = scratch.in_degree;
+    std::vector<int>& out_degree = scratch.out_degree;
+    std::vector<std::vector<int>>& local_next = scratch.local_next;
+    FrontierBuffers& frontier = scratch.frontier;
+
+    const int threads = std::max(omp_get_max_threads(), omp_get_num_threads());
+    if ((int) local_next.size() < threads) local_next.resize(threads);
+
+    auto alive = [&](int v) {
+        return v >= min_vertex && active[v] != 0 && !assigned.marked_atomic(v);
+    };
+
+    // Remover v tira uma aresta de entrada de cada sucessor e uma de saída de
+    // cada predecessor; quem chega a 0 entra na próxima fronteira uma vez só
+    auto peel = [&](int v, int tid) {
+        for (const Vertex* w = outgoing_begin(G, v); w != outgoing_end(G, v); ++w) {
+            if (alive(*w) && __atomic_sub_fetch(&in_degree[*w], 1, __ATOMIC_RELAXED) == 0 &&
+                assigned.try_mark(*w)) {
+                local_next[tid].push_back(*w);
+            }
+        }
+        for (const Vertex* u = incoming_begin(G, v); u != incoming_end(G, v); ++u) {
+            if (alive(*u) && __atomic_sub_fetch(&out_degree[*u], 1, __ATOMIC_RELAXED) == 0 &&
+                assigned.try_mark(*u)) {
+                local_next[tid].push_back(*u);
+            }
+        }
+    };
+
+    int trimmed = 0;
+    auto gather = [&]() {
+        frontier.next.clear();
+        for (std::vector<int>& local : local_next) {
+            for (int v : local) {
+                frontier.next.push_back(v);
+                SCCs.push_back({v});
+            }
+            local.clear();
+        }
+        trimmed += (int) frontier.next.size();
+        frontier.advance();
+    };
+
+    auto peel_until_fixpoint = [&]() {
+        while (!frontier.current.empty()) {
+            const std::vector<int>& current = frontier.current;
+            trim_for((int) current.size(), [&](int i, int tid) { peel(current[i], tid); });
+            gather();
+        }
+    };
+
+    // Graus no subgrafo ativo. Ninguém é marcado durante a contagem, para
+    // que todos os graus vejam o mesmo conjunto de vértices vivos
+    trim_for(candidates, [&](int i, int tid) {
+        const int v = min_vertex + i;
+        if (!alive(v)) return;
+        int in = 0, out = 0;
+        for (const Vertex* w = outgoing_begin(G, v); w != outgoing_end(G, v); ++w) {
+            if (alive(*w)) out++;
+        }
+        for (const Vertex* u = incoming_begin(G, v); u != incoming_end(G, v); ++u) {
+            if (alive(*u)) in++;
+        }
+        in_degree[v] = in;
+        out_degree[v] = out;
+        if (in == 0 || out == 0) local_next[tid].push_back(v);
+    });
+    for (std::vector<int>& local : local_next) {
+        for (int v : local) assigned.mark(v);
+    }
+    frontier.current.clear();
+    gather();
+    peel_until_fixpoint();
+
+    if (!trim2) return trimmed;
+
+    // Único vizinho vivo de v no sentido dado (-1 se for o próprio v)
+    auto only_neighbor = [&](int v, bool incoming) {
+        const Vertex* begin = incoming ? incoming_begin(G, v) : outgoing_begin(G, v);
+        const Vertex* end = incoming ? incoming_end(G, v) : outgoing_end(G, v);
+        for (const Vertex* u = begin; u != end; ++u) {
+            if (alive(*u)) return *u == v ? -1 : (int) *u;
+        }
+        return -1;
+    };
+
+    // Trim-2 (serial: os pares são raros e cada teste é O(grau))
+    for (int v = min_vertex; v < n; v++) {
+        if (!alive(v)) continue;
+        for (bool incoming : {true, false}) {
+            const std::vector<int>& degree = incoming ? in_degree : out_degree;
+            if (degree[v] != 1) continue;
+            const int u = only_neighbor(v, incoming);
+            if (u < 0 || degree[u] != 1 || only_neighbor(u, incoming) != v) continue;
+
+            assigned.mark(u);
+            assigned.mark(v);
+            SCCs.push_back({std::min(u, v), std::max(u, v)});
+            trimmed += 2;
+            peel(u, 0);
+            peel(v, 0);
+            break;
+        }
+    }
+    frontier.current.clear();
+    gather();
+    peel_until_fixpoint();
+
+    return trimmed;
+}
+
+int trim_trivial_sccs(Graph G, const std::vector<int>& active, int min_vertex,
+                      SCCScratch& scratch, std::vector<std::vector<int>>& SCCs)
+{
+    return trim_pass(G, active, min_vertex, scratch, SCCs, true);
+}
+
+int trim_acyclic_vertices(Graph G, std::vector<int>& active)
+{
+    SCCScratch scratch;
+    scratch.resize(G->num_nodes);
+    scratch.assigned.clear();
+
+    std::vector<std::vector<int>> trivial;
+    int trimmed = trim_pass(G, active, 0, scratch, trivial, false);
+    for (const std::vector<int>& scc : trivial) {
+        active[scc[0]] = 0;
+    }
+    return trimmed;
+}
@@ -0,0 +1,1329 @@
+// Suíte de regressão: roda todas as versões (sequencial e v0..v7) sobre
+// grafos cujo número de ciclos simples é conhecido analiticamente, sobre os
+// arquivos de datasets/ e sobre grafos aleatórios comparados com um oráculo
+// de força bruta. Cada execução paralela usa um número aleatório de threads.
+//
+// Uso: bin/test_cycles [diretorio_datasets] [area ...]
+// Cada área é uma função test_<area>; com nomes de área, só elas rodam.
+// A semente é impressa no início; TEST_SEED=<n> reproduz uma execução.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+#include <string>
+#include <vector>
+#include <random>
+#include <functional>
+#include <algorithm>
+#include <set>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <unistd.h>
+#include <string.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "common/graph.h"
+#include "common/cycle_count.h"
+#include "parallel_v0.hpp"
+#include "parallel_v1.hpp"
+#include "parallel_v2.hpp"
+#include "parallel_v3.hpp"
+#include "parallel_v4.hpp"
+#include "parallel_v5.hpp"
+#include "parallel_v6.hpp"
+#include "parallel_v7.hpp"
+#include "sequencial.hpp"
+#include "dense_scc.hpp"
+#include "scc_multistep.hpp"
+#include "reorder.hpp"
+#include "partition.hpp"
+#include "johnson.hpp"
+#include "numa_placement.h"
+#include "huge_pages.h"
+#include "checkpoint.h"
+#include "progress.h"
+#include "server.hpp"
+
+typedef cycle_count_t Count;
+
+struct Engine {
+    const char* name;
+    std::function<Count(Graph)> run;
+};
+
+static std::vector<Engine> engines()
+{
+    return {
+        {"sequencial", [](Graph g) { return johnson_cycles(g); }},
+        {"seq -c",     [](Graph g) { return johnson_cycles(g, true); }},
+        {"v0",         johnson_cycles_parallel_v0},
+        {"v1",         johnson_cycles_parallel_v1},
+        {"v2",         johnson_cycles_parallel_v2},
+        {"v3",         johnson_cycles_parallel_v3},
+        {"v4",         johnson_cycles_parallel_v4},
+        {"v5",         [](Graph g) { return johnson_cycles_parallel_v5(g); }},
+        {"v5 -c",      [](Graph g) { return johnson_cycles_parallel_v5(g, true); }},
+        {"v6",         [](Graph g) { return johnson_cycles_parallel_v6(g); }},
+        {"v6 -c",      [](Graph g) { return johnson_cycles_parallel_v6(g, true); }},
+        {"v6 -z",      [](Graph g) {
+            CompressedGraph compressed = compress_graph(g);
+            return johnson_cycles_parallel_v6(&compressed);
+        }},
+        {"v7",         [](Graph g) { return johnson_cycles_parallel_v7(g); }},
+        {"v7 omp",     [](Graph g) { return johnson_cycles_parallel_v7(g, TASK_SCHEDULER_OMP); }},
+        {"v7 steal",   [](Graph g) { return johnson_cycles_parallel_v7(g, TASK_SCHEDULER_STEALING); }},
+    };
+}
+
+static std::mt19937 rng;
+static int failures = 0;
+static int checks = 0;
+static std::string datasets_dir = "datasets";
+
+// ----------------------------------------------------------
+// Geradores de grafos
+// ----------------------------------------------------------
+
+struct EdgeList {
+    int n = 0;
+    std::vector<Vertex> src, dst;
+    void add(int u, int v) { src.push_back(u); dst.push_back(v); }
+    Graph build() const { return build_graph(n, (int) src.size(), src.data(), dst.data()); }
+};
+
+static EdgeList complete_digraph(int n)
+{
+    EdgeList e;
+    e.n = n;
+    for (int u = 0; u < n; u++)
+        for (int v = 0; v < n; v++)
+            if (u != v) e.add(u, v);
+    return e;
+}
+
+static EdgeList ring(int n, bool bidirectional)
+{
+    EdgeList e;
+    e.n = n;
+    for (int u = 0; u < n; u++) {
+        e.add(u, (u + 1) % n);
+        if (bidirectional) e.add((u + 1) % n, u);
+    }
+    return e;
+}
+
+// Grade rows x cols; bidirectional => cada aresta da grade nos dois sentidos,
+// senão apenas para a direita e para baixo (acíclico).
+static EdgeList grid(int rows, int cols, bool bidirectional)
+{
+    EdgeList e;
+    e.n = rows * cols;
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            int u = r * cols + c;
+            if (c + 1 < cols) {
+                e.add(u, u + 1);
+                if (bidirectional) e.add(u + 1, u);
+            }
+            if (r + 1 < rows) {
+                e.add(u, u + cols);
+                if (bidirectional) e.add(u + cols, u);
+            }
+        }
+    }
+    return e;
+}
+
+// K_n sem `missing` arestas escolhidas ao acaso
+static EdgeList near_complete_digraph(int n, int missing)
+{
+    EdgeList full = complete_digraph(n);
+    std::vector<size_t> idx(full.src.size());
+    for (size_t i = 0; i < idx.size(); i++) idx[i] = i;
+    std::shuffle(idx.begin(), idx.end(), rng);
+
+    EdgeList e;
+    e.n = n;
+    for (size_t i = missing; i < idx.size(); i++)
+        e.add(full.src[idx[i]], full.dst[idx[i]]);
+    return e;
+}
+
+static EdgeList random_digraph(int n, double p)
+{
+    EdgeList e;
+    e.n = n;
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    for (int u = 0; u < n; u++)
+        for (int v = 0; v < n; v++)
+            if (u != v && coin(rng) < p) e.add(u, v);
+    return e;
+}
+
+// n * degree arestas com extremos uniformes (O(arestas), para n grande)
+static EdgeList random_sparse_digraph(int n, double degree)
+{
+    EdgeList e;
+    e.n = n;
+    std::uniform_int_distribution<int> vertex(0, n - 1);
+    for (long i = 0; i < (long) (n * degree); i++) e.add(vertex(rng), vertex(rng));
+    return e;
+}
+
+// Blocos densos pequenos (cada um contém as SCCs não triviais) ligados só
+// do bloco i para blocos j > i, mais um anel bidirecional de 40 vértices;
+// IDs embaralhados para que as SCCs fiquem intercaladas
+static EdgeList scc_blocks_digraph(int blocks)
+{
+    std::vector<std::pair<int, int>> edges;
+    std::vector<int> first;
+    int n = 0;
+    std::uniform_int_distribution<int> size(1, 8);
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    for (int b = 0; b < blocks; b++) {
+        const int k = size(rng);
+        first.push_back(n);
+        for (int u = 0; u < k; u++)
+            for (int v = 0; v < k; v++)
+                if (u != v && coin(rng) < 0.35) edges.push_back({n + u, n + v});
+        n += k;
+    }
+    for (int u = 0; u < 40; u++) {
+        edges.push_back({n + u, n + (u + 1) % 40});
+        edges.push_back({n + (u + 1) % 40, n + u});
+    }
+    n += 40;
+    for (int b = 0; b + 1 < blocks; b++) {
+        std::uniform_int_distribution<int> later(b + 1, blocks - 1);
+        edges.push_back({first[b], first[later(rng)]});
+    }
+
+    std::vector<int> id(n);
+    for (int v = 0; v < n; v++) id[v] = v;
+    std::shuffle(id.begin(), id.end(), rng);
+    EdgeList e;
+    e.n = n;
+    for (const std::pair<int, int>& edge : edges) e.add(id[edge.first], id[edge.second]);
+    return e;
+}
+
+// ----------------------------------------------------------
+// Valores esperados
+// ----------------------------------------------------------
+
+// Ciclos simples do dígrafo completo: soma_{k=2}^{n} C(n,k) (k-1)!
+static Count complete_cycles(int n)
+{
+    Count total = 0;
+    Count binomial = 1;  // C(n,k)
+    Count factorial = 1; // (k-1)!
+    for (int k = 1; k <= n; k++) {
+        binomial = binomial * (n - k + 1) / k;
+        if (k >= 2) {
+            factorial = cycle_count_mul(factorial, k - 1);
+            total = cycle_count_add(total, cycle_count_mul(binomial, factorial));
+        }
+    }
+    return total;
+}
+
+// Oráculo independente: DFS sem bloqueio que conta, para cada s, os caminhos
+// simples s -> ... -> s usando apenas vértices > s.
+static void brute_dfs(Graph g, int v, int s, std::vector<char>& on_path, Count& count)
+{
+    for (const Vertex* it = outgoing_begin(g, v); it != outgoing_end(g, v); ++it) {
+        int w = *it;
+        if (w == s) count++;
+        else if (w > s && !on_path[w]) {
+            on_path[w] = 1;
+            brute_dfs(g, w, s, on_path, count);
+            on_path[w] = 0;
+        }
+    }
+}
+
+static Count brute_force_cycles(Graph g)
+{
+    Count count = 0;
+    std::vector<char> on_path(g->num_nodes, 0);
+    for (int s = 0; s < g->num_nodes; s++) {
+        on_path[s] = 1;
+        brute_dfs(g, s, s, on_path, count);
+        on_path[s] = 0;
+    }
+    return count;
+}
+
+// ----------------------------------------------------------
+// Execução
+// ----------------------------------------------------------
+
+static void check_true(const char* name, bool ok)
+{
+    checks++;
+    if (!ok) {
+        failures++;
+        fprintf(stderr, "FAIL %s\n", name);
+    } else {
+        printf("ok   %s\n", name);
+    }
+}
+
+static void check_all_engines(const std::string& name, Graph g, Count expected)
+{
+    int max_threads = 2 * omp_get_num_procs() + 2;
+    std::uniform_int_distribution<int> pick(1, max_threads);
+    int failures_before = failures;
+
+    for (const Engine& engine : engines()) {
+        int threads = pick(rng);
+        omp_set_num_threads(threads);
+        Count got = engine.run(g);
+        checks++;
+        if (got != expected) {
+            failures++;
+            fprintf(stderr, "FAIL %-28s %-10s threads=%-3d expected=%s got=%s\n",
+                    name.c_str(), engine.name, threads,
+                    cycle_count_str(expected).c_str(), cycle_count_str(got).c_str());
+        }
+    }
+    if (failures == failures_before)
+        printf("ok   %-28s expected=%s\n", name.c_str(), cycle_count_str(expected).c_str());
+}
+
+static void check_edges(const std::string& name, const EdgeList& e, Count expected)
+{
+    Graph g = e.build();
+    check_all_engines(name, g, expected);
+    free_graph(g);
+}
+
+// Árvore de tarefas: cada nó gera fanout filhas até depth e as folhas somam 1.
+// A raiz gera mais filhas do que cabe no deque inicial (STEAL_DEQUE_CAPACITY)
+template <typename Scheduler>
+static void spawn_tree(Scheduler& sched, int depth, int fanout, std::atomic<long>& leaves)
+{
+    if (depth == 0) {
+        leaves.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    typename Scheduler::Group group;
+    for (int i = 0; i < fanout; i++) {
+        sched.spawn(group, [&sched, depth, &leaves]() { spawn_tree(sched, depth - 1, 3, leaves); });
+    }
+    sched.wait(group);
+}
+
+template <typename Scheduler>
+static bool scheduler_tree_ok(int threads)
+{
+    omp_set_num_threads(threads);
+    Scheduler sched;
+    std::atomic<long> leaves(0);
+    sched.run([&] { spawn_tree(sched, 5, 600, leaves); });
+    return leaves.load() == 600L * 3 * 3 * 3 * 3;
+}
+
+// Cliente do modo servidor: manda uma linha e lê as respostas até "ok" ou
+// "error" (inclusive); false se a conexão caiu
+static bool server_request(FILE* conn, const std::string& line, std::vector<std::string>& reply)
+{
+    reply.clear();
+    fprintf(conn, "%s\n", line.c_str());
+    fflush(conn);
+    char buffer[4096];
+    while (fgets(buffer, sizeof(buffer), conn)) {
+        std::string text(buffer);
+        if (!text.empty() && text.back() == '\n') text.pop_back();
+        reply.push_back(text);
+        if (text.compare(0, 2, "ok") == 0 || text.compare(0, 5, "error") == 0) return true;
+    }
+    return false;
+}
+
+static bool reply_has(const std::vector<std::string>& reply, const std::string& word)
+{
+    return !reply.empty() && (" " + reply.back() + " ").find(" " + word + " ") != std::string::npos;
+}
+
+// Aritmética saturada dos contadores
+static void test_counters()
+{
+    check_true("cycle_count_add satura", cycle_count_add(CYCLE_COUNT_MAX - 1, 2) == CYCLE_COUNT_MAX);
+    check_true("cycle_count_mul satura", cycle_count_mul(CYCLE_COUNT_MAX / 2, 3) == CYCLE_COUNT_MAX);
+    check_true("K14 > 2^32 sem wraparound", cycle_count_str(complete_cycles(14)) == "18348340113");
+}
+
+// Dígrafos completos
+static void test_closed_forms()
+{
+    for (int n = 1; n <= 8; n++)
+        check_edges("complete K" + std::to_string(n), complete_digraph(n), complete_cycles(n));
+
+    // Anéis: direcionado tem 1 ciclo; bidirecional tem n 2-ciclos + 2 sentidos
+    for (int n : {2, 3, 7, 64}) {
+        check_edges("ring " + std::to_string(n), ring(n, false), 1);
+        if (n >= 3)
+            check_edges("bi-ring " + std::to_string(n), ring(n, true), n + 2);
+    }
+}
+
+// Grande o bastante para a v5 decompor com a BFS paralela (forward e
+// backward simultâneos, troca top-down/bottom-up); só a v5, as outras
+// versões levam segundos aqui
+static void test_parallel_bfs()
+{
+    Graph g = ring(4500, true).build();
+    omp_set_num_threads(4);
+    check_true("v5 BFS paralela bi-ring 4500", johnson_cycles_parallel_v5(g) == 4500 + 2);
+    free_graph(g);
+}
+
+// Grades: a versão só direita/baixo é acíclica. A bidirecional tem um
+// 2-ciclo por aresta da grade mais 2 orientações de cada ciclo da grade
+// não-direcionada: C(n,2) para a escada 2 x n, 13 para 3x3 e 213 para 4x4.
+static void test_grids()
+{
+    check_edges("dag grid 5x5", grid(5, 5, false), 0);
+    for (int n : {2, 3, 6}) {
+        Count undirected_edges = 3 * n - 2;
+        Count ladder = (Count) n * (n - 1) / 2;
+        check_edges("bi-grid 2x" + std::to_string(n), grid(2, n, true), undirected_edges + 2 * ladder);
+    }
+    check_edges("bi-grid 3x3", grid(3, 3, true), 12 + 2 * 13);
+    check_edges("bi-grid 4x4", grid(4, 4, true), 24 + 2 * 213);
+}
+
+// Quase completos (inclusão-exclusão do caminho rápido) contra o oráculo
+static void test_dense()
+{
+    for (int missing = 1; missing <= DENSE_MAX_MISSING_EDGES + 2; missing++) {
+        EdgeList e = near_complete_digraph(9, missing);
+        Graph g = e.build();
+        check_all_engines("K9 minus " + std::to_string(missing), g, brute_force_cycles(g));
+        free_graph(g);
+    }
+
+    // Só o caminho rápido chega a tempo em SCCs completas grandes
+    for (int n : {14, 20, 21, 40}) {
+        Graph g = complete_digraph(n).build();
+        std::vector<int> all(n);
+        for (int v = 0; v < n; v++) all[v] = v;
+        cycle_count_t got = 0;
+        check_true(("dense_scc_count K" + std::to_string(n)).c_str(),
+                   dense_scc_count(g, all, got) == DENSE_COUNT_DONE && got == complete_cycles(n));
+        free_graph(g);
+    }
+
+    printf("kernel da DP: %s\n", dense_dp_kernel_name());
+}
+
+// Grafos aleatórios contra o oráculo de força bruta
+static void test_random()
+{
+    for (int i = 0; i < 12; i++) {
+        std::uniform_int_distribution<int> size(4, 14);
+        int n = size(rng);
+        double p = 0.15 + 0.05 * (i % 6);
+        EdgeList e = random_digraph(n, p);
+        Graph g = e.build();
+        check_all_engines("random n=" + std::to_string(n) + " #" + std::to_string(i), g, brute_force_cycles(g));
+        free_graph(g);
+    }
+    for (int i = 0; i < 3; i++) {
+        // SCCs maiores que DENSE_DP_MAX_VERTICES: -c cai no Johnson normal
+        Graph g = random_digraph(40, 0.06).build();
+        check_all_engines("sparse random n=40 #" + std::to_string(i), g, brute_force_cycles(g));
+        free_graph(g);
+    }
+}
+
+// Multigrafos: arestas repetidas e laços próprios. O grafo normalizado
+// (listas ordenadas sem repetição, multiplicidades e laços à parte) tem
+// que dar a mesma contagem que o original em todas as versões
+static void test_multigraphs()
+{
+    for (int i = 0; i < 4; i++) {
+        EdgeList simple = random_digraph(10, 0.25);
+        EdgeList e;
+        e.n = simple.n;
+        std::uniform_int_distribution<int> copies(1, 3);
+        for (size_t k = 0; k < simple.src.size(); k++) {
+            for (int c = copies(rng); c > 0; c--) e.add(simple.src[k], simple.dst[k]);
+        }
+        for (int v = i; v < e.n; v += 3) e.add(v, v);
+        // Repetições fora de ordem nas listas
+        const unsigned seed = rng();
+        std::mt19937 shuffle_src(seed), shuffle_dst(seed);
+        std::shuffle(e.src.begin(), e.src.end(), shuffle_src);
+        std::shuffle(e.dst.begin(), e.dst.end(), shuffle_dst);
+        Graph raw = e.build();
+        Graph normalized = normalize_graph(raw);
+
+        bool simple_lists = true;
+        uint64_t edges = separate_self_loops(normalized);
+        for (int v = 0; v < normalized->num_nodes; v++) {
+            for (const Vertex* w = outgoing_begin(normalized, v); w != outgoing_end(normalized, v); ++w) {
+                if (*w == v || (w != outgoing_begin(normalized, v) && *(w - 1) >= *w)) simple_lists = false;
+                edges += edge_multiplicity(normalized, w);
+            }
+        }
+        check_true(("multigrafo normalizado #" + std::to_string(i)).c_str(),
+                   simple_lists && edges == (uint64_t) raw->num_edges);
+
+        const Count expected = brute_force_cycles(raw);
+        check_all_engines("multigrafo #" + std::to_string(i), raw, expected);
+        check_all_engines("multigrafo normalizado #" + std::to_string(i), normalized, expected);
+        free_graph(normalized);
+        free_graph(raw);
+    }
+
+    // Produto das multiplicidades: um 3-ciclo com multiplicidade 2^21 em
+    // cada aresta vale 2^63 ciclos; com 2^22 são 2^66, overflow em todas
+    // as versões (o produto do caminho satura e o total fica saturado)
+    for (int bits : {21, 22}) {
+        Graph raw = ring(3, false).build();
+        Graph g = normalize_graph(raw);
+        free_graph(raw);
+        g->outgoing_multiplicity = (int*) malloc(sizeof(int) * g->num_edges);
+        for (int e = 0; e < g->num_edges; e++) g->outgoing_multiplicity[e] = 1 << bits;
+        const Count expected = bits == 21 ? (Count) 1 << 63 : CYCLE_COUNT_MAX;
+        check_all_engines("3-ciclo com multiplicidade 2^" + std::to_string(bits), g, expected);
+        check_true(("3-ciclo com multiplicidade 2^" + std::to_string(bits) + ": consulta dirigida").c_str(),
+                   cycles_through_vertex(g, 1) == expected && cycles_through_edge(g, 2, 0) == expected);
+        free_graph(g);
+    }
+}
+
+// Backend Multistep: mesma decomposição que o laço de pivôs depois da
+// forma canônica, com vértices inativos e min_vertex > 0, em grafos com
+// muitas SCCs pequenas e com uma gigante
+static void test_multistep()
+{
+    for (double degree : {1.0, 1.5, 3.0}) {
+        const int n = 20000;
+        Graph g = random_sparse_digraph(n, degree).build();
+        std::vector<int> active(n, 1);
+        for (int v = 0; v < n; v += 7) active[v] = 0;
+        SCCScratch scratch;
+        for (int min_vertex : {0, n / 3}) {
+            omp_set_num_threads(4);
+            set_scc_backend(SCC_BACKEND_PIVOT);
+            std::vector<std::vector<int>> pivot = BFS_foward_backward_SCCs(g, active, min_vertex, scratch);
+            std::vector<std::vector<int>> multistep = multistep_SCCs(g, active, min_vertex, scratch);
+            canonicalize_sccs(pivot);
+            canonicalize_sccs(multistep);
+            check_true(("multistep == pivot, grau " + std::to_string(degree).substr(0, 3) +
+                        " min_vertex=" + std::to_string(min_vertex)).c_str(), pivot == multistep);
+        }
+        free_graph(g);
+    }
+    set_scc_backend(SCC_BACKEND_MULTISTEP);
+    Graph g = random_digraph(40, 0.06).build();
+    check_all_engines("multistep sparse random n=40", g, brute_force_cycles(g));
+    free_graph(g);
+    set_scc_backend(SCC_BACKEND_PIVOT);
+}
+
+// Renumeração na carga: cada ordem é uma permutação e não muda o número
+// de ciclos (vale para qualquer versão; a sequencial basta). Blocos densos
+// pequenos em vez de um aleatório de grau 3: muitas SCCs para as ordens
+// mexerem e um número de ciclos limitado (o aleatório chegava a 5e7)
+static void test_relabeling()
+{
+    Graph g = scc_blocks_digraph(30).build();
+    const Count expected = brute_force_cycles(g);
+    for (VertexOrder order : {ORDER_DEGREE_ASC, ORDER_DEGREE_DESC, ORDER_SCC, ORDER_RCM, ORDER_GORDER}) {
+        VertexRelabeling relabeling = compute_vertex_order(g, order);
+        bool bijection = (int) relabeling.old_id.size() == g->num_nodes;
+        for (int v = 0; bijection && v < g->num_nodes; v++)
+            bijection = relabeling.old_id[relabeling.new_id[v]] == v;
+        Graph relabeled = relabel_graph(g, relabeling);
+        check_true((std::string("ordem ") + vertex_order_name(order) + " preserva ciclos").c_str(),
+                   bijection && johnson_cycles(relabeled) == expected);
+        free_graph(relabeled);
+    }
+    free_graph(g);
+}
+
+// Biblioteca: o mesmo CycleEnumerator roda todas as versões em sequência
+// sobre um multigrafo normalizado; o sink recebe cada ciclo uma vez (com
+// a multiplicidade) e max_cycles/sink param a enumeração
+static void test_library()
+{
+    EdgeList e = random_digraph(11, 0.3);
+    for (size_t k = 0; k < e.src.size(); k += 5) e.add(e.src[k], e.dst[k]);
+    e.add(3, 3);
+    Graph raw = e.build();
+    Graph g = normalize_graph(raw);
+    const Count expected = brute_force_cycles(raw);
+
+    CycleEnumerator enumerator(g);
+    CycleEnumeratorOptions options;
+    bool all_ok = true;
+    for (int engine = CYCLE_ENGINE_SEQUENTIAL; engine <= CYCLE_ENGINE_V7; engine++) {
+        options.engine = (CycleEngine) engine;
+        options.threads = 1 + engine % 3;
+        enumerator.set_options(options);
+        CycleEnumeratorStats stats = enumerator.run();
+        all_ok = all_ok && stats.cycles == expected && stats.complete && stats.engine == engine;
+    }
+    options.compressed = true;
+    enumerator.set_options(options);
+    all_ok = all_ok && enumerator.run().cycles == expected && enumerator.run().cycles == expected;
+    check_true("CycleEnumerator, todas as versões no mesmo grafo", all_ok);
+
+    std::set<std::vector<int>> seen;
+    Count listed = 0;
+    bool valid = true;
+    options = CycleEnumeratorOptions();
+    options.sink = [&](const std::vector<int>& cycle, uint64_t multiplicity) {
+        std::set<int> distinct(cycle.begin(), cycle.end());
+        valid = valid && distinct.size() == cycle.size() && *distinct.begin() == cycle[0] &&
+                seen.insert(cycle).second;
+        for (size_t i = 0; i < cycle.size() && cycle.size() > 1; i++) {
+            const int u = cycle[i], w = cycle[(i + 1) % cycle.size()];
+            valid = valid && std::find(outgoing_begin(g, u), outgoing_end(g, u), w) != outgoing_end(g, u);
+        }
+        listed += multiplicity;
+        return true;
+    };
+    enumerator.set_options(options);
+    CycleEnumeratorStats stats = enumerator.run();
+    check_true("CycleEnumerator, sink recebe cada ciclo",
+               valid && stats.complete && listed == expected && stats.cycles == expected);
+
+    int calls = 0;
+    options.sink = [&](const std::vector<int>&, uint64_t) { return ++calls < 3; };
+    enumerator.set_options(options);
+    stats = enumerator.run();
+    const bool sink_stops = calls == 3 && !stats.complete;
+    options.sink = nullptr;
+    options.max_cycles = expected / 2;
+    enumerator.set_options(options);
+    stats = enumerator.run();
+    check_true("CycleEnumerator, sink e max_cycles param cedo",
+               sink_stops && !stats.complete && stats.cycles >= expected / 2 && stats.cycles < expected);
+
+    // max_length: cada limite dá a soma dos ciclos listados com até
+    // esse comprimento (o corte não pode deixar vértices bloqueados)
+    std::vector<Count> by_length(g->num_nodes + 1, 0);
+    options = CycleEnumeratorOptions();
+    options.sink = [&](const std::vector<int>& cycle, uint64_t multiplicity) {
+        by_length[cycle.size()] += multiplicity;
+        return true;
+    };
+    enumerator.set_options(options);
+    enumerator.run();
+    bool length_ok = true;
+    Count up_to = 0;
+    options = CycleEnumeratorOptions();
+    for (int length = 1; length <= g->num_nodes; length++) {
+        up_to += by_length[length];
+        options.max_length = length;
+        enumerator.set_options(options);
+        stats = enumerator.run();
+        length_ok = length_ok && stats.exact && stats.cycles == up_to;
+    }
+    check_true("CycleEnumerator, max_length conta só os ciclos curtos", length_ok && up_to == expected);
+    free_graph(g);
+    free_graph(raw);
+}
+
+// Limites de consulta em todas as versões: nós de busca, prazo e token
+// cancelado por outra thread param cedo com contagem parcial (exact =
+// false); limites folgados não mudam nada
+static void test_query_limits()
+{
+    Graph g = complete_digraph(11).build();
+    const Count expected = complete_cycles(11);
+    CycleEnumerator enumerator(g);
+    CycleEnumeratorOptions options;
+    bool nodes_ok = true, deadline_ok = true, cancel_ok = true, loose_ok = true;
+    for (int engine = CYCLE_ENGINE_SEQUENTIAL; engine <= CYCLE_ENGINE_V7; engine++) {
+        options.engine = (CycleEngine) engine;
+        options.threads = 1 + engine % 3;
+
+        options.limits = QueryLimits();
+        options.limits.max_search_nodes = 20000;
+        enumerator.set_options(options);
+        CycleEnumeratorStats stats = enumerator.run();
+        nodes_ok = nodes_ok && !stats.exact && !stats.complete && stats.stop_reason == QUERY_STOP_SEARCH_NODES &&
+                   stats.cycles < expected && stats.search_nodes >= 20000;
+
+        options.limits = QueryLimits();
+        options.limits.max_seconds = 0.02;
+        enumerator.set_options(options);
+        stats = enumerator.run();
+        deadline_ok = deadline_ok && !stats.exact && stats.stop_reason == QUERY_STOP_DEADLINE &&
+                      stats.cycles < expected && stats.seconds < 2.0;
+
+        CancellationToken cancel;
+        options.limits = QueryLimits();
+        options.limits.cancel = &cancel;
+        enumerator.set_options(options);
+        std::thread canceller([&cancel] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            cancel.cancel();
+        });
+        stats = enumerator.run();
+        canceller.join();
+        cancel_ok = cancel_ok && !stats.exact && stats.stop_reason == QUERY_STOP_CANCELLED &&
+                    stats.cycles < expected;
+    }
+    Graph small = complete_digraph(7).build();
+    CycleEnumerator small_enumerator(small);
+    for (int engine = CYCLE_ENGINE_SEQUENTIAL; engine <= CYCLE_ENGINE_V7; engine++) {
+        options.engine = (CycleEngine) engine;
+        options.limits = QueryLimits();
+        options.limits.max_seconds = 600;
+        options.limits.max_search_nodes = 1ull << 40;
+        options.limits.max_cycles = 1ull << 40;
+        small_enumerator.set_options(options);
+        CycleEnumeratorStats stats = small_enumerator.run();
+        loose_ok = loose_ok && stats.exact && stats.cycles == complete_cycles(7) &&
+                   stats.stop_reason == QUERY_STOP_NONE;
+    }
+    // Caminhos rápidos de -c (fórmula do completo e DP por subconjuntos)
+    // também contam para max_cycles; com limite folgado a contagem é exata
+    bool dense_ok = true;
+    Graph dp_graph = random_digraph(14, 0.6).build();
+    for (Graph dense : {g, dp_graph}) {
+        const Count dense_expected = dense == g ? expected : brute_force_cycles(dense);
+        CycleEnumerator dense_enumerator(dense);
+        for (CycleEngine engine : {CYCLE_ENGINE_SEQUENTIAL, CYCLE_ENGINE_V5, CYCLE_ENGINE_V6}) {
+            options.engine = engine;
+            options.count_only = true;
+            options.limits = QueryLimits();
+            options.limits.max_cycles = 1000;
+            dense_enumerator.set_options(options);
+            CycleEnumeratorStats stats = dense_enumerator.run();
+            dense_ok = dense_ok && !stats.exact && stats.stop_reason == QUERY_STOP_MAX_CYCLES;
+
+            options.limits.max_cycles = 1ull << 40;
+            dense_enumerator.set_options(options);
+            stats = dense_enumerator.run();
+            dense_ok = dense_ok && stats.exact && stats.cycles == dense_expected;
+        }
+    }
+    options.count_only = false;
+    check_true("limites: max_cycles nos caminhos rápidos (sequencial, v5, v6 com -c)", dense_ok);
+
+    // Parada no meio da DP: a parcial devolvida é o que o QueryGuard contou,
+    // e não fica abaixo do limite que parou a consulta
+    bool partial_ok = true;
+    for (int version : {0, 6}) {
+        QueryLimits limits;
+        limits.max_cycles = 1000;
+        QueryGuard query(limits);
+        const Count c = version == 0 ? johnson_cycles(dp_graph, true) : johnson_cycles_parallel_v6(dp_graph, true);
+        partial_ok = partial_ok && query.reason() == QUERY_STOP_MAX_CYCLES && c >= 1000 &&
+                     c < brute_force_cycles(dp_graph) && query.progress().cycles == (uint64_t) c;
+    }
+    check_true("limites: parcial da DP igual aos ciclos vistos pela consulta", partial_ok);
+    free_graph(dp_graph);
+
+    check_true("limites: max_search_nodes em todas as versões", nodes_ok);
+    check_true("limites: prazo em todas as versões", deadline_ok);
+    check_true("limites: cancelamento por outra thread em todas as versões", cancel_ok);
+    check_true("limites folgados: contagem exata", loose_ok && query_active == nullptr);
+    free_graph(small);
+    free_graph(g);
+}
+
+// Progresso: os contadores por thread somam os s terminados das versões
+// fora de ordem (ciclos e nós só até o último acumulado publicado), e o
+// arquivo de status final diz "done" com a fração inteira
+static void test_progress()
+{
+    Graph g = complete_digraph(8).build();
+    const int n = g->num_nodes;
+    const Count expected = complete_cycles(8);
+    const std::string status = "/tmp/test_cycles_progress_" + std::to_string(getpid());
+    bool counters_ok = true, status_ok = true;
+    for (int version : {0, 5, 6}) {
+        QueryGuard query{QueryLimits()};
+        ProgressReporter reporter(query, g, 0.001, nullptr, status);
+        Count c = version == 0 ? johnson_cycles_parallel_v0(g)
+                : version == 5 ? johnson_cycles_parallel_v5(g)
+                               : johnson_cycles_parallel_v6(g, false);
+        reporter.stop();
+        const QueryProgress p = query.progress();
+        counters_ok = counters_ok && c == expected && p.unordered && p.finished == (uint64_t) n &&
+                      p.cycles > 0 && p.cycles <= (uint64_t) expected && p.search_nodes > 0 &&
+                      reporter.fraction_done(p) > 0.999;
+
+        FILE* f = fopen(status.c_str(), "r");
+        char state[32] = {0};
+        double fraction = 0.0;
+        status_ok = status_ok && f && fscanf(f, "state %31s\n", state) == 1 &&
+                    std::string(state) == "done";
+        while (f && !feof(f)) {
+            char key[64];
+            double value;
+            if (fscanf(f, "%63s %lf\n", key, &value) != 2) break;
+            if (std::string(key) == "fraction_done") fraction = value;
+        }
+        if (f) fclose(f);
+        status_ok = status_ok && fraction == 1.0;
+    }
+    // Com -c os caminhos rápidos (fórmula do completo e DP) publicam o que
+    // contam: o campo cycles do status chega ao total, não fica em zero
+    bool dense_ok = true;
+    Graph dp_graph = random_digraph(14, 0.6).build();
+    for (Graph dense : {g, dp_graph}) {
+        const Count dense_expected = dense == g ? expected : brute_force_cycles(dense);
+        for (int version : {0, 5, 6}) {
+            QueryGuard query{QueryLimits()};
+            ProgressReporter reporter(query, dense, 0.001, nullptr, status);
+            Count c = version == 0 ? johnson_cycles(dense, true)
+                    : version == 5 ? johnson_cycles_parallel_v5(dense, true)
+                                   : johnson_cycles_parallel_v6(dense, true);
+            reporter.stop();
+            const QueryProgress p = query.progress();
+
+            FILE* f = fopen(status.c_str(), "r");
+            double status_cycles = -1.0;
+            while (f && !feof(f)) {
+                char key[64];
+                double value;
+                if (fscanf(f, "%63s %lf\n", key, &value) != 2) {
+                    if (fscanf(f, "%*[^\n]\n") == EOF) break;
+                    continue;
+                }
+                if (std::string(key) == "cycles") status_cycles = value;
+            }
+            if (f) fclose(f);
+            dense_ok = dense_ok && c == dense_expected && p.cycles == (uint64_t) dense_expected &&
+                       status_cycles == (double) dense_expected;
+        }
+    }
+    unlink(status.c_str());
+    check_true("progresso: contadores por thread e s terminados fora de ordem", counters_ok);
+    check_true("progresso: arquivo de status final", status_ok);
+    check_true("progresso: ciclos dos caminhos rápidos (sequencial, v5, v6 com -c)", dense_ok);
+    free_graph(dp_graph);
+    free_graph(g);
+}
+
+// Modo servidor: contagem, subconjunto de vértices, limite de
+// comprimento e listagem pelo socket, com a repetição vinda do cache
+static void test_server()
+{
+    EdgeList e = random_digraph(12, 0.3);
+    Graph raw = e.build();
+    Graph g = normalize_graph(raw);
+    const Count expected = brute_force_cycles(raw);
+    std::vector<int> subset = {1, 2, 3, 5, 8, 9, 10};
+    Graph sub = induced_subgraph(g, subset.data(), (int) subset.size());
+    EdgeList sub_edges;
+    sub_edges.n = (int) subset.size();
+    for (size_t k = 0; k < e.src.size(); k++) {
+        auto a = std::find(subset.begin(), subset.end(), e.src[k]);
+        auto b = std::find(subset.begin(), subset.end(), e.dst[k]);
+        if (a != subset.end() && b != subset.end())
+            sub_edges.add((int) (a - subset.begin()), (int) (b - subset.begin()));
+    }
+    Graph sub_raw = sub_edges.build();
+    const Count sub_expected = brute_force_cycles(sub_raw);
+    check_true("subgrafo induzido: mesmos ciclos do subconjunto", johnson_cycles(sub) == sub_expected);
+
+    const std::string path = "/tmp/test_cycles_server_" + std::to_string(getpid()) + ".sock";
+    CycleServer server(path);
+    server.add_graph("g", g);
+    std::string error;
+    bool listening = server.listen(error);
+    std::thread serving([&server, listening] { if (listening) server.serve(); });
+
+    bool count_ok = false, subset_ok = false, list_ok = false, cache_ok = false, errors_ok = false;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path.c_str());
+    FILE* conn = listening && connect(fd, (sockaddr*) &addr, sizeof(addr)) == 0 ? fdopen(fd, "r+") : NULL;
+    std::vector<std::string> reply;
+    if (conn) {
+        const std::string total = "cycles=" + cycle_count_str(expected);
+        count_ok = server_request(conn, "count g engine=v5 threads=2", reply) && reply_has(reply, total) &&
+                   reply_has(reply, "exact=1") && reply_has(reply, "cached=0");
+        cache_ok = server_request(conn, "count g engine=v7", reply) && reply_has(reply, total) &&
+                   reply_has(reply, "cached=1");
+        subset_ok = server_request(conn, "count g vertices=1-3,5,8-10", reply) &&
+                    reply_has(reply, "cycles=" + cycle_count_str(sub_expected));
+
+        // Ciclos de até 3 vértices do subconjunto, com os ids do grafo
+        Count short_cycles = 0;
+        bool ids_ok = true;
+        list_ok = server_request(conn, "list g vertices=1-3,5,8-10 max-length=3", reply);
+        for (size_t k = 0; k + 1 < reply.size(); k++) {
+            std::stringstream words(reply[k]);
+            std::string tag;
+            unsigned long long multiplicity;
+            words >> tag >> multiplicity;
+            int count = 0;
+            for (int v; words >> v; count++)
+                ids_ok = ids_ok && std::find(subset.begin(), subset.end(), v) != subset.end();
+            ids_ok = ids_ok && tag == "cycle" && count >= 1 && count <= 3;
+            short_cycles += multiplicity;
+        }
+        CycleEnumeratorOptions options;
+        options.max_length = 3;
+        list_ok = list_ok && ids_ok && reply_has(reply, "exact=1") &&
+                  short_cycles == CycleEnumerator(sub, options).run().cycles &&
+                  reply_has(reply, "cycles=" + cycle_count_str(short_cycles));
+
+        // through com subconjunto: o alvo vira o id do subgrafo
+        subset_ok = subset_ok && server_request(conn, "count g vertices=1-3,5,8-10 through=3", reply) &&
+                    reply_has(reply, "cycles=" + cycle_count_str(cycles_through_vertex(sub, 2)));
+
+        errors_ok = server_request(conn, "count h", reply) && reply.back().compare(0, 5, "error") == 0 &&
+                    server_request(conn, "count g vertices=99", reply) && reply.back().compare(0, 5, "error") == 0;
+        server_request(conn, "shutdown", reply);
+        fclose(conn);
+    } else {
+        close(fd);
+    }
+    serving.join();
+    check_true("servidor: contagem e repetição pelo cache", listening && count_ok && cache_ok);
+    check_true("servidor: subconjunto de vértices e listagem com max-length", subset_ok && list_ok);
+    check_true("servidor: erros de consulta e shutdown", errors_ok && access(path.c_str(), F_OK) != 0);
+
+    // Um list cujo cliente não lê prende a fila só até o prazo de escrita;
+    // threads= acima dos processadores é limitado
+    Graph k_raw = complete_digraph(10).build();
+    Graph k = normalize_graph(k_raw);
+    CycleServer stalled_server(path, 0.2);
+    stalled_server.add_graph("k", k);
+    listening = stalled_server.listen(error);
+    std::thread stalled_serving([&stalled_server, listening] { if (listening) stalled_server.serve(); });
+    bool stalled_ok = false, threads_ok = false;
+    int stalled_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    int other_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    FILE* other = NULL;
+    if (listening && connect(stalled_fd, (sockaddr*) &addr, sizeof(addr)) == 0 &&
+        connect(other_fd, (sockaddr*) &addr, sizeof(addr)) == 0)
+        other = fdopen(other_fd, "r+");
+    if (other) {
+        const char request[] = "list k\n";
+        stalled_ok = send(stalled_fd, request, sizeof(request) - 1, 0) == (ssize_t) sizeof(request) - 1;
+        usleep(50000);
+        stalled_ok = stalled_ok && server_request(other, "count k engine=v5 threads=100000", reply) &&
+                     reply_has(reply, "cycles=" + cycle_count_str(complete_cycles(10)));
+        const size_t at = reply.empty() ? std::string::npos : reply.back().find(" threads=");
+        const int threads = at == std::string::npos ? 0 : atoi(reply.back().c_str() + at + 9);
+        threads_ok = threads >= 1 && threads <= omp_get_num_procs() &&
+                     server_request(other, "count k threads=-1", reply) && reply.back().compare(0, 5, "error") == 0;
+        server_request(other, "shutdown", reply);
+        fclose(other);
+    } else {
+        close(other_fd);
+        stalled_server.stop();
+    }
+    close(stalled_fd);
+    stalled_serving.join();
+    check_true("servidor: list de cliente que não lê solta a fila no prazo", listening && stalled_ok);
+    check_true("servidor: threads= limitado aos processadores", threads_ok);
+
+    // shutdown no meio de uma contagem sem limite: ela para como cancelada
+    // e serve() volta sem esperar o fim
+    Graph big_raw = complete_digraph(14).build();
+    Graph big = normalize_graph(big_raw);
+    CycleServer busy_server(path);
+    busy_server.add_graph("big", big);
+    listening = busy_server.listen(error);
+    std::thread busy_serving([&busy_server, listening] { if (listening) busy_server.serve(); });
+    bool cancelled_ok = false;
+    int busy_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    int stopper_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    FILE* busy = NULL;
+    FILE* stopper = NULL;
+    if (listening && connect(busy_fd, (sockaddr*) &addr, sizeof(addr)) == 0 &&
+        connect(stopper_fd, (sockaddr*) &addr, sizeof(addr)) == 0) {
+        busy = fdopen(busy_fd, "r+");
+        stopper = fdopen(stopper_fd, "r+");
+    }
+    if (busy && stopper) {
+        const double t0 = CycleTimer::currentSeconds();
+        fprintf(busy, "count big engine=seq\n");
+        fflush(busy);
+        usleep(100000);
+        server_request(stopper, "shutdown", reply);
+        char line[4096] = {0};
+        cancelled_ok = fgets(line, sizeof(line), busy) &&
+                       std::string(line).find("stop=cancelled") != std::string::npos &&
+                       std::string(line).find("exact=0") != std::string::npos;
+        busy_serving.join();
+        cancelled_ok = cancelled_ok && CycleTimer::currentSeconds() - t0 < 10.0;
+    } else {
+        busy_server.stop();
+        busy_serving.join();
+    }
+    if (busy) fclose(busy);
+    else close(busy_fd);
+    if (stopper) fclose(stopper);
+    else close(stopper_fd);
+    check_true("servidor: shutdown cancela a contagem em andamento", listening && cancelled_ok);
+    free_graph(big);
+    free_graph(big_raw);
+    free_graph(k);
+    free_graph(k_raw);
+    free_graph(sub_raw);
+    free_graph(sub);
+    free_graph(g);
+    free_graph(raw);
+}
+
+// Consultas dirigidas: por vértice e por aresta, comparadas com a lista
+// de todos os ciclos (multigrafo normalizado, com laços próprios); cada
+// ciclo sai uma vez, começando no alvo, e max_length vale também aqui
+static void test_targeted()
+{
+    bool vertex_ok = true, edge_ok = true, order_ok = true, length_ok = true;
+    for (int round = 0; round < 6; round++) {
+        EdgeList e = round % 2 ? random_digraph(10, 0.3) : scc_blocks_digraph(4);
+        for (size_t k = 0; k < e.src.size(); k += 7) e.add(e.src[k], e.dst[k]);
+        e.add(0, 0);
+        Graph raw = e.build();
+        Graph g = normalize_graph(raw);
+        const int n = g->num_nodes;
+
+        std::vector<std::pair<std::vector<int>, uint64_t>> all;
+        CycleEnumeratorOptions options;
+        options.sink = [&](const std::vector<int>& cycle, uint64_t multiplicity) {
+            all.push_back({cycle, multiplicity});
+            return true;
+        };
+        CycleEnumerator(g, options).run();
+        auto uses_edge = [](const std::vector<int>& cycle, int u, int v) {
+            for (size_t i = 0; i < cycle.size(); i++)
+                if (cycle[i] == u && cycle[(i + 1) % cycle.size()] == v) return true;
+            return false;
+        };
+
+        for (int t = 0; t < n; t++) {
+            Count expected = 0, short_expected = 0;
+            for (const auto& c : all) {
+                if (std::find(c.first.begin(), c.first.end(), t) == c.first.end()) continue;
+                expected += c.second;
+                if (c.first.size() <= 3) short_expected += c.second;
+            }
+            std::set<std::vector<int>> seen;
+            JohnsonRun run;
+            CycleSink sink = [&](const std::vector<int>& cycle, uint64_t) {
+                order_ok = order_ok && cycle[0] == t && seen.insert(cycle).second;
+                return true;
+            };
+            run.sink = &sink;
+            vertex_ok = vertex_ok && cycles_through_vertex(g, t, &run) == expected;
+
+            JohnsonRun bounded;
+            bounded.max_length = 3;
+            length_ok = length_ok && cycles_through_vertex(g, t, &bounded) == short_expected;
+
+            // Cada ciclo por t usa exatamente uma aresta que sai de t
+            Count by_edges = g->self_loops ? g->self_loops[t] : 0;
+            for (const Vertex* w = outgoing_begin(g, t); w != outgoing_end(g, t); ++w) {
+                Count through_edge = 0;
+                for (const auto& c : all)
+                    if (uses_edge(c.first, t, *w)) through_edge += c.second;
+                const Count found = cycles_through_edge(g, t, *w);
+                edge_ok = edge_ok && found == through_edge;
+                by_edges += found;
+            }
+            edge_ok = edge_ok && by_edges == expected;
+        }
+        options = CycleEnumeratorOptions();
+        options.through = 0;
+        options.through_next = 0;
+        CycleEnumeratorStats stats = CycleEnumerator(g, options).run();
+        edge_ok = edge_ok && stats.cycles == (Count) g->self_loops[0] && stats.neighborhood_vertices >= 1;
+        free_graph(g);
+        free_graph(raw);
+    }
+    check_true("ciclos por um vértice: mesmos da lista completa", vertex_ok && order_ok);
+    check_true("ciclos por uma aresta: somam os do vértice", edge_ok);
+    check_true("ciclos por um vértice com max_length", length_ok);
+}
+
+// Escalonadores da v7: toda tarefa roda uma vez, inclusive com o deque
+// de Chase-Lev crescendo, e o pool serve chamadas seguidas com números
+// de threads diferentes
+static void test_schedulers()
+{
+    std::uniform_int_distribution<int> pick(1, 2 * omp_get_num_procs() + 2);
+    bool all_ok = true;
+    for (int round = 0; round < 3; round++) {
+        all_ok = all_ok && scheduler_tree_ok<OmpTaskScheduler>(pick(rng));
+        all_ok = all_ok && scheduler_tree_ok<PoolTaskScheduler>(pick(rng));
+        all_ok = all_ok && scheduler_tree_ok<StealingTaskScheduler>(pick(rng));
+    }
+    check_true("escalonadores: árvore de tarefas (omp, pool, steal)", all_ok);
+}
+
+// NUMA com 2 nós simulados: cada thread fixada enxerga a réplica do seu
+// nó, e réplicas, grafo intercalado e roubo por nó não mudam a contagem
+static void test_numa()
+{
+    numa_simulate(2);
+    numa_set_pinning(true);
+    EdgeList e = random_digraph(12, 0.3);
+    for (size_t k = 0; k < e.src.size(); k += 4) e.add(e.src[k], e.dst[k]);
+    Graph raw = e.build();
+    Graph g = normalize_graph(raw);
+    const Count expected = brute_force_cycles(raw);
+
+    numa_replicate_graph(g);
+    Graph local[2] = {nullptr, nullptr};
+    std::vector<std::thread> pinned;
+    for (int t = 0; t < 2; t++) {
+        pinned.emplace_back([&, t] {
+            numa_pin_thread(t);
+            local[t] = numa_local_graph(g);
+        });
+    }
+    for (std::thread& t : pinned) t.join();
+    bool replicas_ok = local[0] != local[1] && local[0] != g && local[1] != g &&
+                       local[1]->num_edges == g->num_edges &&
+                       std::equal(g->outgoing_edges, g->outgoing_edges + g->num_edges, local[1]->outgoing_edges);
+    omp_set_num_threads(4);
+    replicas_ok = replicas_ok && johnson_cycles_parallel_v0(g) == expected &&
+                  johnson_cycles_parallel_v5(g) == expected;
+    numa_free_replicas();
+    check_true("NUMA: uma réplica por nó (v0, v5)", replicas_ok && numa_local_graph(g) == g);
+
+    numa_interleave_graph(g);
+    check_all_engines("NUMA: grafo intercalado", g, expected);
+    check_true("NUMA: roubo de trabalho por nó", scheduler_tree_ok<StealingTaskScheduler>(5));
+
+    numa_set_pinning(false);
+    numa_simulate(0);
+    free_graph(g);
+    free_graph(raw);
+}
+
+// Páginas grandes: blocos grandes alinhados a 2 MB (THP) ou do pool de
+// MAP_HUGETLB, que cai para THP se o pool estiver vazio; as versões
+// contam igual com o grafo e os rascunhos nessa memória
+static void test_huge_pages()
+{
+    set_huge_page_mode(HUGE_PAGES_THP);
+    HugePageStats before = huge_page_stats();
+    void* big = huge_alloc(3 * HUGE_PAGE_BYTES + 17);
+    bool aligned = ((uintptr_t) big % HUGE_PAGE_BYTES) == 0;
+    huge_free(big);
+    set_huge_page_mode(HUGE_PAGES_HUGETLB);
+    huge_free(huge_alloc(HUGE_PAGE_BYTES));
+    HugePageStats after = huge_page_stats();
+    check_true("páginas grandes: alocação THP e HUGETLB (ou fallback)",
+               aligned && after.thp_bytes + after.hugetlb_bytes > before.thp_bytes + before.hugetlb_bytes);
+
+    set_huge_page_mode(HUGE_PAGES_THP);
+    EdgeList e = random_digraph(12, 0.3);
+    Graph g = e.build();
+    const Count expected = brute_force_cycles(g);
+    huge_pages_graph(g);
+    huge_vector<int> marks(HUGE_PAGE_MIN_BYTES / sizeof(int), 7);
+    check_all_engines("páginas grandes (thp)", g, expected);
+    check_true("páginas grandes: huge_vector", marks.back() == 7 && ((uintptr_t) marks.data() % HUGE_PAGE_BYTES) == 0);
+    set_huge_page_mode(HUGE_PAGES_OFF);
+    free_graph(g);
+}
+
+// Checkpoint: uma contagem interrompida (max_cycles) e retomada, e um
+// conjunto fora de ordem de s concluídos (como a v5 deixa) retomado pela
+// sequencial com o caminho rápido e pela v5; o total tem que fechar
+static void test_checkpoint()
+{
+    char file[] = "/tmp/test_cycles_ckpt_XXXXXX";
+    const int fd = mkstemp(file);
+    if (fd < 0) {
+        perror("mkstemp");
+        check_true("checkpoint: arquivo temporário", false);
+        return;
+    }
+    close(fd);
+    EdgeList e = near_complete_digraph(8, 6);
+    const EdgeList tail = random_digraph(10, 0.3);
+    e.n = 18;
+    for (size_t k = 0; k < tail.src.size(); k++) e.add(tail.src[k] + 8, tail.dst[k] + 8);
+    e.add(2, 9);
+    e.add(12, 5);
+    Graph g = e.build();
+    const Count expected = brute_force_cycles(g);
+
+    // ciclos por menor vértice, pelo sink
+    std::vector<Count> per_s(g->num_nodes, 0);
+    JohnsonRun listing;
+    CycleSink sink = [&](const std::vector<int>& cycle, uint64_t multiplicity) {
+        per_s[cycle[0]] += multiplicity;
+        return true;
+    };
+    listing.sink = &sink;
+    johnson_cycles(g, false, &listing);
+
+    Checkpoint first(file, g, 1e9);
+    JohnsonRun run;
+    run.max_cycles = per_s[0] + 1;   // s = 0 termina, o próximo s é cortado
+    run.checkpoint = &first;
+    johnson_cycles(g, false, &run);
+    bool ok = run.stopped && first.save() && first.completed() > 0;
+    Checkpoint second(file, g);
+    std::string error;
+    ok = ok && second.resume(error) && second.completed() == first.completed() &&
+         second.cycles() == first.cycles();
+    omp_set_num_threads(3);
+    ok = ok && johnson_cycles_parallel_v5(g, false, &second) == expected && second.cycles() == expected;
+    check_true("checkpoint: interrompe e retoma (sequencial -> v5)", ok);
+
+    // os s ímpares concluídos, como se a v5 tivesse parado no meio
+    {
+        Checkpoint odd(file, g);
+        for (int s = 1; s < g->num_nodes; s += 2) odd.complete(s, per_s[s]);
+        ok = odd.save();
+    }
+    Checkpoint seq_resume(file, g), v5_resume(file, g);
+    JohnsonRun resumed;
+    resumed.checkpoint = &seq_resume;
+    ok = ok && seq_resume.resume(error) && v5_resume.resume(error) &&
+         johnson_cycles(g, true, &resumed) == expected &&
+         johnson_cycles_parallel_v5(g, true, &v5_resume) == expected &&
+         seq_resume.completed() == v5_resume.completed();
+    check_true("checkpoint: s concluídos fora de ordem (sequencial -c, v5 -c)", ok);
+
+    Graph other = ring(g->num_nodes, false).build();
+    Checkpoint wrong(file, other);
+    check_true("checkpoint: arquivo de outro grafo é recusado", !wrong.resume(error));
+    free_graph(other);
+    free_graph(g);
+    unlink(file);
+}
+
+// Particionamento fora da memória: com um limite pequeno de arestas por
+// parte há SCCs agrupadas e SCCs sozinhas; as SCCs cíclicas têm que ser
+// as do Multistep e a soma dos ciclos das partes a do grafo inteiro. Com
+// memory_edges = -1 tudo roda pelo arquivo; com 200 o fim é em memória.
+static void test_partition()
+{
+    char dir[] = "/tmp/test_cycles_XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        check_true("particionamento: diretório temporário", false);
+        return;
+    }
+    const std::string file = std::string(dir) + "/graph.bin";
+    for (int memory_edges : {-1, 200}) {
+        const int blocks = memory_edges < 0 ? 50 : 400;
+        EdgeList e = scc_blocks_digraph(blocks);
+        const int n = e.n;
+        std::uniform_int_distribution<int> vertex(0, n - 1);
+        for (int k = 0; k < 20; k++) {
+            const int v = vertex(rng);
+            e.add(v, v);
+        }
+        for (size_t k = 0; k < e.src.size(); k += 17) e.add(e.src[k], e.dst[k]);
+        Graph g = e.build();
+        store_graph_binary(file.c_str(), g);
+        PartitionStats stats = partition_graph_file(file.c_str(), dir, 64, memory_edges);
+
+        std::vector<int> active(n, 1);
+        SCCScratch scratch;
+        int cyclic = 0;
+        for (const std::vector<int>& scc : multistep_SCCs(g, active, 0, scratch)) {
+            bool loop = false;
+            for (const Vertex* w = outgoing_begin(g, scc[0]); w != outgoing_end(g, scc[0]); ++w)
+                loop |= *w == scc[0];
+            if (scc.size() >= 2 || loop) cyclic++;
+        }
+
+        std::vector<PartitionPart> parts;
+        bool ok = load_partition_index(dir, parts) && parts.size() == stats.parts.size();
+        Count total = 0;
+        for (const PartitionPart& part : parts) {
+            const std::string path = std::string(dir) + "/" + part.file;
+            Graph p = load_graph_binary(path.c_str());
+            ok = ok && p->num_nodes == part.nodes && p->num_edges == part.edges;
+            total += johnson_cycles(p);
+            free_graph(p);
+            unlink(path.c_str());
+        }
+        check_true(("particao fora da memoria, " + std::to_string(cyclic) + " SCCs em " +
+                    std::to_string(parts.size()) + " partes" + (stats.in_memory_finish ? " (fim em memoria)" : "")).c_str(),
+                   ok && stats.in_memory_finish == (memory_edges > 0) && stats.cyclic_sccs == cyclic && total == johnson_cycles(g));
+        free_graph(g);
+    }
+    unlink(file.c_str());
+    unlink((std::string(dir) + "/" + PARTITION_INDEX_FILE).c_str());
+    rmdir(dir);
+}
+
+// Arquivos de datasets/ (valores conferidos com o oráculo e, para os
+// completos, com a fórmula)
+static void test_datasets()
+{
+    struct Dataset { const char* file; bool binary; Count expected; };
+    const Dataset files[] = {
+        {"test1.txt.bin",           true,  2},
+        {"tiny.graph",              true,  87},
+        {"grid4x4.graph",           true,  24 + 2 * 213},
+        {"graph_8_completo.txt.bin", true, complete_cycles(8)},
+        {"graph_15.txt.bin",        true,  4980198},
+        {"texts/test.txt",          false, 2},
+        {"texts/test1.txt",         false, 2},
+    };
+    for (const Dataset& d : files) {
+        std::string path = datasets_dir + "/" + d.file;
+        Graph g = d.binary ? load_graph_binary(path.c_str()) : load_graph(path.c_str());
+        check_all_engines(d.file, g, d.expected);
+        free_graph(g);
+    }
+}
+
+struct TestArea { const char* name; void (*run)(); };
+
+static const TestArea areas[] = {
+    {"counters", test_counters},
+    {"closed_forms", test_closed_forms},
+    {"parallel_bfs", test_parallel_bfs},
+    {"grids", test_grids},
+    {"dense", test_dense},
+    {"random", test_random},
+    {"multigraphs", test_multigraphs},
+    {"multistep", test_multistep},
+    {"relabeling", test_relabeling},
+    {"library", test_library},
+    {"query_limits", test_query_limits},
+    {"progress", test_progress},
+    {"server", test_server},
+    {"targeted", test_targeted},
+    {"schedulers", test_schedulers},
+    {"numa", test_numa},
+    {"huge_pages", test_huge_pages},
+    {"checkpoint", test_checkpoint},
+    {"partition", test_partition},
+    {"datasets", test_datasets},
+};
+
+int main(int argc, char** argv)
+{
+    if (argc > 1) datasets_dir = argv[1];
+    std::set<std::string> only(argv + std::min(argc, 2), argv + argc);
+
+    unsigned seed = std::random_device{}();
+    if (const char* env = getenv("TEST_SEED")) seed = (unsigned) strtoul(env, NULL, 10);
+    rng.seed(seed);
+    printf("TEST_SEED=%u\n", seed);
+
+    for (const TestArea& area : areas) {
+        if (!only.empty() && !only.count(area.name)) continue;
+        const int failures_before = failures;
+        area.run();
+        if (failures != failures_before) printf("[%s] %d falhas\n", area.name, failures - failures_before);
+    }
+
+    printf("%d/%d checks passed (TEST_SEED=%u)\n", checks - failures, checks, seed);
+    return failures == 0 ? 0 : 1;
+}